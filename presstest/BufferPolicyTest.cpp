@@ -0,0 +1,126 @@
+﻿#include "../src/utils/TwoQueue.h"
+#include "PressTest.h"
+#include <iostream>
+#include <list>
+#include <random>
+#include <unordered_map>
+
+namespace storage {
+using namespace std;
+
+struct PolicyPage {
+  uint64_t _id;
+  bool _bRef = false;
+  bool TestAndClearReferenced() {
+    bool b = _bRef;
+    _bRef = false;
+    return b;
+  }
+};
+
+/**Simulate a buffer pool with given capacity. Get returns true if the page is
+ * in cache, or else load it and evict the pages over capacity.*/
+class PolicySimulator {
+public:
+  virtual ~PolicySimulator() {}
+  virtual bool Get(uint64_t id) = 0;
+};
+
+class LruSimulator : public PolicySimulator {
+public:
+  LruSimulator(uint64_t capacity) : _capacity(capacity) {}
+  bool Get(uint64_t id) override {
+    auto iter = _map.find(id);
+    if (iter != _map.end()) {
+      _list.splice(_list.begin(), _list, iter->second);
+      return true;
+    }
+
+    _list.push_front(id);
+    _map.insert({id, _list.begin()});
+    if (_list.size() > _capacity) {
+      _map.erase(_list.back());
+      _list.pop_back();
+    }
+    return false;
+  }
+
+protected:
+  uint64_t _capacity;
+  list<uint64_t> _list;
+  unordered_map<uint64_t, list<uint64_t>::iterator> _map;
+};
+
+class TwoQueueSimulator : public PolicySimulator {
+public:
+  TwoQueueSimulator(uint64_t capacity)
+      : _capacity(capacity), _twoQueue(capacity) {}
+  ~TwoQueueSimulator() {
+    for (auto &pr : _map) {
+      delete pr.second;
+    }
+  }
+  bool Get(uint64_t id) override {
+    auto iter = _map.find(id);
+    if (iter != _map.end()) {
+      iter->second->_bRef = true;
+      return true;
+    }
+
+    PolicyPage *page = new PolicyPage{id};
+    _map.insert({id, page});
+    _twoQueue.Push(page, id);
+    if (_twoQueue.Size() > _capacity) {
+      _twoQueue.Evict(_twoQueue.Size() - _capacity, [this](PolicyPage *p) {
+        _map.erase(p->_id);
+        delete p;
+        return true;
+      });
+    }
+    return false;
+  }
+
+protected:
+  uint64_t _capacity;
+  TwoQueue<PolicyPage *> _twoQueue;
+  unordered_map<uint64_t, PolicyPage *> _map;
+};
+
+/**Mixed point lookups and sequential scans. The point lookups visit a hot set
+ * that is half of the cache, the scans read pages that are never visited by
+ * lookups and cover 4 times of the cache, one scan page after every lookup.
+ * Print the hit ratio of point lookups and all visits for LRU and 2Q.*/
+void BufferPolicyTest(uint64_t cachePages) {
+  if (cachePages == 0)
+    cachePages = 10000;
+  const uint64_t hotPages = cachePages / 2;
+  const uint64_t scanPages = cachePages * 4;
+  const uint64_t rounds = scanPages * 5;
+
+  LruSimulator lru(cachePages);
+  TwoQueueSimulator tq(cachePages);
+  PolicySimulator *sims[] = {&lru, &tq};
+  const char *names[] = {"LRU", "2Q"};
+
+  cout << "Cache pages=" << cachePages << "  hot pages=" << hotPages
+       << "  scan pages=" << scanPages << "  lookups=" << rounds << endl;
+  cout << "Policy\tLookupHit\tTotalHit" << endl;
+  for (int s = 0; s < 2; s++) {
+    mt19937_64 rnd(1);
+    uint64_t lookupHit = 0;
+    uint64_t scanHit = 0;
+    // Warm up the hot set before the scans start
+    for (uint64_t i = 0; i < hotPages * 4; i++) {
+      sims[s]->Get(rnd() % hotPages);
+    }
+
+    for (uint64_t i = 0; i < rounds; i++) {
+      lookupHit += sims[s]->Get(rnd() % hotPages) ? 1 : 0;
+      scanHit += sims[s]->Get(hotPages + i % scanPages) ? 1 : 0;
+    }
+
+    cout << names[s] << "\t" << (double)lookupHit * 100 / rounds << "%\t"
+         << (double)(lookupHit + scanHit) * 100 / (rounds * 2) << "%" << endl;
+  }
+}
+} // namespace storage
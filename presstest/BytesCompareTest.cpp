@@ -0,0 +1,73 @@
+﻿#include "../src/utils/BytesFuncs.h"
+#include "PressTest.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace storage {
+using namespace std;
+
+template <class Func>
+static double CompareSpeed(Func func, const Byte *bys1, const Byte *bys2,
+                           size_t len, uint64_t count) {
+  int64_t sum = 0;
+  auto st = chrono::steady_clock::now();
+  for (uint64_t i = 0; i < count; i++) {
+    // Swap the buffers by turns so the call can not be hoisted out.
+    sum += (i & 1) ? func(bys1, bys2, len) : func(bys2, bys1, len);
+  }
+  auto et = chrono::steady_clock::now();
+  double sec = chrono::duration<double>(et - st).count();
+  // Print the sum to avoid the loop being optimized away.
+  if (sum == 1)
+    cout << " ";
+  return sec * 1000000000 / count;
+}
+
+/**Compare the time of memcmp, the 8 bytes words compare, SSE2 and AVX2 for
+ * key lengths from 4 to 512 bytes. The two buffers are equal except the last
+ * byte, it is the worst case of a key compare. count is how many times will
+ * be compared for every algorithm and length.*/
+void BytesCompareTest(uint64_t count) {
+  if (count == 0)
+    count = 10000000;
+  const size_t keyLens[] = {4, 8, 16, 24, 32, 48, 64, 128, 256, 512};
+
+  vector<Byte> buf1(512);
+  mt19937 rnd(1);
+  for (Byte &b : buf1) {
+    b = (Byte)rnd();
+  }
+
+  auto memFunc = [](const Byte *bys1, const Byte *bys2, size_t len) -> int {
+    return memcmp(bys1, bys2, len);
+  };
+  auto inlineFunc = [](const Byte *bys1, const Byte *bys2,
+                       size_t len) -> int {
+    return BytesCompare(bys1, len, bys2, len);
+  };
+
+  bool bAvx2 = IsBytesCompareAvx2();
+  cout << "Bytes compare time(ns), count=" << count
+       << " for every case, AVX2=" << (bAvx2 ? "yes" : "no") << endl;
+  cout << "KeyLen\tmemcmp\tWord8\tSSE2\tAVX2\tBytesCompare" << endl;
+  for (size_t len : keyLens) {
+    vector<Byte> buf2(buf1);
+    buf2[len - 1] ^= 1;
+
+    const Byte *bys1 = buf1.data();
+    const Byte *bys2 = buf2.data();
+    double mem = CompareSpeed(memFunc, bys1, bys2, len, count);
+    double sw = CompareSpeed(BytesCompareSoftware, bys1, bys2, len, count);
+    double sse = CompareSpeed(BytesCompareSse2, bys1, bys2, len, count);
+    double avx =
+        bAvx2 ? CompareSpeed(BytesCompareAvx2, bys1, bys2, len, count) : 0;
+    double cmp = CompareSpeed(inlineFunc, bys1, bys2, len, count);
+    cout.precision(2);
+    cout << fixed << len << "\t" << mem << "\t" << sw << "\t" << sse << "\t"
+         << avx << "\t" << cmp << endl;
+  }
+}
+} // namespace storage
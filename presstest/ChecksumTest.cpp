@@ -0,0 +1,69 @@
+﻿#include "../src/utils/Crc32c.h"
+#include "PressTest.h"
+#include <boost/crc.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace storage {
+using namespace std;
+
+template <class Func>
+static double ChecksumSpeed(Func func, const Byte *bys, uint32_t pageSize,
+                            uint64_t totalBytes) {
+  uint64_t count = totalBytes / pageSize;
+  uint32_t sum = 0;
+  auto st = chrono::steady_clock::now();
+  for (uint64_t i = 0; i < count; i++) {
+    sum += func(bys, pageSize);
+  }
+  auto et = chrono::steady_clock::now();
+  double sec = chrono::duration<double>(et - st).count();
+  // Print the sum to avoid the loop being optimized away.
+  if (sum == 1)
+    cout << " ";
+  return (double)(count * pageSize) / (1024 * 1024) / sec;
+}
+
+/**Compare the throughput of legacy CRC32 (boost), CRC32C by slicing-by-8 and
+ * CRC32C by SSE4.2 instruction for different page sizes. totalMb is how many
+ * megabytes will be calculated for every algorithm and page size.*/
+void ChecksumTest(uint64_t totalMb) {
+  if (totalMb == 0)
+    totalMb = 1024;
+  uint64_t totalBytes = totalMb * 1024 * 1024;
+  const uint32_t pageSizes[] = {4096, 8192, 16384, 32768, 65536};
+
+  vector<Byte> buf(65536);
+  mt19937 rnd(1);
+  for (Byte &b : buf) {
+    b = (Byte)rnd();
+  }
+
+  auto crc32Func = [](const Byte *bys, uint32_t len) -> uint32_t {
+    boost::crc_32_type crc;
+    crc.process_bytes(bys, len);
+    return crc.checksum();
+  };
+  auto swFunc = [](const Byte *bys, uint32_t len) -> uint32_t {
+    return Crc32cSoftware(bys, len);
+  };
+  auto hwFunc = [](const Byte *bys, uint32_t len) -> uint32_t {
+    return Crc32cHardware(bys, len);
+  };
+
+  bool bHw = IsCrc32cHardware();
+  cout << "Checksum throughput(MB/s), total=" << totalMb
+       << "MB for every case, hardware CRC32C=" << (bHw ? "yes" : "no")
+       << endl;
+  cout << "PageSize\tCRC32\tCRC32C-sw\tCRC32C-hw" << endl;
+  for (uint32_t ps : pageSizes) {
+    double crc32 = ChecksumSpeed(crc32Func, buf.data(), ps, totalBytes);
+    double sw = ChecksumSpeed(swFunc, buf.data(), ps, totalBytes);
+    double hw = bHw ? ChecksumSpeed(hwFunc, buf.data(), ps, totalBytes) : 0;
+    cout << ps << "\t" << (uint64_t)crc32 << "\t" << (uint64_t)sw << "\t"
+         << (uint64_t)hw << endl;
+  }
+}
+} // namespace storage
@@ -0,0 +1,124 @@
+﻿#include "../src/cache/CachePool.h"
+#include "../src/config/Configure.h"
+#include "../src/file/PageFile.h"
+#include "../src/utils/Utilitys.h"
+#include "PressTest.h"
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <sys/mman.h>
+
+namespace storage {
+using namespace std;
+// Drop the file from OS page cache, so every read will go to disk.
+static void DropCache(const string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(fd);
+}
+
+// The bytes of this file that are resident in OS page cache.
+static uint64_t PageCacheResident(const string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return 0;
+  uint64_t len = std::filesystem::file_size(path);
+  void *addr = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    ::close(fd);
+    return 0;
+  }
+
+  uint64_t osPage = sysconf(_SC_PAGESIZE);
+  vector<unsigned char> vct((len + osPage - 1) / osPage);
+  uint64_t count = 0;
+  if (mincore(addr, len, vct.data()) == 0) {
+    for (unsigned char c : vct)
+      count += (c & 1);
+  }
+
+  munmap(addr, len);
+  ::close(fd);
+  return count * osPage;
+}
+
+static void RunDirectIoRead(const string &path, uint64_t pageCount,
+                            bool bDirect) {
+  uint32_t pageLen = (uint32_t)Configure::GetCachePageSize();
+  DropCache(path);
+  PageFile pf(path, bDirect);
+  if (bDirect && !pf.IsDirect()) {
+    cout << "Direct I/O is not supported by this file system." << endl;
+    return;
+  }
+
+  // Keep all pages in memory as PageBufferPool does.
+  vector<Byte *> vctPage(pageCount);
+  vector<uint64_t> vctId(pageCount);
+  for (uint64_t i = 0; i < pageCount; i++)
+    vctId[i] = i;
+  shuffle(vctId.begin(), vctId.end(), mt19937_64(1));
+
+  vector<uint64_t> vctLatency;
+  vctLatency.reserve(pageCount);
+  chrono::steady_clock::time_point st = chrono::steady_clock::now();
+  for (uint64_t id : vctId) {
+    Byte *bys = CachePool::ApplyPage();
+    chrono::steady_clock::time_point rs = chrono::steady_clock::now();
+    pf.ReadPage(id * pageLen, (char *)bys, pageLen);
+    vctLatency.push_back(chrono::duration_cast<chrono::nanoseconds>(
+                             chrono::steady_clock::now() - rs)
+                             .count());
+    vctPage[id] = bys;
+  }
+  uint64_t us = chrono::duration_cast<chrono::microseconds>(
+                    chrono::steady_clock::now() - st)
+                    .count();
+
+  sort(vctLatency.begin(), vctLatency.end());
+  uint64_t total = 0;
+  for (uint64_t l : vctLatency)
+    total += l;
+
+  uint64_t cached = PageCacheResident(path);
+  cout << (bDirect ? "O_DIRECT " : "Buffered ") << "Time(ms):" << us / 1000
+       << "\tAvg(us):" << total / pageCount / 1000
+       << "\tP50(us):" << vctLatency[pageCount / 2] / 1000
+       << "\tP99(us):" << vctLatency[pageCount * 99 / 100] / 1000
+       << "\tBufferPool(MB):" << pageCount * pageLen / (1024 * 1024)
+       << "\tPageCache(MB):" << cached / (1024 * 1024) << endl;
+
+  for (Byte *bys : vctPage)
+    CachePool::ReleasePage(bys);
+}
+
+void DirectIoReadTest(uint64_t pageCount) {
+  const string FILE_NAME = "./dbTest/testDirectIo" + StrMSTime() + ".dat";
+  if (pageCount < 1000)
+    pageCount = 16 * 1024;
+
+  uint32_t pageLen = (uint32_t)Configure::GetCachePageSize();
+  {
+    PageFile pf(FILE_NAME, false);
+    Byte *bys = CachePool::ApplyPage();
+    for (uint64_t i = 0; i < pageCount; i++) {
+      memset(bys, (int)i, pageLen);
+      pf.WritePage(i * pageLen, (char *)bys, pageLen);
+    }
+    CachePool::ReleasePage(bys);
+  }
+
+  cout << "Cold read all pages once, pages=" << pageCount
+       << "  size(MB)=" << pageCount * pageLen / (1024 * 1024) << endl;
+  RunDirectIoRead(FILE_NAME, pageCount, false);
+  RunDirectIoRead(FILE_NAME, pageCount, true);
+
+  std::filesystem::remove(std::filesystem::path(FILE_NAME));
+}
+} // namespace storage
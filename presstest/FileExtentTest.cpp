@@ -0,0 +1,81 @@
+﻿#include "../src/cache/CachePool.h"
+#include "../src/config/Configure.h"
+#include "../src/file/PageFile.h"
+#include "../src/utils/Utilitys.h"
+#include "PressTest.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace storage {
+using namespace std;
+
+// Append pages one by one, if bExtent, preallocate the file by extents like
+// HeadPage does, or the file grows by every write past the end.
+static void RunExtentWrite(const string &path, uint64_t pageCount,
+                           bool bExtent) {
+  uint32_t pageLen = (uint32_t)Configure::GetCachePageSize();
+  uint64_t extent = max(Configure::GetMinExtentPages(), 1U);
+  uint64_t allocated = 0;
+  uint64_t allocUs = 0;
+  bool bSupported = true;
+
+  PageFile pf(path, true);
+  Byte *bys = CachePool::ApplyPage();
+  vector<uint64_t> vctLatency;
+  vctLatency.reserve(pageCount);
+  chrono::steady_clock::time_point st = chrono::steady_clock::now();
+  for (uint64_t i = 0; i < pageCount; i++) {
+    if (bExtent && bSupported && i + extent / 2 >= allocated) {
+      // It is done by a task in HeadPage, so not counted into write latency.
+      chrono::steady_clock::time_point as = chrono::steady_clock::now();
+      bSupported = pf.Allocate(allocated * pageLen, extent * pageLen);
+      allocated += extent;
+      extent = min(extent * 2, (uint64_t)Configure::GetMaxExtentPages());
+      allocUs += chrono::duration_cast<chrono::microseconds>(
+                     chrono::steady_clock::now() - as)
+                     .count();
+    }
+
+    memset(bys, (int)i, pageLen);
+    chrono::steady_clock::time_point ws = chrono::steady_clock::now();
+    pf.WritePage(i * pageLen, (char *)bys, pageLen);
+    vctLatency.push_back(chrono::duration_cast<chrono::nanoseconds>(
+                             chrono::steady_clock::now() - ws)
+                             .count());
+  }
+  uint64_t us = chrono::duration_cast<chrono::microseconds>(
+                    chrono::steady_clock::now() - st)
+                    .count();
+  CachePool::ReleasePage(bys);
+
+  sort(vctLatency.begin(), vctLatency.end());
+  uint64_t total = 0;
+  for (uint64_t l : vctLatency)
+    total += l;
+
+  cout << (bExtent ? "Extents" : "PageByPage")
+       << (pf.IsDirect() ? "(direct)" : "") << "\tTime(ms):" << us / 1000
+       << "\tAvg(us):" << total / pageCount / 1000
+       << "\tP50(us):" << vctLatency[pageCount / 2] / 1000
+       << "\tP99(us):" << vctLatency[pageCount * 99 / 100] / 1000
+       << "\tMax(us):" << vctLatency.back() / 1000
+       << "\tAllocate(ms):" << allocUs / 1000 << endl;
+  if (bExtent && !bSupported)
+    cout << "Preallocation is not supported by this file system." << endl;
+}
+
+void FileExtentWriteTest(uint64_t pageCount) {
+  if (pageCount < 1000)
+    pageCount = 16 * 1024;
+
+  cout << "Append pages into a new file, pages=" << pageCount << "  size(MB)="
+       << pageCount * Configure::GetCachePageSize() / (1024 * 1024) << endl;
+  for (bool bExtent : {false, true}) {
+    const string FILE_NAME = "./dbTest/testFileExtent" + StrMSTime() + ".dat";
+    RunExtentWrite(FILE_NAME, pageCount, bExtent);
+    std::filesystem::remove(std::filesystem::path(FILE_NAME));
+  }
+}
+} // namespace storage
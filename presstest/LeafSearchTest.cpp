@@ -0,0 +1,142 @@
+﻿#include "../src/core/IndexTree.h"
+#include "../src/core/LeafPage.h"
+#include "../src/dataType/DataValueDigit.h"
+#include "../src/pool/PageBufferPool.h"
+#include "../src/pool/PageDividePool.h"
+#include "../src/pool/StoragePool.h"
+#include "../src/utils/Utilitys.h"
+#include "PressTest.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+namespace storage {
+using namespace std;
+
+static const uint32_t LEAF_SEARCH_FILE_ID = 5200;
+static const char *LEAF_SEARCH_TABLE_NAME = "testTable";
+
+/**Search random keys one by one. With bLoad, every leaf loads all its records
+ * before search and cleans them after, as a search on a cold page did when
+ * it created LeafRecord for every slot.
+ * @param records Return how many LeafRecord have been created.
+ * @return The nanoseconds per lookup.*/
+static double LeafLookup(IndexTree *indexTree, uint64_t rowCount,
+                         uint64_t lookupCount, bool bLoad, uint64_t &records) {
+  mt19937_64 rnd(0);
+  VectorDataValue vctKey = {new DataValueLong(0LL)};
+  records = 0;
+  uint64_t found = 0;
+
+  auto st = chrono::steady_clock::now();
+  for (uint64_t i = 0; i < lookupCount; i++) {
+    *((DataValueLong *)vctKey[0]) = (int64_t)(rnd() % rowCount);
+    RawKey key(vctKey);
+    IndexPage *idp = nullptr;
+    indexTree->SearchRecursively(key, bLoad, idp, true);
+    LeafPage *lp = (LeafPage *)idp;
+    if (bLoad) {
+      lp->LoadRecords();
+      records += lp->GetRecordNumber();
+    }
+
+    bool bFind;
+    int32_t pos = lp->SearchKey(key, bFind);
+    if (bFind) {
+      LeafRecord *lr = lp->GetRecord(pos);
+      if (!bLoad)
+        records++;
+      lr->DecRef();
+      found++;
+    }
+
+    if (bLoad) {
+      lp->CleanRecord();
+      lp->WriteUnlock();
+    } else {
+      lp->ReadUnlock();
+    }
+    lp->DecRef();
+  }
+
+  double ns =
+      (double)chrono::duration_cast<chrono::nanoseconds>(
+          chrono::steady_clock::now() - st)
+          .count();
+  if (found != lookupCount)
+    cout << "Only found " << found << " of " << lookupCount << endl;
+  return ns / lookupCount;
+}
+
+/**Bulk load an index tree, then compare the random point lookups that search
+ * the leaf on page bytes with the lookups that create all records of the
+ * leaf first.*/
+void LeafSearchTest(uint64_t rowCount, uint64_t lookupCount) {
+  if (rowCount < 10000)
+    rowCount = 1000000;
+  if (lookupCount == 0)
+    lookupCount = 1000000;
+
+  ThreadPool *tp = ThreadPool::InitMain();
+  TimerThread::Start();
+  StoragePool::InitPool(tp);
+  StoragePool::AddTimerTask();
+  PageDividePool::InitPool(tp);
+  PageDividePool::AddTimerTask();
+  PageBufferPool::InitPool(tp);
+  PageBufferPool::AddTimerTask();
+
+  const string FILE_NAME = "./dbTest/testLeafSearch" + StrMSTime() + ".dat";
+  DataValueLong *dvKey = new DataValueLong(0LL);
+  DataValueLong *dvVal = new DataValueLong(0LL);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(LEAF_SEARCH_TABLE_NAME, FILE_NAME.c_str(), vctKey,
+                         vctVal, LEAF_SEARCH_FILE_ID, IndexType::PRIMARY);
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  uint64_t idx = 0;
+  indexTree->BulkLoad(
+      [&]() -> LeafRecord * {
+        if (idx >= rowCount)
+          return nullptr;
+        *((DataValueLong *)vctKey[0]) = (int64_t)idx;
+        *((DataValueLong *)vctVal[0]) = (int64_t)idx;
+        idx++;
+        return new LeafRecord(indexTree, vctKey, vctVal, 0, nullptr);
+      },
+      IndexPage::LOAD_FACTOR);
+
+  // Read all pages into memory before measure.
+  uint64_t records;
+  LeafLookup(indexTree, rowCount, rowCount / 10, false, records);
+  cout << "Rows:" << rowCount << "\tPages:"
+       << indexTree->GetHeadPage()->ReadTotalPageCount()
+       << "\tLookups:" << lookupCount << endl;
+  cout << "Mode\tns/lookup\tRecords/lookup" << endl;
+  // With CACHE_TRACE every allocation saves a stack trace, so limit the
+  // lookups that create records or this mode will run for hours.
+  uint64_t loadCount = min(lookupCount, (uint64_t)1000);
+  double ns = LeafLookup(indexTree, rowCount, loadCount, true, records);
+  cout << "Records\t" << ns << "\t" << (double)records / loadCount << endl;
+  double ns2 = LeafLookup(indexTree, rowCount, lookupCount, false, records);
+  cout << "Bytes\t" << ns2 << "\t" << (double)records / lookupCount << endl;
+  cout << "Speedup:" << ns / ns2 << endl;
+
+  IndexTree::TestCloseWait(indexTree);
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+  TimerThread::Stop();
+  ThreadPool::StopMain();
+  PageDividePool::StopPool();
+  StoragePool::StopPool();
+  PageBufferPool::StopPool();
+
+  delete dvKey;
+  delete dvVal;
+  filesystem::remove(FILE_NAME);
+}
+} // namespace storage
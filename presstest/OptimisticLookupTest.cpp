@@ -0,0 +1,132 @@
+﻿#include "../src/core/IndexTree.h"
+#include "../src/core/LeafPage.h"
+#include "../src/dataType/DataValueDigit.h"
+#include "../src/pool/PageBufferPool.h"
+#include "../src/pool/PageDividePool.h"
+#include "../src/pool/StoragePool.h"
+#include "../src/utils/Utilitys.h"
+#include "PressTest.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace storage {
+using namespace std;
+
+static const uint32_t OPTIMISTIC_FILE_ID = 5100;
+static const char *OPTIMISTIC_TABLE_NAME = "testTable";
+static const uint64_t LOOKUP_MS = 2000;
+
+// Search random keys by threadCount threads for LOOKUP_MS, return the lookups
+// per second of all threads.
+static double ParallelLookup(IndexTree *indexTree, uint64_t rowCount,
+                             int threadCount) {
+  atomic_bool bStop{false};
+  atomic<uint64_t> total{0};
+  MVector<thread> vctThread;
+  for (int i = 0; i < threadCount; i++) {
+    vctThread.emplace_back([indexTree, rowCount, i, &bStop, &total]() {
+      mt19937_64 rnd(i);
+      VectorDataValue vctKey = {new DataValueLong(0LL)};
+      uint64_t count = 0;
+      while (!bStop.load(memory_order_relaxed)) {
+        *((DataValueLong *)vctKey[0]) = (int64_t)(rnd() % rowCount);
+        RawKey key(vctKey);
+        IndexPage *idp = nullptr;
+        indexTree->SearchRecursively(key, false, idp, true);
+        bool bFind;
+        ((LeafPage *)idp)->SearchKey(key, bFind);
+        idp->ReadUnlock();
+        idp->DecRef();
+        count++;
+      }
+      total.fetch_add(count);
+    });
+  }
+
+  auto st = chrono::steady_clock::now();
+  this_thread::sleep_for(chrono::milliseconds(LOOKUP_MS));
+  bStop.store(true);
+  for (thread &t : vctThread) {
+    t.join();
+  }
+  double sec = chrono::duration<double>(chrono::steady_clock::now() - st)
+                   .count();
+  return total.load() / sec;
+}
+
+/**Build an index tree that fits in PageBufferPool, then compare the random
+ * point lookups with locked and optimistic branch page reads by 1, 2, 4 ...
+ * threadCount threads.*/
+void OptimisticLookupTest(int threadCount, uint64_t rowCount) {
+  if (threadCount <= 0)
+    threadCount = (int)thread::hardware_concurrency();
+  if (rowCount < 10000)
+    rowCount = 1000000;
+
+  ThreadPool *tp = ThreadPool::InitMain();
+  TimerThread::Start();
+  StoragePool::InitPool(tp);
+  StoragePool::AddTimerTask();
+  PageDividePool::InitPool(tp);
+  PageDividePool::AddTimerTask();
+  PageBufferPool::InitPool(tp);
+  PageBufferPool::AddTimerTask();
+
+  const string FILE_NAME =
+      "./dbTest/testOptimisticLookup" + StrMSTime() + ".dat";
+  DataValueLong *dvKey = new DataValueLong(0LL);
+  DataValueLong *dvVal = new DataValueLong(0LL);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(OPTIMISTIC_TABLE_NAME, FILE_NAME.c_str(), vctKey,
+                         vctVal, OPTIMISTIC_FILE_ID, IndexType::PRIMARY);
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  for (uint64_t i = 0; i < rowCount; i++) {
+    *((DataValueLong *)vctKey[0]) = (int64_t)i;
+    *((DataValueLong *)vctVal[0]) = (int64_t)i;
+    LeafRecord *rr =
+        new LeafRecord(indexTree, vctKey, vctVal,
+                       indexTree->GetHeadPage()->ReadRecordStamp(), nullptr);
+    IndexPage *idxPage = nullptr;
+    indexTree->SearchRecursively(*rr, true, idxPage, true);
+    ((LeafPage *)idxPage)->InsertRecord(rr, false);
+    PageDividePool::AddPage(idxPage, false);
+    idxPage->WriteUnlock();
+  }
+
+  // Load all pages before measure.
+  ParallelLookup(indexTree, rowCount, 1);
+  cout << "Rows:" << rowCount << "\tPages:"
+       << indexTree->GetHeadPage()->ReadTotalPageCount() << endl;
+  cout << "Threads\tLocked(/s)\tOptimistic(/s)\tSpeedup" << endl;
+  for (int n = 1; n <= threadCount; n *= 2) {
+    indexTree->SetOptimisticSearch(false);
+    double locked = ParallelLookup(indexTree, rowCount, n);
+    indexTree->SetOptimisticSearch(true);
+    double optimistic = ParallelLookup(indexTree, rowCount, n);
+    cout << n << "\t" << (uint64_t)locked << "\t" << (uint64_t)optimistic
+         << "\t" << optimistic / locked << endl;
+    if (n < threadCount && n * 2 > threadCount)
+      n = threadCount / 2;
+  }
+
+  IndexTree::TestCloseWait(indexTree);
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+  TimerThread::Stop();
+  ThreadPool::StopMain();
+  PageDividePool::StopPool();
+  StoragePool::StopPool();
+  PageBufferPool::StopPool();
+
+  delete dvKey;
+  delete dvVal;
+  filesystem::remove(FILE_NAME);
+}
+} // namespace storage
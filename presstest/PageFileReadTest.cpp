@@ -0,0 +1,154 @@
+﻿#include "../src/config/Configure.h"
+#include "../src/file/PageFile.h"
+#include "../src/utils/SpinMutex.h"
+#include "../src/utils/Utilitys.h"
+#include "PressTest.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <thread>
+
+namespace storage {
+using namespace std;
+// The number of fstreams that the old IndexTree::ApplyPageFile kept per file.
+static const uint32_t OLD_MAX_PAGE_FILE_COUNT = 5;
+
+// Emulate the old per tree queue of fstream handles, every handle has its own
+// seek position, so a thread must apply a handle before reading.
+class FstreamQueue {
+public:
+  FstreamQueue(const string &path) : _path(path) {}
+  ~FstreamQueue() {
+    while (_queue.size() > 0) {
+      delete _queue.front();
+      _queue.pop();
+    }
+  }
+
+  fstream *Apply() {
+    while (true) {
+      unique_lock<SpinMutex> lock(_mutex);
+      _cv.wait_for(lock, 1ms,
+                   [this] { return _count < OLD_MAX_PAGE_FILE_COUNT; });
+      if (_queue.size() > 0) {
+        fstream *fs = _queue.front();
+        _queue.pop();
+        return fs;
+      } else if (_count < OLD_MAX_PAGE_FILE_COUNT) {
+        _count++;
+        return new fstream(_path, ios::in | ios::out | ios::binary);
+      }
+    }
+  }
+
+  void Release(fstream *fs) {
+    lock_guard<SpinMutex> lock(_mutex);
+    _queue.push(fs);
+  }
+
+protected:
+  string _path;
+  queue<fstream *> _queue;
+  SpinMutex _mutex;
+  condition_variable_any _cv;
+  uint32_t _count = 0;
+};
+
+// Drop the file from OS page cache, so every read will go to disk.
+static void DropFileCache(const string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(fd);
+}
+
+template <class F>
+static uint64_t RunReadThreads(int threadCount, uint64_t pageCount,
+                               uint64_t readsPerThread, F func) {
+  atomic<uint64_t> totalRead{0};
+  chrono::system_clock::time_point st = chrono::system_clock::now();
+
+  vector<thread> vctThread;
+  for (int t = 0; t < threadCount; t++) {
+    vctThread.emplace_back([&, t]() {
+      uint32_t pageLen = (uint32_t)Configure::GetCachePageSize();
+      char *buf = new char[pageLen];
+      mt19937_64 rnd(t + 1);
+      for (uint64_t i = 0; i < readsPerThread; i++) {
+        uint64_t offset = (rnd() % pageCount) * pageLen;
+        func(offset, buf, pageLen);
+      }
+      totalRead.fetch_add(readsPerThread, memory_order_relaxed);
+      delete[] buf;
+    });
+  }
+  for (thread &t : vctThread)
+    t.join();
+
+  chrono::system_clock::time_point et = chrono::system_clock::now();
+  return chrono::duration_cast<chrono::microseconds>(et - st).count();
+}
+
+void PageFileConcurrentReadTest(int threadCount, uint64_t pageCount) {
+  const string FILE_NAME = "./dbTest/testPageFileRead" + StrMSTime() + ".dat";
+  if (threadCount < 1 || threadCount > 256)
+    threadCount = 16;
+  if (pageCount < 1000)
+    pageCount = 16 * 1024;
+
+  uint32_t pageLen = (uint32_t)Configure::GetCachePageSize();
+  uint64_t readsPerThread = pageCount / threadCount;
+
+  {
+    PageFile pf(FILE_NAME);
+    char *buf = new char[pageLen];
+    for (uint64_t i = 0; i < pageCount; i++) {
+      memset(buf, (int)i, pageLen);
+      pf.WritePage(i * pageLen, buf, pageLen);
+    }
+    delete[] buf;
+  }
+  cout << "Cold read test, threads=" << threadCount << "  pages=" << pageCount
+       << "  readsPerThread=" << readsPerThread << endl;
+
+  DropFileCache(FILE_NAME);
+  {
+    FstreamQueue fq(FILE_NAME);
+    uint64_t us = RunReadThreads(
+        threadCount, pageCount, readsPerThread,
+        [&fq](uint64_t offset, char *buf, uint32_t len) {
+          fstream *fs = fq.Apply();
+          fs->seekg(offset, ios::beg);
+          fs->read(buf, len);
+          fq.Release(fs);
+        });
+    cout << "fstream queue(" << OLD_MAX_PAGE_FILE_COUNT
+         << " handles)  Time(ms):" << us / 1000 << "\tPages/s:"
+         << readsPerThread * threadCount * 1000000 / (us == 0 ? 1 : us)
+         << endl;
+  }
+
+  DropFileCache(FILE_NAME);
+  {
+    PageFile pf(FILE_NAME);
+    uint64_t us = RunReadThreads(
+        threadCount, pageCount, readsPerThread,
+        [&pf](uint64_t offset, char *buf, uint32_t len) {
+          pf.ReadPage(offset, buf, len);
+        });
+    cout << "shared PageFile(pread)  Time(ms):" << us / 1000 << "\tPages/s:"
+         << readsPerThread * threadCount * 1000000 / (us == 0 ? 1 : us)
+         << endl;
+  }
+
+  std::filesystem::remove(std::filesystem::path(FILE_NAME));
+}
+} // namespace storage
@@ -0,0 +1,94 @@
+﻿#include "../src/pool/PageTable.h"
+#include "../src/utils/ConcurrentHashMap.h"
+#include "PressTest.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace storage {
+using namespace std;
+
+struct LookupItem {
+  void IncRef() { _refCount.fetch_add(1, memory_order_relaxed); }
+  void DecRef() { _refCount.fetch_sub(1, memory_order_relaxed); }
+  atomic<int32_t> _refCount{1};
+};
+
+// Run func(threadIndex, count) in threads and return lookups per second.
+template <class Func>
+static double LookupSpeed(int threadCount, uint64_t lookups, Func func) {
+  vector<thread> vct;
+  auto st = chrono::steady_clock::now();
+  for (int i = 0; i < threadCount; i++) {
+    vct.emplace_back([&func, i, lookups]() { func(i, lookups); });
+  }
+  for (thread &t : vct) {
+    t.join();
+  }
+  auto et = chrono::steady_clock::now();
+  double sec = chrono::duration<double>(et - st).count();
+  return (double)lookups * threadCount / sec;
+}
+
+/**Compare the lookup throughput of ConcurrentHashMap with 100 groups, which
+ * was used by PageBufferPool, and the optimistic PageTable. Every thread
+ * looks up random pages from pageCount pages, all pages are found.*/
+void PageTableLookupTest(int threadCount, uint64_t pageCount) {
+  if (threadCount <= 0)
+    threadCount = thread::hardware_concurrency();
+  if (pageCount == 0)
+    pageCount = 100000;
+  const uint64_t lookups = 2000000;
+
+  vector<LookupItem> vctItem(pageCount);
+  ConcurrentHashMap<uint64_t, LookupItem *, true> mapCache(
+      100, pageCount, [](LookupItem *item) { item->IncRef(); },
+      [](LookupItem *item) { item->DecRef(); });
+  PageTable<LookupItem> pageTable(pageCount);
+  for (uint64_t i = 0; i < pageCount; i++) {
+    // The same format as CachePage::CalcHashCode, file id and page id
+    uint64_t key = (1ULL << 32) | i;
+    mapCache.Insert(key, &vctItem[i]);
+    pageTable.Insert(key, &vctItem[i]);
+    vctItem[i].IncRef();
+  }
+
+  auto mapFunc = [&mapCache, pageCount](int idx, uint64_t count) {
+    uint64_t r = idx * 0x9E3779B97F4A7C15ULL + 1;
+    for (uint64_t i = 0; i < count; i++) {
+      r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+      LookupItem *item = nullptr;
+      mapCache.Find((1ULL << 32) | ((r >> 33) % pageCount), item);
+      item->DecRef();
+    }
+  };
+  auto tableFunc = [&pageTable, pageCount](int idx, uint64_t count) {
+    uint64_t r = idx * 0x9E3779B97F4A7C15ULL + 1;
+    for (uint64_t i = 0; i < count; i++) {
+      r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+      LookupItem *item =
+          pageTable.Find((1ULL << 32) | ((r >> 33) % pageCount));
+      item->DecRef();
+    }
+  };
+
+  cout << "Pages=" << pageCount << "  lookups per thread=" << lookups << endl;
+  cout << "Threads\tConcurrentHashMap(M/s)\tPageTable(M/s)" << endl;
+  vector<int> vctThreads;
+  for (int tc = 1; tc < threadCount; tc *= 2) {
+    vctThreads.push_back(tc);
+  }
+  vctThreads.push_back(threadCount);
+
+  for (int tc : vctThreads) {
+    double mapSpeed = LookupSpeed(tc, lookups, mapFunc);
+    double tableSpeed = LookupSpeed(tc, lookups, tableFunc);
+    cout << tc << "\t" << mapSpeed / 1000000 << "\t" << tableSpeed / 1000000
+         << endl;
+  }
+
+  mapCache.Clear();
+  pageTable.Clear();
+}
+} // namespace storage
@@ -44,6 +44,18 @@ int main(int argc, char *argv[]) {
     storage::ArrayTest();
   } else if (str == "1") {
     storage::MutexTest();
+  } else if (str == "2") {
+    storage::ChecksumTest(argc >= 3 ? atoll(argv[2]) : 0);
+  } else if (str == "3") {
+    storage::BufferPolicyTest(argc >= 3 ? atoll(argv[2]) : 0);
+  } else if (str == "4") {
+    int threadNum = argc >= 3 ? atol(argv[2]) : 0;
+    uint64_t pageNum = argc >= 4 ? atoll(argv[3]) : 0;
+    storage::PageTableLookupTest(threadNum, pageNum);
+  } else if (str == "5") {
+    storage::WarmupRestartTest(argc >= 3 ? atoll(argv[2]) : 0);
+  } else if (str == "6") {
+    storage::BytesCompareTest(argc >= 3 ? atoll(argv[2]) : 0);
   } else if (str == "11") {
     storage::InsertSpeedPrimaryTest(argc >= 3 ? atol(argv[2]) : 0);
   } else if (str == "12") {
@@ -54,6 +66,22 @@ int main(int argc, char *argv[]) {
     int threadNum = argc >= 3 ? atol(argv[2]) : 0;
     uint64_t recordNum = argc >= 4 ? atoll(argv[3]) : 0;
     storage::MultiThreadInsertSpeedPrimaryTest(threadNum, recordNum);
+  } else if (str == "22") {
+    int threadNum = argc >= 3 ? atol(argv[2]) : 0;
+    uint64_t rowCount = argc >= 4 ? atoll(argv[3]) : 0;
+    storage::OptimisticLookupTest(threadNum, rowCount);
+  } else if (str == "23") {
+    uint64_t rowCount = argc >= 3 ? atoll(argv[2]) : 0;
+    uint64_t lookupCount = argc >= 4 ? atoll(argv[3]) : 0;
+    storage::LeafSearchTest(rowCount, lookupCount);
+  } else if (str == "31") {
+    int threadNum = argc >= 3 ? atol(argv[2]) : 0;
+    uint64_t pageNum = argc >= 4 ? atoll(argv[3]) : 0;
+    storage::PageFileConcurrentReadTest(threadNum, pageNum);
+  } else if (str == "32") {
+    storage::DirectIoReadTest(argc >= 3 ? atoll(argv[2]) : 0);
+  } else if (str == "33") {
+    storage::FileExtentWriteTest(argc >= 3 ? atoll(argv[2]) : 0);
   } else {
     help();
   }
@@ -9,4 +9,14 @@ void InsertSpeedPrimaryTest(uint64_t row_count);
 void InsertSpeedUniqueTest(uint64_t row_count);
 void InsertSpeedNonUniqueTest(uint64_t row_count);
 void MultiThreadInsertSpeedPrimaryTest(int threadCount, uint64_t row_count);
+void OptimisticLookupTest(int threadCount, uint64_t rowCount);
+void LeafSearchTest(uint64_t rowCount, uint64_t lookupCount);
+void PageFileConcurrentReadTest(int threadCount, uint64_t pageCount);
+void DirectIoReadTest(uint64_t pageCount);
+void FileExtentWriteTest(uint64_t pageCount);
+void ChecksumTest(uint64_t totalMb);
+void BytesCompareTest(uint64_t count);
+void BufferPolicyTest(uint64_t cachePages);
+void PageTableLookupTest(int threadCount, uint64_t pageCount);
+void WarmupRestartTest(uint64_t rowCount);
 } // namespace storage
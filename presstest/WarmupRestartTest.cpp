@@ -0,0 +1,161 @@
+﻿#include "../src/core/IndexTree.h"
+#include "../src/core/LeafPage.h"
+#include "../src/dataType/DataValueDigit.h"
+#include "../src/file/AsyncIo.h"
+#include "../src/pool/PageBufferPool.h"
+#include "../src/pool/PageDividePool.h"
+#include "../src/pool/StoragePool.h"
+#include "../src/utils/Utilitys.h"
+#include "PressTest.h"
+#include <chrono>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <unistd.h>
+
+namespace storage {
+using namespace std;
+
+static const uint32_t WARMUP_FILE_ID = 5000;
+static const char *WARMUP_TABLE_NAME = "testTable";
+
+// Remove the index file from OS page cache, so the next reads go to disk.
+static void DropFileCache(const string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+// Search count random keys and return the lookups per second.
+static double RandomLookup(IndexTree *indexTree, uint64_t rowCount,
+                           uint64_t count, mt19937_64 &rnd) {
+  VectorDataValue vctKey = {new DataValueLong(0LL)};
+  auto st = chrono::steady_clock::now();
+  for (uint64_t i = 0; i < count; i++) {
+    *((DataValueLong *)vctKey[0]) = (int64_t)(rnd() % rowCount);
+    RawKey key(vctKey);
+    IndexPage *idp = nullptr;
+    indexTree->SearchRecursively(key, false, idp, true);
+    bool bFind;
+    ((LeafPage *)idp)->SearchKey(key, bFind);
+    idp->ReadUnlock();
+    idp->DecRef();
+  }
+  double sec = chrono::duration<double>(chrono::steady_clock::now() - st)
+                   .count();
+  return count / sec;
+}
+
+static IndexTree *OpenTree(const string &path) {
+  VectorDataValue vctKey = {new DataValueLong(0LL)};
+  VectorDataValue vctVal = {new DataValueLong(0LL)};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->InitIndex(WARMUP_TABLE_NAME, path.c_str(), vctKey, vctVal,
+                       WARMUP_FILE_ID);
+  return indexTree;
+}
+
+/**Open the cold tree and measure lookups in rounds of 100 ms, until the
+ * throughput reaches 90% of the steady state. Return the time in ms.*/
+static uint64_t TimeToSteady(const string &path, uint64_t rowCount,
+                             double steady, bool bWarmup) {
+  DropFileCache(path);
+  if (bWarmup)
+    PageBufferPool::LoadWarmupList(path + ".lst");
+
+  mt19937_64 rnd(1);
+  auto st = chrono::steady_clock::now();
+  IndexTree *indexTree = OpenTree(path);
+  uint64_t ms = 0;
+  uint64_t batch = max((uint64_t)(steady / 10), (uint64_t)100);
+  while (ms < 60000) {
+    double speed = RandomLookup(indexTree, rowCount, batch, rnd);
+    ms = chrono::duration_cast<chrono::milliseconds>(
+             chrono::steady_clock::now() - st)
+             .count();
+    if (speed >= steady * 0.9)
+      break;
+  }
+
+  cout << (bWarmup ? "Warmup" : "Cold") << "\tTimeToSteady(ms):" << ms
+       << "\tPagesInPool:" << PageBufferPool::GetCacheSize() << endl;
+  IndexTree::TestCloseWait(indexTree);
+  return ms;
+}
+
+/**Build an index tree that fits in PageBufferPool, measure the steady random
+ * lookup throughput, then restart it with cold pages twice: loading pages only
+ * on demand, and with the warm-up list saved before restart.*/
+void WarmupRestartTest(uint64_t rowCount) {
+  if (rowCount < 10000)
+    rowCount = 1000000;
+
+  ThreadPool *tp = ThreadPool::InitMain();
+  TimerThread::Start();
+  AsyncIo::InitAsyncIo(tp);
+  StoragePool::InitPool(tp);
+  StoragePool::AddTimerTask();
+  PageDividePool::InitPool(tp);
+  PageDividePool::AddTimerTask();
+  PageBufferPool::InitPool(tp);
+  PageBufferPool::AddTimerTask();
+
+  const string FILE_NAME = "./dbTest/testWarmupRestart" + StrMSTime() + ".dat";
+  DataValueLong *dvKey = new DataValueLong(0LL);
+  DataValueLong *dvVal = new DataValueLong(0LL);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(WARMUP_TABLE_NAME, FILE_NAME.c_str(), vctKey, vctVal,
+                         WARMUP_FILE_ID, IndexType::PRIMARY);
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  for (uint64_t i = 0; i < rowCount; i++) {
+    *((DataValueLong *)vctKey[0]) = (int64_t)i;
+    *((DataValueLong *)vctVal[0]) = (int64_t)i;
+    LeafRecord *rr =
+        new LeafRecord(indexTree, vctKey, vctVal,
+                       indexTree->GetHeadPage()->ReadRecordStamp(), nullptr);
+    IndexPage *idxPage = nullptr;
+    indexTree->SearchRecursively(*rr, true, idxPage, true);
+    ((LeafPage *)idxPage)->InsertRecord(rr, false);
+    PageDividePool::AddPage(idxPage, false);
+    idxPage->WriteUnlock();
+  }
+  IndexTree::TestCloseWait(indexTree);
+
+  // Load all pages by lookups, then measure the steady state and save the
+  // pages in pool as before a restart.
+  mt19937_64 rnd(0);
+  indexTree = OpenTree(FILE_NAME);
+  RandomLookup(indexTree, rowCount, rowCount * 2, rnd);
+  double steady = RandomLookup(indexTree, rowCount, rowCount, rnd);
+  uint64_t saved = PageBufferPool::SaveWarmupList(FILE_NAME + ".lst");
+  cout << "Rows:" << rowCount << "\tPages:" << saved
+       << "\tSteadyLookups(/s):" << (uint64_t)steady << endl;
+  IndexTree::TestCloseWait(indexTree);
+
+  uint64_t coldMs = TimeToSteady(FILE_NAME, rowCount, steady, false);
+  uint64_t warmMs = TimeToSteady(FILE_NAME, rowCount, steady, true);
+  cout << "Speedup:" << (double)coldMs / max(warmMs, (uint64_t)1) << endl;
+
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+  TimerThread::Stop();
+  AsyncIo::StopAsyncIo();
+  ThreadPool::StopMain();
+  PageDividePool::StopPool();
+  StoragePool::StopPool();
+  PageBufferPool::StopPool();
+
+  delete dvKey;
+  delete dvVal;
+  filesystem::remove(FILE_NAME);
+  filesystem::remove(FILE_NAME + ".lst");
+}
+} // namespace storage
@@ -70,7 +70,9 @@ void Buffer::Release(vector<Byte *> &vct, bool bAll) {
   size_t cap = (vct.capacity() >> 2);
   for (int i = (int)vct.size() - 1; i >= 0; i--) {
     Byte *bys = vct[i];
-    if ((((uint64_t)bys) ^ ((uint64_t)_pBuf)) > Configure::GetCacheBlockSize())
+    // The first block of the next buffer also differs from _pBuf by only the
+    // block size bit, compare the aligned address.
+    if (CalcAddr(bys) != _pBuf)
       continue;
 
     uint16_t index = (uint16_t)(((uint64_t)bys & BUFFER_MASK) / _eleSize);
@@ -1,6 +1,7 @@
 ﻿#include "CachePool.h"
 #include "../config/Configure.h"
 #include "StackTrace.h"
+#include <cstdlib>
 #include <iostream>
 
 namespace storage {
@@ -125,6 +126,24 @@ void CachePool::RecycleBuffer(Buffer *buf) {
   }
 }
 
+Byte *CachePool::ApplyLarge(uint32_t bufSize) {
+  uint64_t align = Configure::GetDiskClusterSize();
+  uint64_t sz = (bufSize + align - 1) & ~(align - 1);
+#ifdef _MSVC_LANG
+  return (Byte *)_aligned_malloc(sz, align);
+#else
+  return (Byte *)aligned_alloc(align, sz);
+#endif // _MSVC_LANG
+}
+
+void CachePool::ReleaseLarge(Byte *pBuf) {
+#ifdef _MSVC_LANG
+  _aligned_free(pBuf);
+#else
+  free(pBuf);
+#endif // _MSVC_LANG
+}
+
 CachePool::CachePool() : _szMemUsed(0), _mapPool(500) {}
 
 CachePool::~CachePool() {
@@ -209,7 +228,7 @@ Byte *CachePool::Apply(uint32_t bufSize) {
   assert(bufSize > 0);
   uint32_t sz = CalcBufSize(bufSize);
   if (sz == UINT32_MAX)
-    return new Byte[bufSize];
+    return ApplyLarge(bufSize);
   else {
     CachePool *pool = GetInstance();
     Byte *bys = pool->_localMap.Pop(sz);
@@ -227,7 +246,7 @@ Byte *CachePool::Apply(uint32_t bufSize, uint32_t &realSize) {
   realSize = CalcBufSize(bufSize);
   if (realSize == UINT32_MAX) {
     realSize = bufSize;
-    return new Byte[realSize];
+    return ApplyLarge(realSize);
   } else {
     CachePool *pool = GetInstance();
     Byte *bys = pool->_localMap.Pop((uint16_t)realSize);
@@ -244,7 +263,7 @@ Byte *CachePool::Apply(uint32_t bufSize, uint32_t &realSize) {
 void CachePool::Release(Byte *pBuf, uint32_t bufSize) {
   uint32_t sz = CalcBufSize(bufSize);
   if (sz == UINT32_MAX)
-    delete[] pBuf;
+    ReleaseLarge(pBuf);
   else {
     CachePool *pool = GetInstance();
     pool->_localMap.Push(pBuf, (uint16_t)sz);
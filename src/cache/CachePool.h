@@ -67,7 +67,9 @@ public:
     }
   }
 
-  /**Apply a menory block for an index page*/
+  /**Apply a menory block for an index page. The page size is a power of 2 and
+   * every Buffer is aligned with its block size, so the returned page is
+   * always aligned to disk cluster and can be used with direct I/O.*/
   static Byte *ApplyPage() {
     CachePool *pool = GetInstance();
     return pool->_localMap.Pop((uint16_t)Configure::GetCachePageSize());
@@ -83,7 +85,7 @@ public:
   static inline Byte *Apply(uint32_t bufSize) {
     uint32_t sz = CalcBufSize(bufSize);
     if (sz == UINT32_MAX)
-      return new Byte[bufSize];
+      return ApplyLarge(bufSize);
     else {
       CachePool *pool = GetInstance();
       return pool->_localMap.Pop(sz);
@@ -94,7 +96,7 @@ public:
     realSize = CalcBufSize(bufSize);
     if (realSize == UINT32_MAX) {
       realSize = bufSize;
-      return new Byte[realSize];
+      return ApplyLarge(realSize);
     } else {
       CachePool *pool = GetInstance();
       return pool->_localMap.Pop((uint16_t)realSize);
@@ -104,7 +106,7 @@ public:
   static inline void Release(Byte *pBuf, uint32_t bufSize) {
     uint32_t sz = CalcBufSize(bufSize);
     if (sz == UINT32_MAX)
-      delete[] pBuf;
+      ReleaseLarge(pBuf);
     else {
       CachePool *pool = GetInstance();
       pool->_localMap.Push(pBuf, (uint16_t)sz);
@@ -124,6 +126,10 @@ protected:
   static void BatchApply(uint32_t bufSize, vector<Byte *> &vct);
   static void BatchRelease(uint32_t bufSize, vector<Byte *> &vct,
                            bool bAll = false);
+  /**The buffers larger than the max element size are allocated from system.
+   * They are aligned to disk cluster, so can be used with direct I/O.*/
+  static Byte *ApplyLarge(uint32_t bufSize);
+  static void ReleaseLarge(Byte *pBuf);
 
 protected:
   static uint32_t CalcBufSize(uint32_t sz) {
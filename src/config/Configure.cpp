@@ -13,7 +13,6 @@ const uint64_t Configure::DEFAULT_MAX_KEY_LENGTH = 2000;
 const uint64_t Configure::DEFAULT_MAX_COLUMN_LENGTH = 1024 * 1024 * 1024;
 const uint64_t Configure::DEFAULT_MAX_FREE_BUFFER_COUNT = 1000;
 const uint64_t Configure::DEFAULT_MAX_FREE_BLOCK_COUNT = 100;
-const uint64_t Configure::MAX_PAGE_FILE_COUNT = 5;
 const uint64_t Configure::MAX_OVERFLOW_CACHE_SIZE = 1024 * 1024;
 Configure *Configure::instance = nullptr;
 // const uint64_t WRITE_DELAY_MS = 10 * 1000;
@@ -28,6 +27,15 @@ const uint64_t Configure::MANUAL_TASK_OVERTIME = 10 * 60 * 1000;
 const bool Configure::LOG_SAVE_SPLIT_PAGE = false;
 const DiskType Configure::DISK_TYPE = DiskType::SSD;
 const uint32_t Configure::DEFAULT_BIN_LOG_FILE_SIZE = 100 * 1024 * 1024;
+const uint32_t Configure::DEFAULT_ASYNC_IO_QUEUE_DEPTH = 256;
+const bool Configure::USE_DIRECT_IO = false;
+const uint32_t Configure::DEFAULT_MIN_EXTENT_PAGES = 64;
+const uint32_t Configure::DEFAULT_MAX_EXTENT_PAGES = 8192;
+const uint32_t Configure::DEFAULT_POOL_LOW_WATERMARK = 80;
+const uint32_t Configure::DEFAULT_POOL_HIGH_WATERMARK = 90;
+const uint32_t Configure::DEFAULT_POOL_HARD_LIMIT = 100;
+const uint32_t Configure::DEFAULT_WARMUP_SAVE_INTERVAL = 60;
+const uint32_t Configure::DEFAULT_DIVIDE_PARTITIONS = 4;
 const char *DEFAULT_DB_ROOT_PATH = "./";
 
 Configure::Configure() {
@@ -42,7 +50,6 @@ Configure::Configure() {
   _lenMaxColumn = DEFAULT_MAX_COLUMN_LENGTH;
   _maxNumFreeBlock = DEFAULT_MAX_FREE_BLOCK_COUNT;
   _countMaxFreeBuff = DEFAULT_MAX_FREE_BUFFER_COUNT;
-  _countMaxPageFile = MAX_PAGE_FILE_COUNT;
   _maxOverflowCache = MAX_OVERFLOW_CACHE_SIZE;
 
   _autoTaskOvertime = AUTOMATE_TASK_OVERTIME;
@@ -51,9 +58,19 @@ Configure::Configure() {
   _bLogSaveSplitPage = LOG_SAVE_SPLIT_PAGE;
   _diskType = DISK_TYPE;
   _binLogFileSize = DEFAULT_BIN_LOG_FILE_SIZE;
+  _asyncIoQueueDepth = DEFAULT_ASYNC_IO_QUEUE_DEPTH;
+  _bDirectIo = USE_DIRECT_IO;
+  _minExtentPages = DEFAULT_MIN_EXTENT_PAGES;
+  _maxExtentPages = DEFAULT_MAX_EXTENT_PAGES;
+  _poolLowWatermark = DEFAULT_POOL_LOW_WATERMARK;
+  _poolHighWatermark = DEFAULT_POOL_HIGH_WATERMARK;
+  _poolHardLimit = DEFAULT_POOL_HARD_LIMIT;
+  _warmupSaveInterval = DEFAULT_WARMUP_SAVE_INTERVAL;
+  _dividePartitions = DEFAULT_DIVIDE_PARTITIONS;
 
   _nodeId = 0;
   _strLogPath = "./binlog/";
   _strDbRootPath = "./";
+  _strWarmupFile = _strDbRootPath + "pageWarmup.lst";
 }
 } // namespace storage
@@ -39,8 +39,6 @@ public:
   static const uint64_t DEFAULT_MAX_FREE_BUFFER_COUNT;
   /**The max number of free blocks for result set */
   static const uint64_t DEFAULT_MAX_FREE_BLOCK_COUNT;
-  /**The max instances to open a index tree for reading or writing*/
-  static const uint64_t MAX_PAGE_FILE_COUNT;
   /**The max size for overflow file cache*/
   static const uint64_t MAX_OVERFLOW_CACHE_SIZE;
   // static const uint64_t WRITE_DELAY_MS = 10 * 1000;
@@ -59,6 +57,29 @@ public:
   static const DiskType DISK_TYPE;
   // default bin log file size
   static const uint32_t DEFAULT_BIN_LOG_FILE_SIZE;
+  // The entries of io_uring submission queue used by AsyncIo. 0 means do not
+  // use io_uring and all pages will be read by pread in thread pool.
+  static const uint32_t DEFAULT_ASYNC_IO_QUEUE_DEPTH;
+  // If open page files with O_DIRECT. Then page blocks will bypass the OS page
+  // cache and PageBufferPool will be the only cache for index pages.
+  static const bool USE_DIRECT_IO;
+  // The min and max pages to preallocate when an index file grows. The extent
+  // adapts to the allocation rate between them. 0 means do not preallocate.
+  static const uint32_t DEFAULT_MIN_EXTENT_PAGES;
+  static const uint32_t DEFAULT_MAX_EXTENT_PAGES;
+  // The watermarks of PageBufferPool, percentage of max cache pages. Eviction
+  // removes pages until below low watermark, it is scheduled at once when
+  // above high watermark, and the threads adding pages will evict some pages
+  // by themselves when above hard limit.
+  static const uint32_t DEFAULT_POOL_LOW_WATERMARK;
+  static const uint32_t DEFAULT_POOL_HIGH_WATERMARK;
+  static const uint32_t DEFAULT_POOL_HARD_LIMIT;
+  // The interval in seconds to save the hot page list of PageBufferPool, the
+  // pages in it will be loaded in background after restart. 0 means disable.
+  static const uint32_t DEFAULT_WARMUP_SAVE_INTERVAL;
+  // The number of partitions in PageDividePool. The pages of an index tree are
+  // always in the same partition and the partitions are divided in parallel.
+  static const uint32_t DEFAULT_DIVIDE_PARTITIONS;
 
 public:
   Configure();
@@ -80,9 +101,6 @@ public:
   static uint64_t GetMaxNumberFreeResultBlock() {
     return GetInstance()._maxNumFreeBlock;
   }
-  static uint64_t GetMaxPageFileCount() {
-    return GetInstance()._countMaxPageFile;
-  }
   static uint64_t GetMaxOverflowCache() {
     return GetInstance()._maxOverflowCache;
   }
@@ -97,6 +115,26 @@ public:
   static const string &GetLogPath() { return GetInstance()._strLogPath; }
   static uint32_t GetBinLogFileSize() { return GetInstance()._binLogFileSize; }
   static DiskType GetDiskType() { return GetInstance()._diskType; }
+  static uint32_t GetAsyncIoQueueDepth() {
+    return GetInstance()._asyncIoQueueDepth;
+  }
+  static bool IsDirectIo() { return GetInstance()._bDirectIo; }
+  static uint32_t GetMinExtentPages() { return GetInstance()._minExtentPages; }
+  static uint32_t GetMaxExtentPages() { return GetInstance()._maxExtentPages; }
+  static uint32_t GetPoolLowWatermark() {
+    return GetInstance()._poolLowWatermark;
+  }
+  static uint32_t GetPoolHighWatermark() {
+    return GetInstance()._poolHighWatermark;
+  }
+  static uint32_t GetPoolHardLimit() { return GetInstance()._poolHardLimit; }
+  static uint32_t GetWarmupSaveInterval() {
+    return GetInstance()._warmupSaveInterval;
+  }
+  static uint32_t GetDividePartitions() {
+    return GetInstance()._dividePartitions;
+  }
+  static const string &GetWarmupFile() { return GetInstance()._strWarmupFile; }
   static const string &GetDbRootPath() { return GetInstance()._strDbRootPath; }
 
 protected:
@@ -121,20 +159,30 @@ protected:
   uint64_t _lenMaxColumn;
   uint64_t _countMaxFreeBuff;
   uint64_t _maxNumFreeBlock;
-  uint64_t _countMaxPageFile;
   uint64_t _maxOverflowCache;
 
   uint64_t _autoTaskOvertime;
   uint64_t _manualTaskOvertime;
 
   bool _bLogSaveSplitPage;
+  bool _bDirectIo;
   DiskType _diskType;
   uint32_t _binLogFileSize;
+  uint32_t _asyncIoQueueDepth;
+  uint32_t _minExtentPages;
+  uint32_t _maxExtentPages;
+  uint32_t _poolLowWatermark;
+  uint32_t _poolHighWatermark;
+  uint32_t _poolHardLimit;
+  uint32_t _warmupSaveInterval;
+  uint32_t _dividePartitions;
   // For distribute, every node will assign a unique id to indentify the nodes.
   // In single environment, the node id=0
   uint16_t _nodeId;
   string _strLogPath;
   // The database root path, all db data will be saved into here
   string _strDbRootPath;
+  // The file to save the hot page list of PageBufferPool
+  string _strWarmupFile;
 };
 } // namespace storage
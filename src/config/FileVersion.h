@@ -25,15 +25,15 @@ public:
     _patchVer = std::stoi(mt[3]);
   }
 
-  short GetMajorVersion() { return _majorVer; }
+  short GetMajorVersion() const { return _majorVer; }
 
   void SetMajorVersion(short ver) { _majorVer = ver; }
 
-  uint8_t GetMinorVersion() { return _minorVer; }
+  uint8_t GetMinorVersion() const { return _minorVer; }
 
   void SetMinorVersion(uint8_t ver) { _minorVer = ver; }
 
-  uint8_t GetPatchVersion() { return _patchVer; }
+  uint8_t GetPatchVersion() const { return _patchVer; }
 
   void GetPatchVersion(uint8_t ver) { _patchVer = ver; }
 
@@ -42,6 +42,14 @@ public:
            _patchVer == fv._patchVer;
   }
 
+  bool operator<(const FileVersion &fv) const {
+    if (_majorVer != fv._majorVer)
+      return _majorVer < fv._majorVer;
+    if (_minorVer != fv._minorVer)
+      return _minorVer < fv._minorVer;
+    return _patchVer < fv._patchVer;
+  }
+
 protected:
   uint16_t _majorVer;
   uint8_t _minorVer;
@@ -55,5 +63,25 @@ inline std::ostream &operator<<(std::ostream &os, const FileVersion &fv) {
      << "\tPatchVer:" << fv._patchVer;
   return os;
 }
-static FileVersion CURRENT_FILE_VERSION = {1, 0, 0};
+static FileVersion CURRENT_FILE_VERSION = {1, 2, 0};
+// The oldest file version that can still be opened.
+static FileVersion MIN_FILE_VERSION = {1, 0, 0};
+// From this version the page checksums are calculated by CRC32C, the older
+// files use CRC32 and keep it until rebuilt.
+static FileVersion CRC32C_FILE_VERSION = {1, 1, 0};
+// From this version the branch pages save the common prefix of their keys
+// once and the records only save the suffixes.
+static FileVersion KEY_PREFIX_FILE_VERSION = {1, 2, 0};
+
+inline bool IsSupportedFileVersion(const FileVersion &fv) {
+  return !(fv < MIN_FILE_VERSION) && !(CURRENT_FILE_VERSION < fv);
+}
+
+inline bool IsCrc32cFileVersion(const FileVersion &fv) {
+  return !(fv < CRC32C_FILE_VERSION);
+}
+
+inline bool IsKeyPrefixFileVersion(const FileVersion &fv) {
+  return !(fv < KEY_PREFIX_FILE_VERSION);
+}
 } // namespace storage
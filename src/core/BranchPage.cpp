@@ -1,4 +1,5 @@
 ﻿#include "BranchPage.h"
+#include "../pool/PageBufferPool.h"
 #include "../pool/StoragePool.h"
 #include "BranchRecord.h"
 #include "IndexTree.h"
@@ -6,11 +7,27 @@
 
 namespace storage {
 const uint16_t BranchPage::DATA_BEGIN_OFFSET = 12;
+const uint16_t BranchPage::PREFIX_LENGTH_OFFSET = 2;
 const uint16_t IndexPage::MAX_DATA_LENGTH_BRANCH =
     (uint16_t)(Configure::GetCachePageSize() - BranchPage::DATA_BEGIN_OFFSET -
                sizeof(uint32_t));
 
-BranchPage::~BranchPage() { CleanRecords(); }
+BranchPage::~BranchPage() {
+  CleanRecords();
+
+  // No one can read the slots now, release the children directly.
+  atomic<IndexPage *> *slots = _swizzleSlots.load();
+  if (slots != nullptr) {
+    for (uint32_t i = 0; i < SWIZZLE_SLOTS; i++) {
+      IndexPage *child = slots[i].load(memory_order_relaxed);
+      if (child != nullptr) {
+        child->DecSwizzle();
+        child->DecRef();
+      }
+    }
+    delete[] slots;
+  }
+}
 
 void BranchPage::CleanRecords() {
   for (RawRecord *rr : _vctRecord) {
@@ -23,6 +40,10 @@ void BranchPage::CleanRecords() {
 void BranchPage::Init() {
   CleanRecords();
   IndexPage::Init();
+  _prefixLen = _indexTree->GetHeadPage()->IsKeyPrefixFile()
+                   ? ReadShort(PREFIX_LENGTH_OFFSET)
+                   : 0;
+  LoadKeyHeads();
 }
 
 void BranchPage::LoadRecords() {
@@ -30,15 +51,28 @@ void BranchPage::LoadRecords() {
   if (_vctRecord.size() > 0)
     CleanRecords();
 
+  const Byte *prefix = GetPrefix();
   uint16_t pos = DATA_BEGIN_OFFSET;
   for (uint16_t i = 0; i < _recordNum; i++) {
-    BranchRecord *rr =
-        new BranchRecord(this, _bysPage + *((uint16_t *)(_bysPage + pos)));
+    Byte *bys = _bysPage + *((uint16_t *)(_bysPage + pos));
+    BranchRecord *rr = (_prefixLen == 0
+                            ? new BranchRecord(this, bys)
+                            : new BranchRecord(this, prefix, _prefixLen, bys));
     _vctRecord.push_back(rr);
     pos += sizeof(uint16_t);
   }
 }
 
+void BranchPage::LoadKeyHeads() {
+  _vctKeyHead.resize(_recordNum);
+  for (uint32_t i = 0; i < _recordNum; i++) {
+    uint16_t start = ReadShort(DATA_BEGIN_OFFSET + i * UI16_LEN);
+    _vctKeyHead[i] =
+        CalcKeyHead(_bysPage + start + _indexTree->GetKeyOffset(),
+                    ReadShort(start + UI16_LEN) - _indexTree->GetKeyVarLen());
+  }
+}
+
 bool BranchPage::SaveRecords() {
   if (_totalDataLength > MAX_DATA_LENGTH_BRANCH)
     return false;
@@ -55,13 +89,21 @@ bool BranchPage::SaveRecords() {
     _bysPage[PAGE_BEGIN_END_OFFSET] = tmp[PAGE_BEGIN_END_OFFSET];
     int refCount = 0;
 
+    _prefixLen = CalcPrefixLength();
+    if (_prefixLen > 0) {
+      BytesCopy(_bysPage + pos,
+                GetVctRecord(0)->GetBysValue() + _indexTree->GetKeyOffset(),
+                _prefixLen);
+      pos += _prefixLen;
+    }
+
     for (int i = 0; i < _vctRecord.size(); i++) {
       WriteShort(DATA_BEGIN_OFFSET + UI16_LEN * i, pos);
       BranchRecord *rr = (BranchRecord *)_vctRecord[i];
       if (_absoBuf != nullptr && !rr->IsSole())
         refCount++;
 
-      pos += rr->SaveData(_bysPage + pos);
+      pos += rr->SaveData(_bysPage + pos, _prefixLen);
     }
 
     CleanRecords();
@@ -71,17 +113,39 @@ bool BranchPage::SaveRecords() {
       _absoBuf->ReleaseCount(refCount);
 
     _absoBuf = nullptr;
+    LoadKeyHeads();
   }
 
   WriteInt(PARENT_PAGE_POINTER_OFFSET, _parentPageId);
   WriteShort(TOTAL_DATA_LENGTH_OFFSET, _totalDataLength);
   WriteShort(NUM_RECORD_OFFSET, _recordNum);
+  if (_indexTree->GetHeadPage()->IsKeyPrefixFile())
+    WriteShort(PREFIX_LENGTH_OFFSET, _prefixLen);
   _bRecordUpdate = false;
   _bDirty = true;
 
   return true;
 }
 
+uint16_t BranchPage::CalcPrefixLength() const {
+  if (_vctRecord.size() < 2 || !_indexTree->GetHeadPage()->IsKeyPrefixFile())
+    return 0;
+
+  // The records are in order, so the common prefix of the first and the last
+  // record is the common prefix of all records.
+  BranchRecord *first = GetVctRecord(0);
+  BranchRecord *last = GetVctRecord((int)_vctRecord.size() - 1);
+  const Byte *bys1 = first->GetBysValue() + _indexTree->GetKeyOffset();
+  const Byte *bys2 = last->GetBysValue() + _indexTree->GetKeyOffset();
+  uint16_t len = min(first->GetKeyLength(), last->GetKeyLength()) -
+                 _indexTree->GetKeyVarLen();
+  uint16_t i = 0;
+  while (i < len && bys1[i] == bys2[i])
+    i++;
+
+  return i;
+}
+
 BranchRecord *BranchPage::DeleteRecord(uint16_t index) {
   assert(index >= 0 && index < _recordNum);
   if (_vctRecord.size() == 0)
@@ -125,6 +189,7 @@ void BranchPage::InsertRecord(BranchRecord *&rr, int32_t pos) {
 
   _totalDataLength += rr->GetTotalLength() + UI16_LEN;
   rr->SetParentPage(this);
+  CountInsert(pos);
   _vctRecord.insert(_vctRecord.begin() + pos, rr);
   _recordNum++;
   _bDirty = true;
@@ -132,8 +197,8 @@ void BranchPage::InsertRecord(BranchRecord *&rr, int32_t pos) {
   rr = nullptr;
 }
 
-bool BranchPage::AddRecord(BranchRecord *&rr) {
-  if (_totalDataLength > MAX_DATA_LENGTH_BRANCH * LOAD_FACTOR / 100U ||
+bool BranchPage::AddRecord(BranchRecord *&rr, uint16_t loadFactor) {
+  if (_totalDataLength > MAX_DATA_LENGTH_BRANCH * loadFactor / 100U ||
       _totalDataLength + rr->GetTotalLength() + UI16_LEN >
           MAX_DATA_LENGTH_BRANCH) {
     return false;
@@ -191,6 +256,20 @@ int32_t BranchPage::SearchKey(const RawKey &key, bool &bFind) const {
   int32_t end = _recordNum - 1;
   bFind = true;
 
+  // Compare the common prefix once, then the records only compare suffixes.
+  if (_vctRecord.size() == 0) {
+    int hr = ComparePrefix(GetPrefix(), _prefixLen, key.GetBysVal(),
+                           key.GetLength());
+    if (hr != 0) {
+      bFind = false;
+      return hr > 0 ? 0 : _recordNum;
+    }
+  }
+  bool bHead = IsKeyHeadValid();
+  uint64_t head = bHead ? CalcKeyHead(key.GetBysVal() + _prefixLen,
+                                      key.GetLength() - _prefixLen)
+                        : 0;
+
   while (true) {
     if (start > end) {
       bFind = false;
@@ -198,8 +277,10 @@ int32_t BranchPage::SearchKey(const RawKey &key, bool &bFind) const {
     }
 
     int32_t middle = (start + end) / 2;
-    int hr = (_vctRecord.size() > 0 ? GetVctRecord(middle)->CompareKey(key)
-                                    : CompareTo(middle, key));
+    int hr = bHead ? CompareKeyHead(middle, head) : 0;
+    if (hr == 0)
+      hr = (_vctRecord.size() > 0 ? GetVctRecord(middle)->CompareKey(key)
+                                  : CompareSuffix(middle, key));
     if (hr < 0) {
       start = middle + 1;
     } else if (hr > 0) {
@@ -208,7 +289,7 @@ int32_t BranchPage::SearchKey(const RawKey &key, bool &bFind) const {
       if (!bUnique && middle > start &&
           (_vctRecord.size() > 0
                ? GetVctRecord(middle - 1)->CompareKey(key) == 0
-               : CompareTo(middle - 1, key) == 0)) {
+               : CompareSuffix(middle - 1, key) == 0)) {
         end = middle - 1;
       } else {
         return middle;
@@ -219,28 +300,38 @@ int32_t BranchPage::SearchKey(const RawKey &key, bool &bFind) const {
 
 int BranchPage::CompareTo(uint32_t recPos, const BranchRecord &rr) const {
   uint32_t start = ReadShort(DATA_BEGIN_OFFSET + recPos * UI16_LEN);
-  uint32_t lenKey = ReadShort(start + UI16_LEN);
-
+  const Byte *bys = rr.GetBysValue() + _indexTree->GetKeyOffset();
+  uint32_t len, lenRec;
   if (_indexTree->GetHeadPage()->ReadIndexType() != IndexType::NON_UNIQUE) {
-    return BytesCompare(_bysPage + start + _indexTree->GetKeyOffset(),
-                        ReadShort(start + UI16_LEN) -
-                            _indexTree->GetKeyVarLen(),
-                        rr.GetBysValue() + _indexTree->GetKeyOffset(),
-                        rr.GetKeyLength() - _indexTree->GetKeyVarLen());
+    len = rr.GetKeyLength() - _indexTree->GetKeyVarLen();
+    lenRec = ReadShort(start + UI16_LEN) - _indexTree->GetKeyVarLen();
   } else {
-    return BytesCompare(_bysPage + start + _indexTree->GetKeyOffset(),
-                        ReadShort(start) - _indexTree->GetKeyOffset(),
-                        rr.GetBysValue() + _indexTree->GetKeyOffset(),
-                        rr.GetTotalLength() - _indexTree->GetKeyOffset());
+    len = rr.GetTotalLength() - _indexTree->GetKeyOffset();
+    lenRec = ReadShort(start) - _indexTree->GetKeyOffset();
   }
+
+  int hr = ComparePrefix(GetPrefix(), _prefixLen, bys, len);
+  if (hr != 0)
+    return hr;
+  return BytesCompare(_bysPage + start + _indexTree->GetKeyOffset(), lenRec,
+                      bys + _prefixLen, len - _prefixLen);
 }
 
 int BranchPage::CompareTo(uint32_t recPos, const RawKey &key) const {
+  int hr =
+      ComparePrefix(GetPrefix(), _prefixLen, key.GetBysVal(), key.GetLength());
+  if (hr != 0)
+    return hr;
+  return CompareSuffix(recPos, key);
+}
+
+int BranchPage::CompareSuffix(uint32_t recPos, const RawKey &key) const {
   uint32_t start = ReadShort(DATA_BEGIN_OFFSET + recPos * UI16_LEN);
 
   return BytesCompare(_bysPage + start + _indexTree->GetKeyOffset(),
                       ReadShort(start + UI16_LEN) - _indexTree->GetKeyVarLen(),
-                      key.GetBysVal(), key.GetLength());
+                      key.GetBysVal() + _prefixLen,
+                      key.GetLength() - _prefixLen);
 }
 
 BranchRecord *BranchPage::GetRecordByPos(int32_t pos, bool bAutoLast) {
@@ -256,4 +347,194 @@ BranchRecord *BranchPage::GetRecordByPos(int32_t pos, bool bAutoLast) {
 
   return GetVctRecord(pos);
 }
+
+PageID BranchPage::GetChildPageId(int32_t pos, bool bAutoLast) {
+  assert(_recordNum > 0 && pos >= 0);
+  assert(bAutoLast || pos < (int32_t)_recordNum);
+  if (bAutoLast && pos >= (int32_t)_recordNum) {
+    pos = _recordNum - 1;
+  }
+
+  if (_vctRecord.size() > 0)
+    return GetVctRecord(pos)->GetChildPageId();
+
+  uint32_t start = ReadShort(DATA_BEGIN_OFFSET + pos * UI16_LEN);
+  return *((PageID *)(_bysPage + start + ReadShort(start) -
+                      BranchRecord::PAGE_ID_LEN));
+}
+
+bool BranchPage::SearchKeyOptimistic(const RawKey &key,
+                                     PageID &childId) const {
+  if (_bRecordUpdate)
+    return false;
+
+  const Byte *bys = _bysPage;
+  const uint32_t keyOffset = _indexTree->GetKeyOffset();
+  const uint32_t keyVarLen = _indexTree->GetKeyVarLen();
+  uint32_t num = *((uint16_t *)(bys + NUM_RECORD_OFFSET));
+  uint32_t lenPrefix = _indexTree->GetHeadPage()->IsKeyPrefixFile()
+                           ? *((uint16_t *)(bys + PREFIX_LENGTH_OFFSET))
+                           : 0;
+  if (num == 0 ||
+      DATA_BEGIN_OFFSET + num * UI16_LEN + lenPrefix > CACHE_PAGE_SIZE)
+    return false;
+  const Byte *prefix = bys + DATA_BEGIN_OFFSET + num * UI16_LEN;
+
+  // Return the start of record in _bysPage, or 0 if it is out of page.
+  auto funcStart = [bys, keyOffset](uint32_t recPos) -> uint32_t {
+    uint32_t start = *((uint16_t *)(bys + DATA_BEGIN_OFFSET + recPos * UI16_LEN));
+    if (start < DATA_BEGIN_OFFSET || start + UI16_2_LEN > CACHE_PAGE_SIZE)
+      return 0;
+
+    uint32_t lenTotal = *((uint16_t *)(bys + start));
+    uint32_t lenKey = *((uint16_t *)(bys + start + UI16_LEN));
+    if (lenTotal < keyOffset + lenKey + BranchRecord::PAGE_ID_LEN ||
+        start + lenTotal > CACHE_PAGE_SIZE)
+      return 0;
+    return start;
+  };
+  // Compare the key of record with the searched key, set bValid to false if
+  // the record is out of page.
+  bool bValid = true;
+  auto funcCompare = [&](uint32_t recPos) -> int {
+    uint32_t start = funcStart(recPos);
+    if (start == 0) {
+      bValid = false;
+      return 0;
+    }
+
+    uint32_t lenKey = *((uint16_t *)(bys + start + UI16_LEN));
+    return BytesCompare(bys + start + keyOffset, lenKey - keyVarLen,
+                        key.GetBysVal() + lenPrefix,
+                        key.GetLength() - lenPrefix);
+  };
+
+  bool bUnique =
+      (_indexTree->GetHeadPage()->ReadIndexType() != IndexType::NON_UNIQUE);
+  int32_t start = 0;
+  int32_t end = num - 1;
+  int32_t pos = -1;
+  int hrPrefix =
+      ComparePrefix(prefix, lenPrefix, key.GetBysVal(), key.GetLength());
+  if (hrPrefix > 0)
+    pos = 0;
+  else if (hrPrefix < 0)
+    pos = num;
+
+  while (pos < 0) {
+    if (start > end) {
+      pos = start;
+      break;
+    }
+
+    int32_t middle = (start + end) / 2;
+    int hr = funcCompare(middle);
+    if (!bValid)
+      return false;
+
+    if (hr < 0) {
+      start = middle + 1;
+    } else if (hr > 0) {
+      end = middle - 1;
+    } else if (!bUnique && middle > start && funcCompare(middle - 1) == 0) {
+      if (!bValid)
+        return false;
+      end = middle - 1;
+    } else {
+      pos = middle;
+    }
+  }
+
+  if (pos >= (int32_t)num)
+    pos = num - 1;
+  uint32_t recStart = funcStart(pos);
+  if (recStart == 0)
+    return false;
+
+  childId = *((PageID *)(bys + recStart + *((uint16_t *)(bys + recStart)) -
+                         BranchRecord::PAGE_ID_LEN));
+  return true;
+}
+
+IndexPage *BranchPage::PeekSwizzledChild(PageID pageId) {
+  atomic<IndexPage *> *slots = _swizzleSlots.load(memory_order_acquire);
+  if (slots == nullptr)
+    return nullptr;
+
+  IndexPage *child = slots[pageId % SWIZZLE_SLOTS].load(memory_order_acquire);
+  if (child == nullptr || child->GetPageId() != pageId || child->IsEvicted())
+    return nullptr;
+
+  child->SetReferenced();
+  return child;
+}
+
+IndexPage *BranchPage::GetSwizzledChild(PageID pageId) {
+  atomic<IndexPage *> *slots = _swizzleSlots.load(memory_order_acquire);
+  if (slots == nullptr)
+    return nullptr;
+
+  atomic<IndexPage *> &slot = slots[pageId % SWIZZLE_SLOTS];
+  // The child released by other thread is not freed until the guard exits.
+  PageBufferPool::ReadGuard guard;
+  IndexPage *child = slot.load(memory_order_acquire);
+  if (child == nullptr || child->GetPageId() != pageId)
+    return nullptr;
+
+  // Pair with the fence in CachePage::TryEvict
+  child->IncRef();
+  atomic_thread_fence(memory_order_seq_cst);
+  if (!child->IsEvicted()) {
+    child->SetReferenced();
+    return child;
+  }
+
+  // The child has been evicted from pool, unswizzle it.
+  child->DecRef();
+  if (slot.compare_exchange_strong(child, nullptr)) {
+    ReleaseSwizzle(child);
+  }
+  return nullptr;
+}
+
+void BranchPage::SwizzleChild(IndexPage *child) {
+  if (child->GetPageStatus() != PageStatus::VALID || child->IsEvicted())
+    return;
+
+  atomic<IndexPage *> *slots = _swizzleSlots.load(memory_order_acquire);
+  if (slots == nullptr) {
+    atomic<IndexPage *> *newSlots = new atomic<IndexPage *>[SWIZZLE_SLOTS];
+    for (uint32_t i = 0; i < SWIZZLE_SLOTS; i++) {
+      newSlots[i].store(nullptr, memory_order_relaxed);
+    }
+
+    if (_swizzleSlots.compare_exchange_strong(slots, newSlots)) {
+      slots = newSlots;
+    } else {
+      delete[] newSlots;
+    }
+  }
+
+  atomic<IndexPage *> &slot = slots[child->GetPageId() % SWIZZLE_SLOTS];
+  IndexPage *old = slot.load(memory_order_acquire);
+  if (old == child)
+    return;
+
+  child->IncRef();
+  child->IncSwizzle();
+  if (slot.compare_exchange_strong(old, child)) {
+    if (old != nullptr)
+      ReleaseSwizzle(old);
+  } else {
+    child->DecSwizzle();
+    child->DecRef();
+  }
+}
+
+void BranchPage::ReleaseSwizzle(IndexPage *child) {
+  child->DecSwizzle();
+  // Other threads maybe have loaded the pointer from slot, decrease the
+  // reference after they finished.
+  PageBufferPool::ReleaseLater(child);
+}
 } // namespace storage
@@ -1,4 +1,4 @@
-#pragma once
+﻿#pragma once
 #include "IndexPage.h"
 #include "PageType.h"
 #include "RawKey.h"
@@ -9,6 +9,12 @@ class BranchRecord;
 class BranchPage : public IndexPage {
 public:
   static const uint16_t DATA_BEGIN_OFFSET;
+  // The length of common key prefix, only used by the files with key prefix.
+  // The prefix is saved after the record slots and followed by records with
+  // key suffixes.
+  static const uint16_t PREFIX_LENGTH_OFFSET;
+  // The slots to save swizzled child pointers, indexed by child page id.
+  static const uint32_t SWIZZLE_SLOTS = 256;
 
 public:
   BranchPage(IndexTree *indexTree, uint32_t pageId, Byte pageLevel,
@@ -24,25 +30,75 @@ public:
 
   void CleanRecords();
   void LoadRecords();
+  // Load the heads of key suffixes in _bysPage
+  void LoadKeyHeads();
   BranchRecord *DeleteRecord(uint16_t index);
   BranchRecord *DeleteRecord(const BranchRecord &record);
 
   void InsertRecord(BranchRecord *&record, int32_t pos = -1);
-  bool AddRecord(BranchRecord *&record);
+  // Append a record for batch add, see LeafPage::AddRecord
+  bool AddRecord(BranchRecord *&record, uint16_t loadFactor = LOAD_FACTOR);
   bool RecordExist(const RawKey &key) const;
 
   int32_t SearchRecord(const BranchRecord &rr, bool &bFind) const;
   int32_t SearchKey(const RawKey &key, bool &bFind) const;
   BranchRecord *GetRecordByPos(int32_t pos, bool bAutoLast);
+  /**Get the child page id of the record in pos. It reads _bysPage if the
+   * records have not been loaded, so it does not change this page and can be
+   * called by multi threads with read lock.*/
+  PageID GetChildPageId(int32_t pos, bool bAutoLast);
+  /**Search the child page for key in _bysPage without lock, used by
+   * optimistic reads. All offsets are checked since a writer maybe changing
+   * the page, and the result is only valid if the page version is unchanged.
+   * @return False if the records have not been saved into _bysPage or the page
+   * data is inconsistent.*/
+  bool SearchKeyOptimistic(const RawKey &key, PageID &childId) const;
 
   bool IsPageFull() const { return _totalDataLength >= MAX_DATA_LENGTH_BRANCH; }
   void Init() override;
 
+  /**Get the child page by the swizzled pointer and increase its reference, so
+   * the lookup in PageBufferPool is skipped.
+   * @return The child page or nullptr if it has not been swizzled or has been
+   * evicted.*/
+  IndexPage *GetSwizzledChild(PageID pageId);
+  /**Save the pointer of child page, the caller must hold a reference of it.
+   * Only the pages have been loaded are swizzled.*/
+  void SwizzleChild(IndexPage *child);
+  /**Get the child page by the swizzled pointer without increasing its
+   * reference, the caller must be in a PageBufferPool::ReadGuard.*/
+  IndexPage *PeekSwizzledChild(PageID pageId);
+
 protected:
   inline BranchRecord *GetVctRecord(int pos) const {
     return (BranchRecord *)_vctRecord[pos];
   }
+  // The common key prefix in _bysPage, only valid before records are loaded
+  inline const Byte *GetPrefix() const {
+    return _bysPage + DATA_BEGIN_OFFSET + _recordNum * UI16_LEN;
+  }
+  /**Compare the common key prefix with the head of bys, a bys equal to the
+   * head of prefix but shorter is less than prefix.*/
+  static inline int ComparePrefix(const Byte *prefix, uint32_t lenPrefix,
+                                  const Byte *bys, uint32_t len) {
+    if (lenPrefix == 0)
+      return 0;
+    return BytesCompare(prefix, lenPrefix, bys, min(len, lenPrefix));
+  }
+  // Calc the common key prefix of the loaded records to save
+  uint16_t CalcPrefixLength() const;
   int CompareTo(uint32_t recPos, const BranchRecord &rr) const;
   int CompareTo(uint32_t recPos, const RawKey &key) const;
+  // Only compare the key suffix, the key must have the prefix of this page
+  int CompareSuffix(uint32_t recPos, const RawKey &key) const;
+  // Release a swizzled pointer after it has been removed from slot.
+  static void ReleaseSwizzle(IndexPage *child);
+
+protected:
+  // The swizzled child pointers, allocated when the first child is swizzled.
+  // Every pointer holds a reference of the child page.
+  atomic<atomic<IndexPage *> *> _swizzleSlots{nullptr};
+  // The length of common key prefix saved in _bysPage
+  uint16_t _prefixLen = 0;
 };
 } // namespace storage
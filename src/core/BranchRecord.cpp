@@ -30,6 +30,33 @@ BranchRecord::BranchRecord(IndexTree *indexTree, RawRecord *rec,
   *((uint32_t *)(_bysVal + lenKey + lenVal + UI16_2_LEN)) = childPageId;
 }
 
+BranchRecord::BranchRecord(BranchPage *parentPage, const Byte *bysPrefix,
+                           uint16_t lenPrefix, const Byte *bys)
+    : RawRecord(parentPage->GetIndexTree(), parentPage, nullptr, true) {
+  uint16_t totalLen = *((uint16_t *)bys) + lenPrefix;
+  _bysVal = CachePool::Apply(totalLen);
+
+  *((uint16_t *)_bysVal) = totalLen;
+  *((uint16_t *)(_bysVal + UI16_LEN)) =
+      *((uint16_t *)(bys + UI16_LEN)) + lenPrefix;
+  BytesCopy(_bysVal + UI16_2_LEN, bysPrefix, lenPrefix);
+  BytesCopy(_bysVal + UI16_2_LEN + lenPrefix, bys + UI16_2_LEN,
+            totalLen - lenPrefix - UI16_2_LEN);
+}
+
+BranchRecord::BranchRecord(IndexTree *indexTree, const Byte *bysKey,
+                           uint16_t lenKey, uint32_t childPageId)
+    : RawRecord(indexTree, nullptr, nullptr, true) {
+  assert(_indexTree->GetHeadPage()->ReadIndexType() != IndexType::NON_UNIQUE);
+  uint16_t totalLen = lenKey + PAGE_ID_LEN + UI16_2_LEN;
+  _bysVal = CachePool::Apply(totalLen);
+
+  *((uint16_t *)_bysVal) = totalLen;
+  *((uint16_t *)(_bysVal + UI16_LEN)) = lenKey;
+  BytesCopy(_bysVal + UI16_2_LEN, bysKey, lenKey);
+  *((uint32_t *)(_bysVal + lenKey + UI16_2_LEN)) = childPageId;
+}
+
 RawKey *BranchRecord::GetKey() const {
   return new RawKey(_bysVal + _indexTree->GetKeyOffset(),
                     GetKeyLength() - _indexTree->GetKeyVarLen());
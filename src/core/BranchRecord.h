@@ -16,6 +16,14 @@ public:
 public:
   BranchRecord(BranchPage *parentPage, Byte *bys);
   BranchRecord(IndexTree *indexTree, RawRecord *rec, uint32_t childPageId);
+  /**Rebuild the record saved in a page with common key prefix, the prefix is
+   * copied back before the suffix into a sole buffer.*/
+  BranchRecord(BranchPage *parentPage, const Byte *bysPrefix,
+               uint16_t lenPrefix, const Byte *bys);
+  /**Create a record with the key bytes only, used for the truncated separator
+   * keys in unique index.*/
+  BranchRecord(IndexTree *indexTree, const Byte *bysKey, uint16_t lenKey,
+               uint32_t childPageId);
   BranchRecord(const BranchRecord &src) = delete;
   ~BranchRecord() {}
 
@@ -36,9 +44,14 @@ public:
   PageID GetChildPageId() const {
     return *((PageID *)(_bysVal + GetTotalLength() - PAGE_ID_LEN));
   }
-  uint16_t SaveData(Byte *bysPage) {
-    uint16_t len = GetTotalLength();
-    BytesCopy(bysPage, _bysVal, len);
+  /**Save this record into page, the first lenPrefix bytes of key are the
+   * common prefix of page and are skipped.*/
+  uint16_t SaveData(Byte *bysPage, uint16_t lenPrefix = 0) {
+    uint16_t len = GetTotalLength() - lenPrefix;
+    *((uint16_t *)bysPage) = len;
+    *((uint16_t *)(bysPage + UI16_LEN)) = GetKeyLength() - lenPrefix;
+    BytesCopy(bysPage + UI16_2_LEN, _bysVal + UI16_2_LEN + lenPrefix,
+              len - UI16_2_LEN);
     return len;
   }
 
@@ -0,0 +1,237 @@
+﻿#include "BulkLoader.h"
+#include "../utils/ErrorID.h"
+#include "../utils/ErrorMsg.h"
+#include "../utils/Log.h"
+#include "BranchPage.h"
+#include "BranchRecord.h"
+#include "IndexTree.h"
+#include "LeafPage.h"
+#include "LeafRecord.h"
+#include <sys/uio.h>
+
+namespace storage {
+const uint32_t BulkLoader::MAX_WRITE_PAGES = 64;
+
+BulkLoader::BulkLoader(IndexTree *indexTree, uint16_t loadFactor)
+    : _indexTree(indexTree), _loadFactor(loadFactor) {
+  assert(loadFactor > 0 && loadFactor <= 100);
+  HeadPage *headPage = _indexTree->GetHeadPage();
+  _bValid = (headPage->ReadTotalRecordCount() == 0 &&
+             headPage->ReadRootPagePointer() == 0);
+  if (!_bValid) {
+    _threadErrorMsg.reset(
+        new ErrorMsg(CORE_INDEX_NOT_EMPTY, {_indexTree->GetFileName()}));
+  }
+}
+
+BulkLoader::~BulkLoader() {
+  if (_lastRecord != nullptr)
+    _lastRecord->DecRef();
+  if (_bFinished)
+    return;
+
+  for (IndexPage *page : _vctPage) {
+    if (page != nullptr)
+      page->DecRef(2);
+  }
+  for (IndexPage *page : _vctWrite) {
+    page->DecRef(2);
+  }
+
+  if (_recordCount > 0) {
+    HeadPage *headPage = _indexTree->GetHeadPage();
+    headPage->WriteTotalRecordCount(headPage->ReadTotalRecordCount() -
+                                    _recordCount);
+  }
+}
+
+bool BulkLoader::AddRecord(LeafRecord *lr) {
+  if (!_bValid || _bFinished || lr->IsTransaction()) {
+    lr->DecRef();
+    return false;
+  }
+
+  if (_lastRecord != nullptr) {
+    int hr = _indexTree->GetHeadPage()->ReadIndexType() == IndexType::NON_UNIQUE
+                 ? lr->CompareTo(*_lastRecord)
+                 : lr->CompareKey(*_lastRecord);
+    if (hr <= 0) {
+      _threadErrorMsg.reset(new ErrorMsg(CORE_UNORDERED_RECORD, {}));
+      lr->DecRef();
+      return false;
+    }
+  }
+
+  if (_vctPage.size() == 0) {
+    _vctPage.push_back(nullptr);
+    _vctClosed.push_back(0);
+    _beginLeafId = _indexTree->GetHeadPage()->GetAndIncTotalPageCount();
+    OpenPage(0, _beginLeafId);
+  }
+
+  LeafPage *leaf = (LeafPage *)_vctPage[0];
+  if (!leaf->AddRecord(lr, _loadFactor)) {
+    if (leaf->GetRecordNumber() == 0) {
+      _threadErrorMsg.reset(new ErrorMsg(
+          CORE_EXCEED_KEY_LENGTH, {ToMString(lr->GetTotalLength())}));
+      lr->DecRef();
+      return false;
+    }
+
+    // Apply the id before closing, the parent page maybe applies a new id too.
+    PageID nextId = _indexTree->GetHeadPage()->GetAndIncTotalPageCount();
+    PageID prevId = leaf->GetPageId();
+    leaf->SetNextPageId(nextId);
+    ClosePage(0, false);
+
+    leaf = (LeafPage *)OpenPage(0, nextId);
+    leaf->SetPrevPageId(prevId);
+    bool b = leaf->AddRecord(lr, _loadFactor);
+    assert(b);
+  }
+
+  if (_lastRecord != nullptr)
+    _lastRecord->DecRef();
+  _lastRecord = lr->AddRef();
+  _recordCount++;
+  return true;
+}
+
+bool BulkLoader::Finish() {
+  if (!_bValid || _bFinished)
+    return false;
+  _bFinished = true;
+  if (_vctPage.size() == 0)
+    return true;
+
+  PageID endLeafId = _vctPage[0]->GetPageId();
+  PageID rootId = PAGE_NULL_POINTER;
+  // Close the last page in every level from bottom to up, the parent levels
+  // maybe added by ClosePage. The root is the only page in the top level and
+  // is always a branch page.
+  for (uint32_t level = 0; level < _vctPage.size(); level++) {
+    if (level == _vctPage.size() - 1 && level > 0 && _vctClosed[level] == 0) {
+      IndexPage *root = _vctPage[level];
+      _vctPage[level] = nullptr;
+      root->SetEndPage(true);
+      root->SaveRecords();
+      rootId = root->GetPageId();
+      WritePage(root);
+      break;
+    }
+
+    ClosePage(level, true);
+  }
+  FlushWrite();
+
+  HeadPage *headPage = _indexTree->GetHeadPage();
+  headPage->WriteBeginLeafPagePointer(_beginLeafId);
+  headPage->WriteEndLeafPagePointer(endLeafId);
+
+  IndexPage *root = _indexTree->GetPage(rootId, PageType::BRANCH_PAGE, true);
+  _indexTree->UpdateRootPage(root);
+  root->DecRef();
+
+  LOG_INFO << "Bulk loaded index tree, records=" << _recordCount
+           << "  levels=" << _vctPage.size() << "  rootId=" << rootId
+           << "  writeCalls=" << _writeCalls
+           << "  name=" << _indexTree->GetFileName();
+  return true;
+}
+
+IndexPage *BulkLoader::OpenPage(uint32_t level, PageID pageId) {
+  IndexPage *page = nullptr;
+  if (level == 0) {
+    page = new LeafPage(_indexTree, pageId, PAGE_NULL_POINTER);
+  } else {
+    page = new BranchPage(_indexTree, pageId, (Byte)level, PAGE_NULL_POINTER);
+  }
+
+  page->SetPageStatus(PageStatus::VALID);
+  page->GetBysPage()[IndexPage::PAGE_BEGIN_END_OFFSET] = 0;
+  page->SetBeginPage(_vctClosed[level] == 0);
+  _indexTree->IncPages();
+  _vctPage[level] = page;
+  return page;
+}
+
+void BulkLoader::AddBranchRecord(uint32_t level, BranchRecord *br) {
+  if (level == _vctPage.size()) {
+    _vctPage.push_back(nullptr);
+    _vctClosed.push_back(0);
+  }
+
+  BranchPage *page = (BranchPage *)_vctPage[level];
+  if (page == nullptr) {
+    page = (BranchPage *)OpenPage(
+        level, _indexTree->GetHeadPage()->GetAndIncTotalPageCount());
+  }
+
+  if (!page->AddRecord(br, _loadFactor)) {
+    PageID nextId = _indexTree->GetHeadPage()->GetAndIncTotalPageCount();
+    ClosePage(level, false);
+    page = (BranchPage *)OpenPage(level, nextId);
+    bool b = page->AddRecord(br, _loadFactor);
+    assert(b);
+  }
+}
+
+void BulkLoader::ClosePage(uint32_t level, bool bEnd) {
+  IndexPage *page = _vctPage[level];
+  assert(page != nullptr && page->GetRecordNumber() > 0);
+  int32_t last = (int32_t)page->GetRecordNumber() - 1;
+
+  BranchRecord *br = nullptr;
+  if (level == 0) {
+    LeafRecord *lr = ((LeafPage *)page)->GetRecord(last);
+    br = new BranchRecord(_indexTree, lr, page->GetPageId());
+    lr->DecRef();
+  } else {
+    br = new BranchRecord(_indexTree,
+                          ((BranchPage *)page)->GetRecordByPos(last, false),
+                          page->GetPageId());
+  }
+
+  AddBranchRecord(level + 1, br);
+  page->SetParentPageID(_vctPage[level + 1]->GetPageId());
+  page->SetEndPage(bEnd);
+  page->SaveRecords();
+
+  _vctPage[level] = nullptr;
+  _vctClosed[level]++;
+  WritePage(page);
+}
+
+void BulkLoader::WritePage(IndexPage *page) {
+  if (_vctWrite.size() > 0 &&
+      (_vctWrite.size() >= MAX_WRITE_PAGES ||
+       _vctWrite.back()->GetPageId() + 1 != page->GetPageId())) {
+    FlushWrite();
+  }
+
+  _vctWrite.push_back(page);
+}
+
+void BulkLoader::FlushWrite() {
+  if (_vctWrite.size() == 0)
+    return;
+
+  MVector<iovec> vctIov;
+  vctIov.reserve(_vctWrite.size());
+  for (IndexPage *page : _vctWrite) {
+    page->LockForWrite();
+    vctIov.push_back({page->GetBysPage(), page->GetPageLength()});
+  }
+
+  _indexTree->GetPageFile()->WritePages(
+      CachePage::CalcFileOffset(_vctWrite[0]->GetPageId()), vctIov.data(),
+      (int)vctIov.size());
+  _writeCalls++;
+
+  for (IndexPage *page : _vctWrite) {
+    page->UnlockForWrite();
+    page->DecRef(2);
+  }
+  _vctWrite.clear();
+}
+} // namespace storage
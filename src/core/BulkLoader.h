@@ -0,0 +1,65 @@
+﻿#pragma once
+#include "../cache/Mallocator.h"
+#include "../header.h"
+#include <cstdint>
+
+namespace storage {
+class IndexTree;
+class IndexPage;
+class LeafRecord;
+class BranchRecord;
+
+/**Build an empty index tree from records sorted by key, the branch levels are
+ * built from bottom to up. The pages are filled to the load factor and written
+ * into PageFile in order of page id, they do not pass PageBufferPool,
+ * PageDividePool or StoragePool. No other thread can use the tree before
+ * Finish. The empty root leaf created with the tree is left unused.*/
+class BulkLoader {
+public:
+  // The max continuous pages to be written by one call
+  static const uint32_t MAX_WRITE_PAGES;
+
+public:
+  BulkLoader(IndexTree *indexTree, uint16_t loadFactor);
+  // If not finished, drop the unwritten pages and the added records.
+  ~BulkLoader();
+  /**Append a record after all added records, the loader owns the record.
+   * @return False if the tree is not empty, the record is not greater than
+   * the last one, in transaction, or too long for a page.*/
+  bool AddRecord(LeafRecord *lr);
+  // Write the remaining pages and set the new root.
+  bool Finish();
+
+  uint64_t GetRecordCount() const { return _recordCount; }
+  uint32_t GetLevelCount() const { return (uint32_t)_vctPage.size(); }
+  uint64_t GetWriteCallCount() const { return _writeCalls; }
+
+protected:
+  IndexPage *OpenPage(uint32_t level, PageID pageId);
+  // Add the record of a child page into the branch page in level.
+  void AddBranchRecord(uint32_t level, BranchRecord *br);
+  // Add the record for the page in level into its parent, then write it.
+  void ClosePage(uint32_t level, bool bEnd);
+  // Put the page into the write batch, the batch is written if the page is
+  // not continuous with it.
+  void WritePage(IndexPage *page);
+  void FlushWrite();
+
+protected:
+  IndexTree *_indexTree;
+  uint16_t _loadFactor;
+  // The page being filled in every level, leaf level is 0.
+  MVector<IndexPage *> _vctPage;
+  // How many pages have been closed in every level.
+  MVector<uint64_t> _vctClosed;
+  // The continuous pages waiting to be written.
+  MVector<IndexPage *> _vctWrite;
+  // The last added record, to check the order.
+  LeafRecord *_lastRecord = nullptr;
+  PageID _beginLeafId = PAGE_NULL_POINTER;
+  uint64_t _recordCount = 0;
+  uint64_t _writeCalls = 0;
+  bool _bValid;
+  bool _bFinished = false;
+};
+} // namespace storage
@@ -1,5 +1,6 @@
 ﻿#include "CachePage.h"
 #include "../cache/CachePool.h"
+#include "../utils/Crc32c.h"
 #include "IndexTree.h"
 #include <boost/crc.hpp>
 
@@ -49,42 +50,48 @@ void CachePage::ReadPage(PageFile *pageFile) {
   unique_lock<SpinMutex> lock(_pageLock);
 
   PageFile *pFile =
-      (pageFile == nullptr ? _indexTree->ApplyPageFile() : pageFile);
-  if (_pageId != PAGE_NULL_POINTER) {
-    pFile->ReadPage(Configure::GetDiskClusterSize() +
-                        _pageId * Configure::GetCachePageSize(),
-                    (char *)_bysPage, (uint32_t)Configure::GetCachePageSize());
+      (pageFile == nullptr ? _indexTree->GetPageFile() : pageFile);
+  pFile->ReadPage(GetFileOffset(), (char *)_bysPage, GetPageLength());
+
+  AfterRead(lock);
+}
 
+void CachePage::AfterAsyncRead() {
+  unique_lock<SpinMutex> lock(_pageLock);
+  AfterRead(lock);
+}
+
+void CachePage::AfterRead(unique_lock<SpinMutex> &lock) {
+  PageStatus status = _pageStatus;
+  if (_pageId != PAGE_NULL_POINTER) {
     if (_pageType != PageType::OVERFLOW_PAGE) {
-      crc32.reset();
-      crc32.process_bytes(_bysPage, CRC32_PAGE_OFFSET);
-      if (crc32.checksum() != (uint32_t)ReadInt(CRC32_PAGE_OFFSET)) {
-        _pageStatus = PageStatus::INVALID;
-      } else {
-        _pageStatus = PageStatus::VALID;
-      }
+      status = (CalcChecksum(CRC32_PAGE_OFFSET) !=
+                (uint32_t)ReadInt(CRC32_PAGE_OFFSET))
+                   ? PageStatus::INVALID
+                   : PageStatus::VALID;
     }
   } else {
-    pFile->ReadPage(0, (char *)_bysPage,
-                    (uint32_t)Configure::GetDiskClusterSize());
-    crc32.reset();
-    crc32.process_bytes(_bysPage, CRC32_HEAD_OFFSET);
-    if (crc32.checksum() != (uint32_t)ReadInt(CRC32_HEAD_OFFSET)) {
-      _pageStatus = PageStatus::INVALID;
-    } else {
-      _pageStatus = PageStatus::VALID;
-    }
-  }
-
-  if (pageFile == nullptr) {
-    _indexTree->ReleasePageFile(pFile);
+    status = (CalcChecksum(CRC32_HEAD_OFFSET) !=
+              (uint32_t)ReadInt(CRC32_HEAD_OFFSET))
+                 ? PageStatus::INVALID
+                 : PageStatus::VALID;
   }
 
-  if (_pageStatus == PageStatus::VALID) {
+  if (status == PageStatus::VALID) {
     _bDirty = false;
     Init();
-    ThreadPool::InstMain().AddTasks(_waitTasks);
-    _waitTasks.clear();
+
+    // Set status under _taskLock, so PushWaitTask will not add new task after
+    // the waiting tasks have been taken out.
+    MVector<Task *> vctTask;
+    {
+      unique_lock<SpinMutex> tlock(_taskLock);
+      _pageStatus = status;
+      vctTask.swap(_waitTasks);
+    }
+    ThreadPool::InstMain().AddTasks(vctTask);
+  } else {
+    _pageStatus = status;
   }
 
   lock.unlock();
@@ -93,30 +100,40 @@ void CachePage::ReadPage(PageFile *pageFile) {
 
 void CachePage::WritePage(PageFile *pageFile) {
   PageFile *pFile =
-      (pageFile == nullptr ? _indexTree->ApplyPageFile() : pageFile);
+      (pageFile == nullptr ? _indexTree->GetPageFile() : pageFile);
   unique_lock<SpinMutex> lock(_pageLock);
   _bDirty = false;
+  FillCrc32();
+  pFile->WritePage(GetFileOffset(), (char *)_bysPage, GetPageLength());
+}
+
+void CachePage::LockForWrite() {
+  assert(IsBatchWritable());
+  _pageLock.lock();
+  _bDirty = false;
+  FillCrc32();
+}
 
+void CachePage::FillCrc32() {
   if (_pageId != PAGE_NULL_POINTER) {
     if (_pageType != PageType::OVERFLOW_PAGE) {
-      crc32.reset();
-      crc32.process_bytes(_bysPage, CRC32_PAGE_OFFSET);
-      *((int *)&_bysPage[CRC32_PAGE_OFFSET]) = crc32.checksum();
+      *((int *)&_bysPage[CRC32_PAGE_OFFSET]) = CalcChecksum(CRC32_PAGE_OFFSET);
     }
-
-    pFile->WritePage(Configure::GetDiskClusterSize() +
-                         _pageId * Configure::GetCachePageSize(),
-                     (char *)_bysPage, (uint32_t)Configure::GetCachePageSize());
   } else {
-    crc32.reset();
-    crc32.process_bytes(_bysPage, CRC32_HEAD_OFFSET);
-    *((int *)&_bysPage[CRC32_HEAD_OFFSET]) = crc32.checksum();
-
-    pFile->WritePage(0, (char *)_bysPage,
-                     (uint32_t)Configure::GetDiskClusterSize());
-  }
-  if (pageFile == nullptr) {
-    _indexTree->ReleasePageFile(pFile);
+    *((int *)&_bysPage[CRC32_HEAD_OFFSET]) = CalcChecksum(CRC32_HEAD_OFFSET);
   }
 }
+
+uint32_t CachePage::CalcChecksum(uint32_t len) {
+  if (UseCrc32c())
+    return Crc32c(_bysPage, len);
+
+  crc32.reset();
+  crc32.process_bytes(_bysPage, len);
+  return crc32.checksum();
+}
+
+bool CachePage::UseCrc32c() {
+  return _indexTree->GetHeadPage()->IsCrc32cFile();
+}
 } // namespace storage
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "../cache/CachePool.h"
 #include "../config/Configure.h"
+#include "../file/AsyncIo.h"
 #include "../file/PageFile.h"
 #include "../header.h"
 #include "../utils/BytesFuncs.h"
@@ -35,6 +36,10 @@ public:
   inline static uint64_t CalcHashCode(uint64_t fileId, uint32_t pageId) {
     return (fileId << 32) + pageId;
   }
+  // The position in index file for the page, not for head page
+  inline static uint64_t CalcFileOffset(PageID pageId) {
+    return HEAD_PAGE_SIZE + (uint64_t)pageId * CACHE_PAGE_SIZE;
+  }
 
 public:
   static void *operator new(size_t size) {
@@ -49,6 +54,19 @@ public:
   void DecRef(int num = 1);
   virtual void ReadPage(PageFile *pageFile = nullptr);
   virtual void WritePage(PageFile *pageFile = nullptr);
+  // Called after _bysPage has been loaded by AsyncIo or PageReadScheduler, to
+  // verify crc32 and wake up the waiting tasks.
+  void AfterAsyncRead();
+  // Used by StoragePool to write continuous pages with one call. Lock the page,
+  // clear dirty flag and fill crc32, then the caller can write _bysPage and
+  // call UnlockForWrite after written.
+  void LockForWrite();
+  inline void UnlockForWrite() { _pageLock.unlock(); }
+  // Only the pages that use CachePage::WritePage can be written in batch.
+  inline bool IsBatchWritable() const {
+    return _pageType != PageType::HEAD_PAGE &&
+           _pageType != PageType::OVERFLOW_PAGE;
+  }
   virtual void Init() {}
 
   inline ReentrantSharedSpinMutex &GetLock() { return _rwLock; }
@@ -57,6 +75,15 @@ public:
   inline PageID GetPageId() const { return _pageId; }
   inline void UpdateAccessTime() { _dtPageLastAccess = MicroSecTime(); }
   inline uint64_t GetAccessTime() const { return _dtPageLastAccess; }
+  // Mark this page has been visited again after added into PageBufferPool.
+  inline void SetReferenced() {
+    if (!_bReferenced.load(memory_order_relaxed))
+      _bReferenced.store(true, memory_order_relaxed);
+  }
+  inline bool TestAndClearReferenced() {
+    return _bReferenced.load(memory_order_relaxed) &&
+           _bReferenced.exchange(false, memory_order_relaxed);
+  }
   inline uint64_t HashCode() const { return CalcHashCode(_fileId, _pageId); }
   inline void UpdateWriteTime() { _dtPageLastWrite = MicroSecTime(); }
   inline uint64_t GetWriteTime() const { return _dtPageLastWrite; }
@@ -66,14 +93,61 @@ public:
   inline IndexTree *GetIndexTree() const { return _indexTree; }
   inline Byte *GetBysPage() const { return _bysPage; }
   inline PageType GetPageType() const { return _pageType; }
+  inline uint64_t GetFileOffset() const {
+    return _pageId == PAGE_NULL_POINTER ? 0 : CalcFileOffset(_pageId);
+  }
+  inline uint32_t GetPageLength() const {
+    return _pageId == PAGE_NULL_POINTER ? HEAD_PAGE_SIZE : CACHE_PAGE_SIZE;
+  }
   virtual bool Releaseable() { return _refCount == 1; }
+  /**Called by PageBufferPool with the page table bucket locked. Mark this page
+   * evicted before checking it, so a thread getting it by a swizzled pointer
+   * either increases the reference before the check or sees the mark.*/
+  bool TryEvict() {
+    _bEvicted.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (Releaseable())
+      return true;
+
+    _bEvicted.store(false, memory_order_relaxed);
+    return false;
+  }
+  inline bool IsEvicted() const {
+    return _bEvicted.load(memory_order_relaxed);
+  }
   inline bool IsLocked() const { return _rwLock.is_locked(); }
   inline void ReadLock() { _rwLock.lock_shared(); }
   inline bool ReadTryLock() { return _rwLock.try_lock_shared(); }
   inline void ReadUnlock() { _rwLock.unlock_shared(); }
-  inline void WriteLock() { _rwLock.lock(); }
-  inline bool WriteTryLock() { return _rwLock.try_lock(); }
-  inline void WriteUnlock() { _rwLock.unlock(); }
+  inline void WriteLock() {
+    _rwLock.lock();
+    if (_rwLock.reentrant_count() == 1)
+      _version.fetch_add(1, memory_order_acquire);
+  }
+  inline bool WriteTryLock() {
+    if (!_rwLock.try_lock())
+      return false;
+    if (_rwLock.reentrant_count() == 1)
+      _version.fetch_add(1, memory_order_acquire);
+    return true;
+  }
+  inline void WriteUnlock() {
+    if (_rwLock.reentrant_count() == 1)
+      _version.fetch_add(1, memory_order_release);
+    _rwLock.unlock();
+  }
+  /**Start an optimistic read without lock, the caller must be in a
+   * PageBufferPool::ReadGuard. Return false if a writer holds the lock.*/
+  inline bool ReadVersion(uint64_t &version) const {
+    version = _version.load(memory_order_acquire);
+    return (version & 1) == 0;
+  }
+  /**Check if the data read after ReadVersion is still valid: no writer has
+   * locked this page and it has not been evicted since then.*/
+  inline bool ValidateVersion(uint64_t version) const {
+    atomic_thread_fence(memory_order_acquire);
+    return _version.load(memory_order_relaxed) == version && !IsEvicted();
+  }
   inline int32_t GetRefCount() { return _refCount.load(memory_order_relaxed); }
   inline bool IsWriteOverTime(uint64_t microSecs) {
     return MicroSecTime() - _dtPageLastWrite > microSecs;
@@ -157,6 +231,15 @@ public:
 
 protected:
   virtual ~CachePage();
+  // Verify the loaded data, set page status and wake up waiting tasks. The
+  // lock must hold _pageLock and will be unlocked before return.
+  void AfterRead(unique_lock<SpinMutex> &lock);
+  // Calculate crc32 and save it at the end of page.
+  void FillCrc32();
+  // Calculate the checksum for the first len bytes in _bysPage.
+  uint32_t CalcChecksum(uint32_t len);
+  // If the checksum is CRC32C or the legacy CRC32, decided by file version.
+  virtual bool UseCrc32c();
 
 protected:
   // To save waiting tasks when reading from disk
@@ -167,6 +250,9 @@ protected:
   Byte *_bysPage = nullptr;
   // Read write lock.
   ReentrantSharedSpinMutex _rwLock;
+  // Increased when _rwLock is write locked and unlocked, so it is odd when a
+  // writer is changing this page, used by optimistic reads.
+  atomic<uint64_t> _version{0};
   // Locked when read from or write to disk
   SpinMutex _pageLock;
   condition_variable_any _pageCv;
@@ -197,6 +283,10 @@ protected:
   atomic_bool _bInDivid = false;
   // If this page has been added StoragePool queue.
   atomic_bool _bInStorage = false;
+  // Reference bit for CLOCK in PageBufferPool, set when got from the pool.
+  atomic_bool _bReferenced = false;
+  // If this page has been removed from PageBufferPool.
+  atomic_bool _bEvicted = false;
 };
 
 class ReadPageTask : public Task {
@@ -216,6 +306,29 @@ public:
     _page->DecRef();
   }
 
+protected:
+  CachePage *_page;
+};
+
+// Load page by AsyncIo, the thread will not be blocked when read from disk.
+class AsyncReadPageTask : public AsyncIoTask {
+public:
+  AsyncReadPageTask(CachePage *page, PageFile *pageFile)
+      : AsyncIoTask(pageFile, page->GetFileOffset(),
+                    (char *)page->GetBysPage(), page->GetPageLength()),
+        _page(page) {
+    page->IncRef();
+  }
+
+  void IoComplete() override {
+    _page->AfterAsyncRead();
+    if (_page->GetPageStatus() != PageStatus::VALID) {
+      // In following time will add code to fix page;
+      abort();
+    }
+    _page->DecRef();
+  }
+
 protected:
   CachePage *_page;
 };
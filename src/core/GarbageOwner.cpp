@@ -52,6 +52,8 @@ void GarbageOwner::ReleasePage(PageID pid, uint16_t num) {
   unique_lock<ReentrantSpinMutex> lock(_spinMutex);
   if (_treeFreePage.size() == 0) {
     InsertPage(pid, num);
+    _totalGarbagePages += num;
+    _bDirty = true;
     return;
   }
 
@@ -62,11 +64,13 @@ void GarbageOwner::ReleasePage(PageID pid, uint16_t num) {
     r.num = iter->second;
   }
 
-  iter--;
-  if (iter != _treeFreePage.end() && iter->first + iter->second == pid) {
-    l.merge = true;
-    l.id = iter->first;
-    l.num = iter->second;
+  if (iter != _treeFreePage.begin()) {
+    iter--;
+    if (iter->first + iter->second == pid) {
+      l.merge = true;
+      l.id = iter->first;
+      l.num = iter->second;
+    }
   }
 
   if (l.merge && (int)num + l.num < UINT16_MAX) {
@@ -1,6 +1,8 @@
 ﻿#include "HeadPage.h"
 #include "IndexTree.h"
 #include "PageType.h"
+#include "../utils/Log.h"
+#include "../utils/Utilitys.h"
 
 namespace storage {
 const uint16_t HeadPage::MAX_RECORD_VERSION_COUNT = 8;
@@ -25,12 +27,33 @@ const uint16_t HeadPage::AUTO_INCREMENT_KEY2 = 64;
 const uint16_t HeadPage::AUTO_INCREMENT_KEY3 = 72;
 const uint16_t HeadPage::CURRENT_RECORD_STAMP_OFFSET = 80;
 const uint16_t HeadPage::RECORD_VERSION_STAMP_OFFSET = 128;
+const uint16_t HeadPage::ALLOCATED_PAGES_COUNT_OFFSET = 88;
+
+/**Allocate next extent for index file, it holds the index tree by the pages
+ * count increased before created, and releases it after finished.*/
+class FileExtendTask : public Task {
+public:
+  FileExtendTask(IndexTree *indexTree) : _indexTree(indexTree) {}
+  bool IsSmallTask() override { return false; }
+  void Run() override {
+    _status = TaskStatus::RUNNING;
+    _indexTree->GetHeadPage()->ExtendFile();
+    _status = TaskStatus::FINISHED;
+    _indexTree->DecPages();
+  }
+
+protected:
+  IndexTree *_indexTree;
+};
 
 void HeadPage::ReadPage(PageFile *pageFile) {
   lock_guard<SpinMutex> lock(_spinMutex);
   CachePage::ReadPage(pageFile);
   assert((PageType)ReadByte(PAGE_TYPE_OFFSET) == PageType::HEAD_PAGE);
-  assert(CURRENT_FILE_VERSION == ReadFileVersion());
+  _fileVersion = ReadFileVersion();
+  _bCrc32c = IsCrc32cFileVersion(_fileVersion);
+  _bKeyPrefix = IsKeyPrefixFileVersion(_fileVersion);
+  assert(IsSupportedFileVersion(_fileVersion));
 
   _indexType = (IndexType)ReadByte(INDEX_TYPE_OFFSET);
   _keyAlterableFieldCount = ReadShort(KEY_ALTERABLE_FIELD_COUNT_OFFSET);
@@ -38,6 +61,11 @@ void HeadPage::ReadPage(PageFile *pageFile) {
 
   _totalPageCount.store(ReadInt(TOTAL_PAGES_COUNT_OFFSET),
                         memory_order_relaxed);
+  // The old files have not saved allocated pages, they grew page by page.
+  _allocatedPageCount.store(
+      max((uint32_t)ReadInt(ALLOCATED_PAGES_COUNT_OFFSET),
+          (uint32_t)ReadInt(TOTAL_PAGES_COUNT_OFFSET)),
+      memory_order_relaxed);
   _rootPageId.store(ReadInt(ROOT_PAGE_OFFSET), memory_order_relaxed);
   _beginLeafPageId.store(ReadInt(BEGIN_LEAF_PAGE_OFFSET), memory_order_relaxed);
   _endLeafPageId.store(ReadInt(END_LEAF_PAGE_OFFSET), memory_order_relaxed);
@@ -71,6 +99,8 @@ void HeadPage::WritePage(PageFile *pageFile) {
   WriteLong(TOTAL_PAGES_COUNT_OFFSET,
             _totalPageCount.load(memory_order_relaxed));
   WriteFileVersion();
+  WriteInt(ALLOCATED_PAGES_COUNT_OFFSET,
+           _allocatedPageCount.load(memory_order_relaxed));
   WriteLong(ROOT_PAGE_OFFSET, _rootPageId.load(memory_order_relaxed));
   WriteLong(BEGIN_LEAF_PAGE_OFFSET,
             _beginLeafPageId.load(memory_order_relaxed));
@@ -96,13 +126,61 @@ void HeadPage::WritePage(PageFile *pageFile) {
 }
 
 void HeadPage::WriteFileVersion() {
-  WriteShort(FILE_VERSION_OFFSET, CURRENT_FILE_VERSION.GetMajorVersion());
-  WriteByte(FILE_VERSION_OFFSET + 2, CURRENT_FILE_VERSION.GetMinorVersion());
-  WriteByte(FILE_VERSION_OFFSET + 3, CURRENT_FILE_VERSION.GetPatchVersion());
+  WriteShort(FILE_VERSION_OFFSET, _fileVersion.GetMajorVersion());
+  WriteByte(FILE_VERSION_OFFSET + 2, _fileVersion.GetMinorVersion());
+  WriteByte(FILE_VERSION_OFFSET + 3, _fileVersion.GetPatchVersion());
   _bDirty = true;
   _bHeadChanged = true;
 }
 
+void HeadPage::StartExtendFile() {
+  // After closed, the tree may be destroyed before the task runs.
+  if (_indexTree->IsClosed() ||
+      _bExtending.exchange(true, memory_order_acq_rel))
+    return;
+
+  if (!_indexTree->TryIncPages()) {
+    _bExtending.store(false, memory_order_release);
+    return;
+  }
+
+  ThreadPool::InstMain().AddTask(new FileExtendTask(_indexTree), false);
+}
+
+void HeadPage::ExtendFile() {
+  uint32_t minPages = Configure::GetMinExtentPages();
+  uint32_t maxPages = Configure::GetMaxExtentPages();
+  DT_MilliSec now = MilliSecTime();
+  if (_lastExtendTime > 0 && now >= _lastExtendTime) {
+    // The last extent was used up in one second, the next one should be
+    // larger; If it took more than one minute, the extent is too large.
+    if (now - _lastExtendTime < 1000) {
+      _extentPages = min(_extentPages * 2, maxPages);
+    } else if (now - _lastExtendTime > 60000) {
+      _extentPages = max(_extentPages / 2, minPages);
+    }
+  }
+  _lastExtendTime = now;
+
+  uint32_t start = _allocatedPageCount.load(memory_order_relaxed);
+  uint32_t end = max(start, _totalPageCount.load(memory_order_relaxed)) +
+                 _extentPages;
+  bool b = _indexTree->GetPageFile()->Allocate(
+      HEAD_PAGE_SIZE + (uint64_t)start * CACHE_PAGE_SIZE,
+      (uint64_t)(end - start) * CACHE_PAGE_SIZE);
+
+  if (b) {
+    _allocatedPageCount.store(end, memory_order_relaxed);
+    _bDirty = true;
+    _bHeadChanged = true;
+  } else {
+    // Not supported by file system, the file will grow by page writes.
+    _extentPages = 0;
+  }
+
+  _bExtending.store(false, memory_order_release);
+}
+
 FileVersion HeadPage::ReadFileVersion() {
   FileVersion fs(ReadShort(FILE_VERSION_OFFSET),
                  ReadByte(FILE_VERSION_OFFSET + 2),
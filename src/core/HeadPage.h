@@ -62,6 +62,15 @@ public:
   static const uint16_t CURRENT_RECORD_STAMP_OFFSET;
   /**The offset to save the version's stamps and time for this table*/
   static const uint16_t RECORD_VERSION_STAMP_OFFSET;
+  /**The offset to save how many pages have been preallocated in file*/
+  static const uint16_t ALLOCATED_PAGES_COUNT_OFFSET;
+
+protected:
+  // Add a task to allocate next extent if there is not one running.
+  void StartExtendFile();
+  // The head page is verified before the version is loaded, so decide the
+  // checksum by the version saved in its own buffer.
+  bool UseCrc32c() override { return IsCrc32cFileVersion(ReadFileVersion()); }
 
 protected:
   /**How many length alterable columns in key*/
@@ -99,6 +108,21 @@ protected:
   SpinMutex _spinMutex;
   // HeadPage has changed or not
   bool _bHeadChanged = false;
+  /**The pages have been preallocated in file by extents, include the pages
+   * in use*/
+  atomic<uint32_t> _allocatedPageCount{0};
+  /**How many pages to allocate in next extent, 0 means do not preallocate*/
+  uint32_t _extentPages = Configure::GetMinExtentPages();
+  /**The time when allocated last extent*/
+  DT_MilliSec _lastExtendTime = 0;
+  /**If there is a task to allocate next extent*/
+  atomic_bool _bExtending{false};
+  /**The version of this index file, the old files keep their version*/
+  FileVersion _fileVersion = CURRENT_FILE_VERSION;
+  /**If the pages in this file use CRC32C as checksum*/
+  bool _bCrc32c = IsCrc32cFileVersion(CURRENT_FILE_VERSION);
+  /**If the branch pages in this file save the common prefix of keys*/
+  bool _bKeyPrefix = IsKeyPrefixFileVersion(CURRENT_FILE_VERSION);
 
 public:
   HeadPage(IndexTree *indexTree)
@@ -108,6 +132,17 @@ public:
   void WritePage(PageFile *pageFile = nullptr) override;
   void WriteFileVersion();
   FileVersion ReadFileVersion();
+  // Only used to create index file with an older version, all pages in the file
+  // will use the checksum and page format of that version.
+  void SetFileVersion(const FileVersion &fv) {
+    _fileVersion = fv;
+    _bCrc32c = IsCrc32cFileVersion(fv);
+    _bKeyPrefix = IsKeyPrefixFileVersion(fv);
+    WriteFileVersion();
+  }
+  inline const FileVersion &GetFileVersion() { return _fileVersion; }
+  inline bool IsCrc32cFile() { return _bCrc32c; }
+  inline bool IsKeyPrefixFile() { return _bKeyPrefix; }
 
   inline Byte ReadRecordVersionCount() { return (Byte)_mapVerStamp.size(); }
   // Only after the entire table was locked, here can update record version. so here do
@@ -168,8 +203,24 @@ public:
   }
 
   inline PageID GetAndIncTotalPageCount(uint32_t pageNum = 1) {
-    return _totalPageCount.fetch_add(pageNum, memory_order_relaxed);
+    PageID pid = _totalPageCount.fetch_add(pageNum, memory_order_relaxed);
+    // Allocate next extent in advance when less than half of the last one is
+    // free, so the new pages are normally written into allocated blocks.
+    if (_extentPages > 0 &&
+        pid + pageNum + _extentPages / 2 >=
+            _allocatedPageCount.load(memory_order_relaxed)) {
+      StartExtendFile();
+    }
+    return pid;
+  }
+
+  inline uint32_t ReadAllocatedPageCount() {
+    return _allocatedPageCount.load(memory_order_relaxed);
   }
+  inline uint32_t GetExtentPages() { return _extentPages; }
+  inline bool IsExtending() { return _bExtending.load(memory_order_acquire); }
+  // Allocate next extent in file, it is called in a task from thread pool.
+  void ExtendFile();
 
   inline uint32_t ReadTotalPageCount() {
     return _totalPageCount.load(memory_order_relaxed);
@@ -1,6 +1,7 @@
 ﻿#include "IndexPage.h"
 #include "../binlog/LogRecord.h"
 #include "../binlog/LogServer.h"
+#include "../pool/PageBufferPool.h"
 #include "../pool/PageDividePool.h"
 #include "../pool/StoragePool.h"
 #include "BranchPage.h"
@@ -10,6 +11,7 @@
 
 namespace storage {
 const uint16_t IndexPage::LOAD_FACTOR = 90;
+const uint16_t IndexPage::MERGE_FACTOR = 30;
 const uint32_t IndexPage::LOAD_THRESHOLD = CachePage::CACHE_PAGE_SIZE * 3;
 const uint16_t IndexPage::PAGE_LEVEL_OFFSET = 0;
 const uint16_t IndexPage::PAGE_BEGIN_END_OFFSET = 1;
@@ -60,14 +62,19 @@ bool IndexPage::PageDivide() {
     BranchRecord br(_indexTree, _vctRecord[_recordNum - 1], GetPageId());
     bool bFind;
     posInParent = parentPage->SearchRecord(br, bFind);
-    if (!bFind)
+    // The separator maybe truncated and greater than the last record, then
+    // it is the first record after the search position.
+    if (posInParent >= (int)parentPage->GetRecordNumber())
       posInParent = parentPage->GetRecordNumber() - 1;
     brParentOld = parentPage->DeleteRecord(posInParent);
   }
 
   // System.out.println("pageDivide");
-  // Calc this page's records
-  int maxLen = GetMaxDataLength() * LOAD_FACTOR / 100;
+  // Calc this page's records. The left pages divided from the right edge by
+  // appended records will not be inserted into, fill them fully.
+  bool bAppend = IsAppendOnly();
+  int maxLen = bAppend ? GetMaxDataLength()
+                       : GetMaxDataLength() * LOAD_FACTOR / 100;
   int pos = 0;
   int len = 0;
   int refCount = 0;
@@ -150,16 +157,30 @@ bool IndexPage::PageDivide() {
   }
 
   _vctRecord.erase(_vctRecord.begin() + pos, _vctRecord.end());
+  _insertCount = 0;
+  _appendCount = 0;
+
+  // The last new page is not counted, the following records are inserted
+  // into it.
+  uint64_t fillLen = _totalDataLength;
+  for (size_t i = 0; i + 1 < vctPage.size(); i++) {
+    fillLen += vctPage[i]->_totalDataLength;
+  }
+  _indexTree->AddDivideStat(bAppend, (uint32_t)vctPage.size(), fillLen,
+                            GetMaxDataLength());
 
   // Insert this page' key and id to parent page
   RawRecord *last = _vctRecord[_vctRecord.size() - 1];
-  BranchRecord *rec = new BranchRecord(_indexTree, last, GetPageId());
+  BranchRecord *rec =
+      CreateSeparator(last, vctPage[0]->_vctRecord[0], GetPageId());
   parentPage->InsertRecord(rec, posInParent);
   posInParent++;
 
   if (_absoBuf == nullptr && refCount > 0) {
     _absoBuf = new AbsoleteBuffer(_bysPage, refCount);
   }
+  // The children moved into new pages, to update their parent page ids.
+  MVector<pair<PageID, PageID>> vctChild;
   // Insert new page' key and id to parent page
   for (int i = 0; i < vctPage.size(); i++) {
     IndexPage *indexPage = vctPage[i];
@@ -169,6 +190,9 @@ bool IndexPage::PageDivide() {
     if (i == vctPage.size() - 1 && brParentOld != nullptr &&
         brParentOld->CompareTo(*last) > 0) {
       rec = new BranchRecord(_indexTree, brParentOld, indexPage->GetPageId());
+    } else if (i < vctPage.size() - 1) {
+      rec = CreateSeparator(last, vctPage[i + 1]->_vctRecord[0],
+                            indexPage->GetPageId());
     } else {
       rec = new BranchRecord(_indexTree, last, indexPage->GetPageId());
     }
@@ -178,6 +202,9 @@ bool IndexPage::PageDivide() {
 
     for (RawRecord *rr : indexPage->_vctRecord) {
       rr->SetParentPage(indexPage);
+      if (level > 0)
+        vctChild.push_back({((BranchRecord *)rr)->GetChildPageId(),
+                            indexPage->GetPageId()});
     }
   }
 
@@ -190,6 +217,9 @@ bool IndexPage::PageDivide() {
       new LogPageDivid(0, nullptr, 0, parentPage->GetPageId(), vctLog, this);
   LogServer::PushRecord(ld);
 
+  // Save the branch records into _bysPage at once, or else the optimistic
+  // reads can not search the page until PageDividePool saves it.
+  parentPage->SaveRecords();
   parentPage->WriteUnlock();
 
   if (level == 0) {
@@ -230,6 +260,8 @@ bool IndexPage::PageDivide() {
   for (int i = 0; i < vctPage.size(); i++) {
     IndexPage *indexPage = vctPage[i];
     indexPage->_bRecordUpdate = true;
+    if (level > 0)
+      indexPage->SaveRecords();
     PageDividePool::AddPage(indexPage, false);
     indexPage->WriteUnlock();
   }
@@ -239,10 +271,287 @@ bool IndexPage::PageDivide() {
   }
 
   _bRecordUpdate = true;
-  // SaveRecords();
+  if (level > 0)
+    SaveRecords();
   PageDividePool::AddPage(parentPage, false);
   StoragePool::AddPage(_indexTree->GetHeadPage(), false);
 
+  for (auto &pr : vctChild) {
+    IndexPage *child = _indexTree->GetPage(
+        pr.first, level == 1 ? PageType::LEAF_PAGE : PageType::BRANCH_PAGE,
+        true);
+    child->SetParentPageID(pr.second);
+    child->SetDirty(true);
+    PageDividePool::AddPage(child, false);
+  }
+
+  return true;
+}
+
+// Load the records from _bysPage to move them between pages.
+static void LoadPageRecords(IndexPage *page) {
+  if (page->GetPageLevel() == 0)
+    ((LeafPage *)page)->LoadRecords();
+  else
+    ((BranchPage *)page)->LoadRecords();
+}
+
+// The records moved from other page still refer to the bytes of that page,
+// they must be saved before that page releases its bytes. Here SaveRecords
+// only fails when a thread is writing the page to disk, so wait for it.
+static void SaveMovedRecords(IndexPage *page) {
+  while (!page->SaveRecords())
+    std::this_thread::yield();
+}
+
+bool IndexPage::PageMerge() {
+  if (_parentPageId == PAGE_NULL_POINTER || _tranCount > 0 || !SaveRecords())
+    return false;
+
+  BranchPage *parentPage = (BranchPage *)_indexTree->GetPage(
+      _parentPageId, PageType::BRANCH_PAGE, true);
+  if (!parentPage->WriteTryLock()) {
+    parentPage->DecRef();
+    return false;
+  }
+
+  // The parent page id of children is not updated when a branch page is
+  // divided, so find this page in parent by id.
+  int32_t pos = -1;
+  for (int32_t i = 0; i < (int32_t)parentPage->GetRecordNumber(); i++) {
+    if (parentPage->GetChildPageId(i, false) == GetPageId()) {
+      pos = i;
+      break;
+    }
+  }
+
+  if (pos < 0 || parentPage->GetRecordNumber() < 2) {
+    parentPage->WriteUnlock();
+    parentPage->DecRef();
+    return false;
+  }
+
+  Byte level = GetPageLevel();
+  PageType type = (level == 0 ? PageType::LEAF_PAGE : PageType::BRANCH_PAGE);
+  // Prefer the left sibling, the right sibling only for the first child.
+  bool bLeft = (pos > 0);
+  IndexPage *sibPage = _indexTree->GetPage(
+      parentPage->GetChildPageId(bLeft ? pos - 1 : pos + 1, false), type,
+      true);
+  bool bLocked = sibPage->WriteTryLock();
+  uint32_t totalLen = _totalDataLength + sibPage->_totalDataLength;
+  bool bMerge = (totalLen <= GetMaxDataLength() * LOAD_FACTOR / 100U);
+
+  // The leaf page out of the pair, its pointer to the removed page need to
+  // be changed.
+  LeafPage *outerPage = nullptr;
+  // Only leaf pages are balanced, except the last page that the appended
+  // records are inserted into.
+  bool bPassed = bLocked && sibPage->GetPageLevel() == level &&
+                 sibPage->_tranCount == 0 &&
+                 (bMerge || (level == 0 && !IsEndPage())) &&
+                 sibPage->SaveRecords();
+  if (bPassed && bMerge && level == 0) {
+    PageID outerId = bLeft ? ((LeafPage *)this)->GetNextPageId()
+                           : ((LeafPage *)this)->GetPrevPageId();
+    if (outerId != PAGE_NULL_POINTER) {
+      outerPage =
+          (LeafPage *)_indexTree->GetPage(outerId, PageType::LEAF_PAGE, true);
+      if (!outerPage->WriteTryLock()) {
+        outerPage->DecRef();
+        outerPage = nullptr;
+        bPassed = false;
+      }
+    }
+  }
+
+  if (!bPassed) {
+    if (bLocked)
+      sibPage->WriteUnlock();
+    sibPage->DecRef();
+    parentPage->WriteUnlock();
+    parentPage->DecRef();
+    return false;
+  }
+
+  LoadPageRecords(this);
+  LoadPageRecords(sibPage);
+
+  if (!bMerge) {
+    // Move the records next to this page from sibling until this page has
+    // about half of the total length.
+    uint32_t maxLen = GetMaxDataLength();
+    size_t sz = sibPage->_vctRecord.size();
+    size_t num = 0;
+    uint32_t len = 0;
+    while (num + 1 < sz && _totalDataLength + len < totalLen / 2) {
+      RawRecord *rr = sibPage->_vctRecord[bLeft ? sz - 1 - num : num];
+      uint32_t rl = rr->GetTotalLength() + UI16_LEN;
+      if (_totalDataLength + len + rl > maxLen)
+        break;
+      len += rl;
+      num++;
+    }
+
+    auto iterBegin = bLeft ? sibPage->_vctRecord.end() - num
+                           : sibPage->_vctRecord.begin();
+    auto iterEnd = iterBegin + num;
+    for (auto iter = iterBegin; iter != iterEnd; iter++) {
+      (*iter)->SetParentPage(this);
+    }
+    _vctRecord.insert(bLeft ? _vctRecord.begin() : _vctRecord.end(),
+                      iterBegin, iterEnd);
+    sibPage->_vctRecord.erase(iterBegin, iterEnd);
+
+    _recordNum += (uint32_t)num;
+    _totalDataLength += len;
+    sibPage->_recordNum -= (uint32_t)num;
+    sibPage->_totalDataLength -= len;
+    _bRecordUpdate = true;
+    sibPage->_bRecordUpdate = true;
+    SetDirty(true);
+    sibPage->SetDirty(true);
+
+    // Replace the separator of the left page in parent
+    IndexPage *leftPage = bLeft ? sibPage : this;
+    IndexPage *rightPage = bLeft ? this : sibPage;
+    int32_t posLeft = bLeft ? pos - 1 : pos;
+    BranchRecord *brOld = parentPage->DeleteRecord(posLeft);
+    BranchRecord *rec = CreateSeparator(leftPage->_vctRecord.back(),
+                                        rightPage->_vctRecord[0],
+                                        leftPage->GetPageId());
+    parentPage->InsertRecord(rec, posLeft);
+    delete brOld;
+
+    SaveMovedRecords(this);
+    SaveMovedRecords(sibPage);
+    parentPage->SaveRecords();
+    parentPage->WriteUnlock();
+    PageDividePool::AddPage(parentPage, false);
+    sibPage->WriteUnlock();
+    PageDividePool::AddPage(sibPage, false);
+    return false;
+  }
+
+  // Move all records into sibling
+  MVector<PageID> vctChild;
+  for (RawRecord *rr : _vctRecord) {
+    rr->SetParentPage(sibPage);
+    if (level > 0)
+      vctChild.push_back(((BranchRecord *)rr)->GetChildPageId());
+  }
+  sibPage->_vctRecord.insert(bLeft ? sibPage->_vctRecord.end()
+                                   : sibPage->_vctRecord.begin(),
+                             _vctRecord.begin(), _vctRecord.end());
+  sibPage->_recordNum += _recordNum;
+  sibPage->_totalDataLength += _totalDataLength;
+  sibPage->_bRecordUpdate = true;
+  sibPage->SetDirty(true);
+  if (IsBeginPage())
+    sibPage->SetBeginPage(true);
+  if (IsEndPage())
+    sibPage->SetEndPage(true);
+
+  HeadPage *headPage = _indexTree->GetHeadPage();
+  if (level == 0) {
+    LeafPage *sibLeaf = (LeafPage *)sibPage;
+    if (bLeft) {
+      sibLeaf->SetNextPageId(((LeafPage *)this)->GetNextPageId());
+      if (outerPage != nullptr)
+        outerPage->SetPrevPageId(sibPage->GetPageId());
+      else
+        headPage->WriteEndLeafPagePointer(sibPage->GetPageId());
+    } else {
+      sibLeaf->SetPrevPageId(((LeafPage *)this)->GetPrevPageId());
+      if (outerPage != nullptr)
+        outerPage->SetNextPageId(sibPage->GetPageId());
+      else
+        headPage->WriteBeginLeafPagePointer(sibPage->GetPageId());
+    }
+  }
+
+  // The left sibling takes the separator of this page, the right sibling's
+  // separator is already greater than all records of this page.
+  if (bLeft) {
+    delete parentPage->DeleteRecord(pos - 1);
+    BranchRecord *brOld = parentPage->DeleteRecord(pos - 1);
+    BranchRecord *rec =
+        new BranchRecord(_indexTree, brOld, sibPage->GetPageId());
+    parentPage->InsertRecord(rec, pos - 1);
+    delete brOld;
+  } else {
+    delete parentPage->DeleteRecord(pos);
+  }
+
+  // The root page with only one child is removed, the child is the new root.
+  bool bNewRoot = parentPage->GetParentPageId() == PAGE_NULL_POINTER &&
+                  parentPage->GetRecordNumber() == 1;
+  if (bNewRoot) {
+    sibPage->SetParentPageID(PAGE_NULL_POINTER);
+    sibPage->SetBeginPage(true);
+    sibPage->SetEndPage(true);
+  }
+
+  SaveMovedRecords(sibPage);
+  // The records refer to _bysPage have been moved, only clear them. The prev
+  // and next page ids are kept for the cursors still in this page.
+  _vctRecord.clear();
+  _vctKeyHead.clear();
+  _recordNum = 0;
+  _totalDataLength = 0;
+  _bRecordUpdate = false;
+  SetDirty(false);
+
+  if (bNewRoot) {
+    _indexTree->UpdateRootPage(sibPage);
+    parentPage->SetDirty(false);
+    parentPage->WriteUnlock();
+    PageBufferPool::RemovePage(parentPage);
+  } else {
+    parentPage->SaveRecords();
+    parentPage->WriteUnlock();
+    PageDividePool::AddPage(parentPage, false);
+  }
+
+  if (outerPage != nullptr) {
+    outerPage->SetDirty(true);
+    outerPage->WriteUnlock();
+    PageDividePool::AddPage(outerPage, false);
+  }
+  sibPage->WriteUnlock();
+  PageDividePool::AddPage(sibPage, false);
+  StoragePool::AddPage(headPage, false);
+
+  for (PageID pid : vctChild) {
+    IndexPage *child = _indexTree->GetPage(
+        pid, level == 1 ? PageType::LEAF_PAGE : PageType::BRANCH_PAGE, true);
+    child->SetParentPageID(sibPage->GetPageId());
+    child->SetDirty(true);
+    PageDividePool::AddPage(child, false);
+  }
+
   return true;
 }
+
+BranchRecord *IndexPage::CreateSeparator(RawRecord *left, RawRecord *right,
+                                         PageID pageId) {
+  if (GetPageLevel() > 0 || !_indexTree->GetHeadPage()->IsKeyPrefixFile() ||
+      _indexTree->GetHeadPage()->ReadIndexType() == IndexType::NON_UNIQUE)
+    return new BranchRecord(_indexTree, left, pageId);
+
+  const Byte *bysLeft = left->GetBysValue() + _indexTree->GetKeyOffset();
+  const Byte *bysRight = right->GetBysValue() + _indexTree->GetKeyOffset();
+  uint32_t lenLeft = left->GetKeyLength() - _indexTree->GetKeyVarLen();
+  uint32_t lenRight = right->GetKeyLength() - _indexTree->GetKeyVarLen();
+  uint32_t len = 0;
+  while (len < lenLeft && len < lenRight && bysLeft[len] == bysRight[len])
+    len++;
+
+  // The shortest head of right key that is greater than left key, it must be
+  // less than right key and shorter than left key to be useful.
+  len++;
+  if (len >= lenRight || len >= lenLeft)
+    return new BranchRecord(_indexTree, left, pageId);
+  return new BranchRecord(_indexTree, bysRight, (uint16_t)len, pageId);
+}
 } // namespace storage
@@ -10,6 +10,8 @@
 #define NOT_END_PAGE 0xBF
 
 namespace storage {
+class BranchRecord;
+
 class AbsoleteBuffer {
 public:
   AbsoleteBuffer(Byte *bys, int refCount) : _bys(bys), _refCount(refCount) {}
@@ -42,6 +44,9 @@ public:
   // Percentage for a page to used. if surpass, will split the following records
   // into next page
   static const uint16_t LOAD_FACTOR;
+  // Percentage for a page to used. if below it, will try to merge this page
+  // into a sibling or move records from the sibling, see PageMerge.
+  static const uint16_t MERGE_FACTOR;
   // The max length for a page. If surpass it, will divide this page at once.
   static const uint32_t LOAD_THRESHOLD;
   // Page level, leaf page=0, branch page from 1 start
@@ -75,8 +80,20 @@ public:
   };
   virtual bool SaveRecords() = 0;
   bool PageDivide();
+  /**Merge this page into its left or right sibling under the same parent if
+   * all records can be saved in one page, or else move records from the
+   * sibling until they have the similar length, only for leaf pages. The
+   * caller holds the write lock of this page, all other pages are try locked
+   * and it gives up if failed to lock any one.
+   * @return True if this page has been merged and removed from the tree, the
+   * caller need to pass its reference to PageBufferPool::RemovePage.
+   */
+  bool PageMerge();
 
   inline bool IsOverlength() { return _totalDataLength > LOAD_THRESHOLD; }
+  inline bool IsUnderfull() {
+    return _totalDataLength < GetMaxDataLength() * MERGE_FACTOR / 100U;
+  }
   inline void SetParentPageID(PageID parentPageId) {
     _parentPageId = parentPageId;
   }
@@ -84,7 +101,16 @@ public:
   inline Byte GetPageLevel() { return _bysPage[PAGE_LEVEL_OFFSET]; }
   inline uint32_t GetTotalDataLength() { return _totalDataLength; }
   inline uint32_t GetRecordNumber() { return _recordNum; }
-  bool Releaseable() override { return _refCount == 1 && _tranCount == 0; }
+  // The references held by swizzled pointers in parent pages do not prevent
+  // this page from being evicted. Read _swizzleCount first, see IncSwizzle.
+  bool Releaseable() override {
+    uint32_t sc = _swizzleCount.load();
+    return _refCount == (int32_t)(1 + sc) && _tranCount == 0;
+  }
+  // Called after IncRef when a parent page swizzles a pointer to this page.
+  inline void IncSwizzle() { _swizzleCount.fetch_add(1); }
+  // Called before DecRef when the pointer is unswizzled.
+  inline void DecSwizzle() { _swizzleCount.fetch_sub(1); }
   inline bool IsBeginPage() {
     return _bysPage[PAGE_BEGIN_END_OFFSET] & BEGIN_PAGE;
   }
@@ -100,6 +126,52 @@ public:
              : (_bysPage[PAGE_BEGIN_END_OFFSET] & NOT_END_PAGE);
   }
   inline uint32_t GetTranCount() { return _tranCount; }
+  /**If all records inserted since last divided are appended after the last
+   * record of the last page in its level, such as the auto increment keys.
+   * Then the page is divided at the insertion point and the left pages are
+   * filled to 100% instead of LOAD_FACTOR.*/
+  inline bool IsAppendOnly() {
+    return _insertCount > 0 && _appendCount == _insertCount && IsEndPage();
+  }
+  /**Get the key head to compare with _vctKeyHead: the first 8 bytes of key as
+   * a big endian integer, the shorter key is padded with zero. If two heads
+   * are different, they have the same order as the keys.*/
+  static inline uint64_t CalcKeyHead(const Byte *bys, uint32_t len) {
+    if (len >= sizeof(uint64_t))
+      return BytesSwap64(*((uint64_t *)bys));
+
+    uint64_t head = 0;
+    for (uint32_t i = 0; i < len; i++)
+      head |= (uint64_t)bys[i] << (56 - i * 8);
+    return head;
+  }
+
+protected:
+  // Called before a record is inserted into pos
+  inline void CountInsert(int32_t pos) {
+    _insertCount++;
+    if (pos == (int32_t)_recordNum)
+      _appendCount++;
+  }
+  // The key heads can only be used to search the records in _bysPage.
+  inline bool IsKeyHeadValid() const {
+    return !_bRecordUpdate && _vctRecord.size() == 0 &&
+           _vctKeyHead.size() == _recordNum;
+  }
+  // Compare the key head of the record in pos with head, return 0 if they are
+  // equal and the whole keys need to be compared.
+  inline int CompareKeyHead(uint32_t pos, uint64_t head) const {
+    uint64_t h = _vctKeyHead[pos];
+    return h == head ? 0 : (h < head ? -1 : 1);
+  }
+
+protected:
+  /**Create the branch record for this page or a new page divided from it. The
+   * left is the last record of the page and right is the first record of
+   * next page. For leaf pages of unique index in files with key prefix, the
+   * key is truncated to the shortest bytes between them.*/
+  BranchRecord *CreateSeparator(RawRecord *left, RawRecord *right,
+                                PageID pageId);
 
 protected:
   // When split this page into several pages, the records saved in _bysPage will
@@ -108,6 +180,10 @@ protected:
   AbsoleteBuffer *_absoBuf = nullptr;
   // The vector to save records in this page
   MVector<RawRecord *> _vctRecord;
+  // The key heads of records in _bysPage in a contiguous array, so the binary
+  // search on page bytes need not read the record for most probes. Loaded
+  // after the page is read or saved.
+  MVector<uint64_t> _vctKeyHead;
   // Parent page ID
   uint32_t _parentPageId = 0;
   // Total data length in this page
@@ -116,5 +192,11 @@ protected:
   uint32_t _recordNum = 0;
   // How many records are in transaction status, only used in LeafPage
   uint32_t _tranCount = 0;
+  // How many records have been inserted since last divided, and how many of
+  // them are appended after the last record, see IsAppendOnly.
+  uint32_t _insertCount = 0;
+  uint32_t _appendCount = 0;
+  // How many swizzled pointers in parent pages point to this page
+  atomic<uint32_t> _swizzleCount{0};
 };
 } // namespace storage
@@ -5,8 +5,11 @@
 #include "../utils/Log.h"
 #include "BranchPage.h"
 #include "BranchRecord.h"
+#include "BulkLoader.h"
 #include "IndexPage.h"
 #include "LeafPage.h"
+#include "PageReadScheduler.h"
+#include "PageWarmup.h"
 #include <shared_mutex>
 
 namespace storage {
@@ -36,6 +39,8 @@ bool IndexTree::CreateIndex(const MString &indexName, const MString &fileName,
   }
 
   _fileId = indexId;
+  _pageFile = new PageFile(_fileName.c_str());
+  _readScheduler = new PageReadScheduler(this);
   _headPage = new HeadPage(this);
 
   {
@@ -67,13 +72,14 @@ bool IndexTree::CreateIndex(const MString &indexName, const MString &fileName,
   }
 
   StoragePool::AddPage(_headPage, false);
-  _rootPage = AllocateNewPage(PAGE_NULL_POINTER, 0);
-  _rootPage->SetBeginPage(true);
-  _rootPage->SetEndPage(true);
-  ((LeafPage *)_rootPage)->SetPrevPageId(PAGE_NULL_POINTER);
-  ((LeafPage *)_rootPage)->SetNextPageId(PAGE_NULL_POINTER);
-  _rootPage->SetDirty(true);
-  PageDividePool::AddPage(_rootPage, true);
+  IndexPage *root = AllocateNewPage(PAGE_NULL_POINTER, 0);
+  root->SetBeginPage(true);
+  root->SetEndPage(true);
+  ((LeafPage *)root)->SetPrevPageId(PAGE_NULL_POINTER);
+  ((LeafPage *)root)->SetNextPageId(PAGE_NULL_POINTER);
+  root->SetDirty(true);
+  PageDividePool::AddPage(root, true);
+  _rootPage.store(root, memory_order_release);
 
   _vctKey.swap(vctKey);
   _vctValue.swap(vctVal);
@@ -102,19 +108,25 @@ bool IndexTree::InitIndex(const MString &indexName, const MString &fileName,
       *iter = '/';
   }
 
+  _fileId = indexId;
+  _pageFile = new PageFile(_fileName.c_str());
+  _readScheduler = new PageReadScheduler(this);
   _headPage = new HeadPage(this);
 
   _headPage->ReadPage();
   FileVersion &&fv = _headPage->ReadFileVersion();
-  if (!(fv == CURRENT_FILE_VERSION)) {
+  if (!IsSupportedFileVersion(fv)) {
     _threadErrorMsg.reset(
         new ErrorMsg(TB_ERROR_INDEX_VERSION, {_fileName.c_str()}));
     return false;
   }
 
   uint32_t rootId = _headPage->ReadRootPagePointer();
-  _rootPage = GetPage(
-      rootId, rootId == 0 ? PageType::LEAF_PAGE : PageType::BRANCH_PAGE, true);
+  _rootPage.store(GetPage(rootId,
+                          rootId == 0 ? PageType::LEAF_PAGE
+                                      : PageType::BRANCH_PAGE,
+                          true),
+                  memory_order_release);
 
 #ifdef _DEBUG
   uint16_t count = 0;
@@ -144,6 +156,14 @@ bool IndexTree::InitIndex(const MString &indexName, const MString &fileName,
   }
 
   _garbageOwner = new GarbageOwner(this);
+
+  // Load the hot pages before restart in background.
+  MVector<PageID> vctId;
+  PageBufferPool::TakeWarmupPages(_fileId, vctId);
+  if (vctId.size() > 0) {
+    ThreadPool::InstMain().AddTask(
+        new PageWarmupTask(new PageWarmup(this, vctId)));
+  }
   LOG_DEBUG << "Open index tree " << indexName;
   return true;
 }
@@ -172,10 +192,10 @@ IndexTree::~IndexTree() {
   }
   _mapMutex.clear();
 
-  while (_fileQueue.size() > 0) {
-    delete _fileQueue.front();
-    _fileQueue.pop();
-  }
+  delete _readScheduler;
+  _readScheduler = nullptr;
+  delete _pageFile;
+  _pageFile = nullptr;
 
   if (_funcDestory != nullptr) {
     _funcDestory();
@@ -187,10 +207,11 @@ void IndexTree ::Close(function<void()> funcDestory) {
   unique_lock<SharedSpinMutex> lock(_rootSharedMutex);
   _funcDestory = funcDestory;
   _bClosed = true;
-  if (_rootPage != nullptr) {
-    _rootPage->DecRef();
-    _rootPage = nullptr;
+  IndexPage *root = _rootPage.exchange(nullptr);
+  if (root != nullptr) {
+    root->DecRef();
   }
+  PageBufferPool::SetTreeClosed();
 }
 
 void IndexTree::CloneKeys(VectorDataValue &vct) {
@@ -209,31 +230,28 @@ void IndexTree::CloneValues(VectorDataValue &vct) {
   }
 }
 
-PageFile *IndexTree::ApplyPageFile() {
+bool IndexTree::BulkLoad(const function<LeafRecord *()> &funcNext,
+                         uint16_t loadFactor) {
+  BulkLoader loader(this, loadFactor);
   while (true) {
-    unique_lock<SpinMutex> lock(_fileMutex);
-    _fileCv.wait_for(lock, 1ms, [this] {
-      return _rpfCount < Configure::GetMaxPageFileCount();
-    });
-
-    if (_fileQueue.size() > 0) {
-      PageFile *rpf = _fileQueue.front();
-      _fileQueue.pop();
-      return rpf;
-    } else if (_rpfCount < Configure::GetMaxPageFileCount()) {
-      _rpfCount++;
-      return new PageFile(_fileName.c_str());
-    }
+    LeafRecord *lr = funcNext();
+    if (lr == nullptr)
+      break;
+    if (!loader.AddRecord(lr))
+      return false;
   }
+
+  return loader.Finish();
 }
 
 void IndexTree::UpdateRootPage(IndexPage *root) {
   unique_lock<SharedSpinMutex> lock(_rootSharedMutex);
   _headPage->WriteRootPagePointer(root->GetPageId());
-  if (_rootPage != nullptr) {
-    _rootPage->DecRef();
-    _rootPage = root;
+  IndexPage *old = _rootPage.load(memory_order_relaxed);
+  if (old != nullptr) {
     root->IncRef();
+    _rootPage.store(root, memory_order_release);
+    old->DecRef();
   }
   StoragePool::AddPage(_headPage, false);
 }
@@ -253,14 +271,46 @@ IndexPage *IndexTree::AllocateNewPage(PageID parentId, Byte pageLevel) {
 
   page->SetPageStatus(PageStatus::VALID);
   page->GetBysPage()[IndexPage::PAGE_BEGIN_END_OFFSET] = 0;
-  PageBufferPool::AddPage(page);
+  // Increase first, AddPage maybe evict other pages of this tree.
   IncPages();
+  PageBufferPool::AddPage(page);
 
   LOG_DEBUG << "Allocate new CachePage, pageLevel=" << (int)pageLevel
             << "  pageId=" << newPageId;
   return page;
 }
 
+bool IndexTree::AddLoadedPage(IndexPage *page, uint64_t evictCount) {
+  unique_lock<SpinMutex> lock(_pageMutex);
+  CachePage *cp = PageBufferPool::GetPage(_fileId, page->GetPageId());
+  if (cp != nullptr) {
+    cp->DecRef();
+    return false;
+  }
+
+  // Check after the lookup: if the page was removed from pool before it, the
+  // count has been increased.
+  if (PageBufferPool::GetEvictCount() != evictCount)
+    return false;
+
+  PageBufferPool::AddPage(page);
+  return true;
+}
+
+IndexPage *IndexTree::GetChildPage(BranchPage *parent, PageID pageId,
+                                   bool wait) {
+  IndexPage *page = parent->GetSwizzledChild(pageId);
+  if (page != nullptr)
+    return page;
+
+  page = GetPage(pageId,
+                 parent->GetPageLevel() == 1 ? PageType::LEAF_PAGE
+                                             : PageType::BRANCH_PAGE,
+                 wait);
+  parent->SwizzleChild(page);
+  return page;
+}
+
 IndexPage *IndexTree::GetPage(PageID pageId, PageType type, bool wait) {
   assert(pageId < _headPage->ReadTotalPageCount());
   IndexPage *page = (IndexPage *)PageBufferPool::GetPage(_fileId, pageId);
@@ -281,8 +331,8 @@ IndexPage *IndexTree::GetPage(PageID pageId, PageType type, bool wait) {
       abort();
     }
 
-    PageBufferPool::AddPage(page);
     IncPages();
+    PageBufferPool::AddPage(page);
     _pageMutex.unlock();
 
     if (Configure::GetDiskType() == DiskType::SSD) {
@@ -293,6 +343,10 @@ IndexPage *IndexTree::GetPage(PageID pageId, PageType type, bool wait) {
           // In following time will add code to fix page;
           abort();
         }
+      } else if (AsyncIo::IsRunning()) {
+        // Submit the read request to kernel, the thread will not be blocked
+        // and the waiting tasks will be resumed after the page loaded.
+        AsyncIo::SubmitRead(new AsyncReadPageTask(page, _pageFile));
       } else {
         // For DiskType::SSD, multi threads load the pages at the same time is
         // more fast than single thread.
@@ -302,11 +356,11 @@ IndexPage *IndexTree::GetPage(PageID pageId, PageType type, bool wait) {
 
       return page;
     } else {
-      // For DiskType::HDD, it will rise a large read task and all read requests
-      // will add the queue in large read task, then read one by one according
-      // to the page id.
-      // TO DO
-      abort();
+      // For DiskType::HDD, all read requests are added into the read
+      // scheduler, then a large read task loads them ordered by page id and
+      // merges continuous pages into one read. If the caller will wait, the
+      // pages are loaded in current thread to avoid blocking thread pool.
+      _readScheduler->AddPage(page, wait);
     }
   } else {
     _pageMutex.unlock();
@@ -317,11 +371,97 @@ IndexPage *IndexTree::GetPage(PageID pageId, PageType type, bool wait) {
   return page;
 }
 
+bool IndexTree::SearchOptimistic(const RawKey &key, bool bEdit,
+                                 IndexPage *&page) {
+  PageBufferPool::ReadGuard guard;
+  IndexPage *curr = _rootPage.load(memory_order_acquire);
+  uint64_t version;
+  if (curr == nullptr || curr->GetPageType() != PageType::BRANCH_PAGE ||
+      !curr->ReadVersion(version))
+    return false;
+  // The root page may have been divided and replaced before the version read.
+  if (_rootPage.load(memory_order_acquire) != curr)
+    return false;
+
+  // The page got from PageBufferPool with a reference, if not swizzled.
+  IndexPage *held = nullptr;
+  bool bFound = false;
+  while (true) {
+    PageID childId;
+    if (!((BranchPage *)curr)->SearchKeyOptimistic(key, childId))
+      break;
+
+    IndexPage *child = ((BranchPage *)curr)->PeekSwizzledChild(childId);
+    bool bHeld = false;
+    if (child == nullptr) {
+      child = (IndexPage *)PageBufferPool::GetPage(_fileId, childId);
+      if (child == nullptr)
+        break;
+      bHeld = true;
+    }
+
+    if (child->GetPageStatus() != PageStatus::VALID) {
+      if (bHeld)
+        child->DecRef();
+      break;
+    }
+
+    if (child->GetPageType() == PageType::LEAF_PAGE) {
+      if (!bHeld) {
+        // Pair with the fence in CachePage::TryEvict
+        child->IncRef();
+        atomic_thread_fence(memory_order_seq_cst);
+        if (child->IsEvicted()) {
+          child->DecRef();
+          break;
+        }
+      }
+
+      // Do not wait for the lock in ReadGuard, it blocks PoolManage.
+      bool b = bEdit ? child->WriteTryLock() : child->ReadTryLock();
+      if (b && curr->ValidateVersion(version)) {
+        page = child;
+        bFound = true;
+      } else {
+        if (b) {
+          if (bEdit)
+            child->WriteUnlock();
+          else
+            child->ReadUnlock();
+        }
+        child->DecRef();
+      }
+      break;
+    }
+
+    uint64_t childVersion;
+    if (!child->ReadVersion(childVersion) || !curr->ValidateVersion(version)) {
+      if (bHeld)
+        child->DecRef();
+      break;
+    }
+
+    if (held != nullptr)
+      held->DecRef();
+    held = bHeld ? child : nullptr;
+    curr = child;
+    version = childVersion;
+  }
+
+  if (held != nullptr)
+    held->DecRef();
+  return bFound;
+}
+
 /**
  * @brief
  */
 bool IndexTree::SearchRecursively(const RawKey &key, bool bEdit,
                                   IndexPage *&page, bool bWait) {
+  if (page == nullptr && _bOptimisticSearch &&
+      SearchOptimistic(key, bEdit, page))
+    return true;
+
   if (page != nullptr) {
     if (bEdit && page->GetPageType() == PageType::LEAF_PAGE) {
       page->WriteLock();
@@ -332,15 +472,16 @@ bool IndexTree::SearchRecursively(const RawKey &key, bool bEdit,
     while (true) {
       {
         std::shared_lock<SharedSpinMutex> lock(_rootSharedMutex);
+        IndexPage *root = _rootPage.load(memory_order_relaxed);
         bool b = false;
-        if (bEdit && _rootPage->GetPageType() == PageType::LEAF_PAGE) {
-          b = _rootPage->WriteTryLock();
+        if (bEdit && root->GetPageType() == PageType::LEAF_PAGE) {
+          b = root->WriteTryLock();
         } else {
-          b = _rootPage->ReadTryLock();
+          b = root->ReadTryLock();
         }
 
         if (b) {
-          page = _rootPage;
+          page = root;
           page->IncRef();
 
           if (page->GetPageType() == PageType::LEAF_PAGE)
@@ -362,13 +503,9 @@ bool IndexTree::SearchRecursively(const RawKey &key, bool bEdit,
     BranchPage *bPage = (BranchPage *)page;
     bool bFind;
     uint32_t pos = bPage->SearchKey(key, bFind);
-    BranchRecord *br = bPage->GetRecordByPos(pos, true);
-    uint32_t pageId = ((BranchRecord *)br)->GetChildPageId();
+    uint32_t pageId = bPage->GetChildPageId(pos, true);
 
-    IndexPage *childPage = (IndexPage *)GetPage(
-        pageId,
-        page->GetPageLevel() == 1 ? PageType::LEAF_PAGE : PageType::BRANCH_PAGE,
-        bWait);
+    IndexPage *childPage = GetChildPage(bPage, pageId, bWait);
     assert(childPage != nullptr);
 
     if (childPage->GetPageStatus() != PageStatus::VALID && !bWait) {
@@ -404,15 +541,16 @@ bool IndexTree::SearchRecursively(const LeafRecord &lr, bool bEdit,
     while (page == nullptr) {
       {
         std::shared_lock<SharedSpinMutex> lock(_rootSharedMutex);
+        IndexPage *root = _rootPage.load(memory_order_relaxed);
         bool b = false;
-        if (bEdit && _rootPage->GetPageType() == PageType::LEAF_PAGE) {
-          b = _rootPage->WriteTryLock();
+        if (bEdit && root->GetPageType() == PageType::LEAF_PAGE) {
+          b = root->WriteTryLock();
         } else {
-          b = _rootPage->ReadTryLock();
+          b = root->ReadTryLock();
         }
 
         if (b) {
-          page = _rootPage;
+          page = root;
           page->IncRef();
           if (page->GetPageType() == PageType::LEAF_PAGE)
             return true;
@@ -434,13 +572,9 @@ bool IndexTree::SearchRecursively(const LeafRecord &lr, bool bEdit,
     BranchPage *bPage = (BranchPage *)page;
     bool bFind;
     uint32_t pos = bPage->SearchRecord(br, bFind);
-    BranchRecord *br = bPage->GetRecordByPos(pos, true);
-    uint32_t pageId = br->GetChildPageId();
+    uint32_t pageId = bPage->GetChildPageId(pos, true);
 
-    IndexPage *childPage = (IndexPage *)GetPage(
-        pageId,
-        page->GetPageLevel() == 1 ? PageType::LEAF_PAGE : PageType::BRANCH_PAGE,
-        bWait);
+    IndexPage *childPage = GetChildPage(bPage, pageId, bWait);
     assert(childPage != nullptr);
 
     if (childPage->GetPageStatus() != PageStatus::VALID && !bWait) {
@@ -16,6 +16,8 @@
 namespace storage {
 using namespace std;
 class LeafPage;
+class BranchPage;
+class PageReadScheduler;
 
 struct PageLock {
   PageLock() : _sm(new SpinMutex), _refCount(0) {}
@@ -39,9 +41,21 @@ public:
                  VectorDataValue &vctKey, VectorDataValue &vctVal,
                  uint32_t indexId);
 
+  /**Build this empty tree by the records returned from funcNext in ascending
+   * order until it returns nullptr, see BulkLoader. The pages are filled to
+   * loadFactor percent.
+   * @return False if failed to add a record, the tree is left empty.*/
+  bool BulkLoad(const function<LeafRecord *()> &funcNext, uint16_t loadFactor);
   void UpdateRootPage(IndexPage *root);
   IndexPage *AllocateNewPage(PageID parentId, Byte pageLevel);
   IndexPage *GetPage(PageID pageId, PageType type, bool wait = false);
+  // Get a child page of parent by its swizzled pointer if it is in memory, or
+  // else get it by GetPage and swizzle it.
+  IndexPage *GetChildPage(BranchPage *parent, PageID pageId, bool wait = false);
+  /**Add a page loaded by PageWarmup into PageBufferPool. Failed if the page
+   * is already in pool, or any page has been evicted since evictCount was
+   * taken before the load, then the loaded data maybe out of date.*/
+  bool AddLoadedPage(IndexPage *page, uint64_t evictCount);
   void CloneKeys(VectorDataValue &vct);
   void CloneValues(VectorDataValue &vct);
   // Apply a series of pages for overflow pages. It will search Garbage Pages
@@ -58,7 +72,8 @@ public:
     _garbageOwner->ReleasePage(firstId, num);
   }
 
-  PageFile *ApplyPageFile();
+  inline PageFile *GetPageFile() { return _pageFile; }
+  inline PageReadScheduler *GetReadScheduler() { return _readScheduler; }
   /** @brief Search B+ tree from root according record's key, util find the
    * LeafPage.
    * @param key The record's key to search
@@ -98,13 +113,18 @@ public:
   inline bool IsClosed() { return _bClosed; }
   inline void SetClose() { _bClosed = true; }
   void Close(function<void()> funcDestory = nullptr);
-  inline void ReleasePageFile(PageFile *rpf) {
-    lock_guard<SpinMutex> lock(_fileMutex);
-    _fileQueue.push(rpf);
-  }
-
   inline HeadPage *GetHeadPage() { return _headPage; }
   inline void IncPages() { _pagesInMem.fetch_add(1, memory_order_relaxed); }
+  // Only increase if there are pages in memory, so the related DecPages will
+  // not destroy a tree that is being created or destroyed.
+  inline bool TryIncPages() {
+    int32_t n = _pagesInMem.load(memory_order_relaxed);
+    while (n > 0) {
+      if (_pagesInMem.compare_exchange_weak(n, n + 1, memory_order_relaxed))
+        return true;
+    }
+    return false;
+  }
   inline void DecPages() {
     int ii = _pagesInMem.fetch_sub(1, memory_order_relaxed);
     if (ii == 1) {
@@ -118,6 +138,64 @@ public:
   inline uint16_t GetValOffset() { return _valOffset; }
   inline const VectorDataValue &GetVctKey() const { return _vctKey; }
   inline const VectorDataValue &GetVctValue() const { return _vctValue; }
+  // The read-ahead window left by the last leaf scan, used by LeafReadAhead
+  inline uint32_t GetReadAheadWindow() {
+    return _readAheadWindow.load(memory_order_relaxed);
+  }
+  inline void SetReadAheadWindow(uint32_t window) {
+    _readAheadWindow.store(window, memory_order_relaxed);
+  }
+  /**Set the quota of this tree in PageBufferPool. Its pages are not evicted
+   * when it has no more than minPages in pool, and they are evicted first when
+   * it has more than maxPages. 0 maxPages means no limit.*/
+  inline void SetPoolQuota(uint64_t minPages, uint64_t maxPages) {
+    assert(maxPages == 0 || minPages <= maxPages);
+    _poolMinPages = minPages;
+    _poolMaxPages = maxPages;
+  }
+  inline uint64_t GetPoolMinPages() { return _poolMinPages; }
+  inline uint64_t GetPoolMaxPages() { return _poolMaxPages; }
+  // If pin the branch pages, include root, in PageBufferPool until closed.
+  inline void SetPinBranches(bool b) { _bPinBranches = b; }
+  inline bool IsPinBranches() { return _bPinBranches; }
+  // How many pages of this tree are in PageBufferPool
+  inline uint64_t GetPoolPages() {
+    return _poolPages.load(memory_order_relaxed);
+  }
+  inline void IncPoolPages() { _poolPages.fetch_add(1, memory_order_relaxed); }
+  inline void DecPoolPages() { _poolPages.fetch_sub(1, memory_order_relaxed); }
+  inline bool IsOverPoolQuota() {
+    return _poolMaxPages > 0 && GetPoolPages() > _poolMaxPages;
+  }
+  /**Called after a page is divided. pages is how many pages are filled by
+   * the divide, include the divided page and exclude the last new page, and
+   * dataLen is their total data length.*/
+  inline void AddDivideStat(bool bAppend, uint32_t pages, uint64_t dataLen,
+                            uint32_t maxLen) {
+    _divideCount.fetch_add(1, memory_order_relaxed);
+    if (bAppend)
+      _appendDivideCount.fetch_add(1, memory_order_relaxed);
+    _divideDataLength.fetch_add(dataLen, memory_order_relaxed);
+    _divideCapacity.fetch_add((uint64_t)pages * maxLen, memory_order_relaxed);
+  }
+  // How many times the pages of this tree have been divided
+  inline uint64_t GetDivideCount() {
+    return _divideCount.load(memory_order_relaxed);
+  }
+  // How many divides are at the right edge for appended records
+  inline uint64_t GetAppendDivideCount() {
+    return _appendDivideCount.load(memory_order_relaxed);
+  }
+  // The average fill percentage of the pages filled by divides
+  inline uint32_t GetDivideFillPercent() {
+    uint64_t cap = _divideCapacity.load(memory_order_relaxed);
+    return cap == 0 ? 0
+                    : (uint32_t)(_divideDataLength.load(memory_order_relaxed) *
+                                 100 / cap);
+  }
+  // If search branch pages by optimistic reads, see SearchOptimistic.
+  inline void SetOptimisticSearch(bool b) { _bOptimisticSearch = b; }
+  inline bool IsOptimisticSearch() { return _bOptimisticSearch; }
   inline LeafPage *GetBeginPage() {
     PageID pid = _headPage->ReadBeginLeafPagePointer();
     return (LeafPage *)GetPage(pid, PageType::LEAF_PAGE, true);
@@ -125,15 +203,22 @@ public:
 
 protected:
   ~IndexTree();
+  /**Search the leaf page from root without locking or referencing the branch
+   * pages. Every branch page is read between ReadVersion and ValidateVersion,
+   * and the search gives up if any page has been changed, so the readers do
+   * not write the shared cache lines of the upper pages.
+   * @return True if the leaf page has been found and locked as
+   * SearchRecursively, or false to search again with locks.*/
+  bool SearchOptimistic(const RawKey &key, bool bEdit, IndexPage *&page);
 
 protected:
   MString _indexName;
   MString _fileName;
-  std::queue<PageFile *> _fileQueue;
-  SpinMutex _fileMutex;
-  condition_variable_any _fileCv;
-  /**How much page files were opened for this index tree*/
-  uint32_t _rpfCount = 0;
+  /**The page file for this index tree. It only uses positional read and
+   * write, so it is shared by all threads without lock*/
+  PageFile *_pageFile = nullptr;
+  /**Load pages ordered by page id, used for DiskType::HDD*/
+  PageReadScheduler *_readScheduler = nullptr;
   uint32_t _fileId = 0;
   bool _bClosed = false;
   /** Head page */
@@ -143,6 +228,22 @@ protected:
   /** To record how much pages of this index tree are in memory */
   atomic<int32_t> _pagesInMem = 0;
 
+  /** The start window of leaf read-ahead, 0 means the min window*/
+  atomic<uint32_t> _readAheadWindow = 0;
+
+  /** The pages in PageBufferPool and the quota, see SetPoolQuota*/
+  atomic<uint64_t> _poolPages = 0;
+  uint64_t _poolMinPages = 0;
+  uint64_t _poolMaxPages = 0;
+  bool _bPinBranches = false;
+  bool _bOptimisticSearch = true;
+
+  /** The statistics of page divides, see AddDivideStat*/
+  atomic<uint64_t> _divideCount = 0;
+  atomic<uint64_t> _appendDivideCount = 0;
+  atomic<uint64_t> _divideDataLength = 0;
+  atomic<uint64_t> _divideCapacity = 0;
+
   VectorDataValue _vctKey;
   VectorDataValue _vctValue;
   SpinMutex _pageMutex;
@@ -150,7 +251,7 @@ protected:
   queue<PageLock *> _queueMutex;
   /**To lock for root page*/
   SharedSpinMutex _rootSharedMutex;
-  IndexPage *_rootPage = nullptr;
+  atomic<IndexPage *> _rootPage{nullptr};
 
   // PrimaryKey: ValVarFieldNum * sizeof(uint32_t)
   // Other: 0
@@ -0,0 +1,210 @@
+﻿#include "LeafCursor.h"
+#include "IndexTree.h"
+#include "LeafPage.h"
+#include "LeafRecord.h"
+
+namespace storage {
+static RawKey *CopyKey(const RawKey *key) {
+  if (key == nullptr)
+    return nullptr;
+
+  RawKey *rk = new RawKey();
+  rk->Copy(key->GetBysVal(), key->GetLength());
+  return rk;
+}
+
+LeafCursor::LeafCursor(IndexTree *indexTree, bool bForward)
+    : _indexTree(indexTree), _readAhead(indexTree), _bForward(bForward) {}
+
+LeafCursor::~LeafCursor() {
+  if (_page != nullptr)
+    _page->DecRef();
+  if (_lastRecord != nullptr)
+    _lastRecord->DecRef();
+  delete _startKey;
+  delete _endKey;
+}
+
+void LeafCursor::Seek(const RawKey *key, bool bInclusive) {
+  if (_lastRecord != nullptr) {
+    _lastRecord->DecRef();
+    _lastRecord = nullptr;
+  }
+  delete _startKey;
+  _startKey = CopyKey(key);
+  _bStartInclusive = bInclusive;
+  _bSeeked = true;
+  _bEnd = false;
+
+  SetPage(SearchPage());
+  _page->ReadUnlock();
+}
+
+void LeafCursor::SetEndKey(const RawKey *key, bool bInclusive) {
+  delete _endKey;
+  _endKey = CopyKey(key);
+  _bEndInclusive = bInclusive;
+}
+
+LeafRecord *LeafCursor::Next() {
+  if (!_bSeeked)
+    Seek(nullptr);
+  if (_bEnd)
+    return nullptr;
+
+  _page->ReadLock();
+  while (true) {
+    uint64_t version;
+    _page->ReadVersion(version);
+    if (version != _version) {
+      _relocateCount++;
+      _pos = Locate();
+      _version = version;
+      if (!_bForward && _pos == (int32_t)_page->GetRecordNumber() &&
+          _page->GetNextPageId() != PAGE_NULL_POINTER) {
+        // Page divide maybe has moved the records before the position to the
+        // following pages, search them from root.
+        _page->ReadUnlock();
+        SetPage(SearchPage());
+        continue;
+      }
+    }
+
+    if (_bForward ? _pos < (int32_t)_page->GetRecordNumber() : _pos > 0) {
+      int32_t pos = _bForward ? _pos++ : --_pos;
+      LeafRecord *rec = _page->GetRecord(pos);
+      if (rec->GetTotalLength() == 0) {
+        // Removed but not saved yet
+        rec->DecRef();
+        continue;
+      }
+
+      if (IsBeyondEnd(rec)) {
+        rec->DecRef();
+        _page->ReadUnlock();
+        _bEnd = true;
+        return nullptr;
+      }
+
+      LeafRecord *lr = rec->Clone();
+      rec->DecRef();
+      _page->ReadUnlock();
+
+      if (_lastRecord != nullptr)
+        _lastRecord->DecRef();
+      _lastRecord = lr->AddRef();
+      return lr;
+    }
+
+    LeafPage *page = _readAhead.MovePage(_page, _bForward);
+    PageID pid = _page->GetPageId();
+    _page->ReadUnlock();
+    if (page == nullptr) {
+      _bEnd = true;
+      return nullptr;
+    }
+
+    page->ReadLock();
+    // The previous page maybe has been divided after its id was read, move to
+    // right until the page just before the current page.
+    while (!_bForward && page->GetNextPageId() != pid &&
+           page->GetNextPageId() != PAGE_NULL_POINTER) {
+      LeafPage *next = (LeafPage *)_indexTree->GetPage(
+          page->GetNextPageId(), PageType::LEAF_PAGE, true);
+      next->ReadLock();
+      page->ReadUnlock();
+      page->DecRef();
+      page = next;
+    }
+
+    SetPage(page);
+  }
+}
+
+LeafPage *LeafCursor::SearchPage() {
+  IndexPage *page = nullptr;
+  if (_lastRecord != nullptr) {
+    _indexTree->SearchRecursively(*_lastRecord, false, page, true);
+    return (LeafPage *)page;
+  }
+
+  if (_startKey != nullptr) {
+    _indexTree->SearchRecursively(*_startKey, false, page, true);
+    if (_bForward || !_bStartInclusive ||
+        _indexTree->GetHeadPage()->ReadIndexType() != IndexType::NON_UNIQUE) {
+      return (LeafPage *)page;
+    }
+  } else if (_bForward) {
+    page = _indexTree->GetBeginPage();
+    page->ReadLock();
+    return (LeafPage *)page;
+  } else {
+    page = _indexTree->GetPage(
+        (PageID)_indexTree->GetHeadPage()->ReadEndLeafPagePointer(),
+        PageType::LEAF_PAGE, true);
+    page->ReadLock();
+  }
+
+  // Scan backward from the last record <= key or the last record in tree, the
+  // records maybe continue in the following pages.
+  LeafPage *lp = (LeafPage *)page;
+  while (lp->GetNextPageId() != PAGE_NULL_POINTER) {
+    if (_startKey != nullptr && lp->GetRecordNumber() > 0 &&
+        lp->CompareKey(lp->GetRecordNumber() - 1, *_startKey) > 0)
+      break;
+
+    LeafPage *next = (LeafPage *)_indexTree->GetPage(
+        lp->GetNextPageId(), PageType::LEAF_PAGE, true);
+    next->ReadLock();
+    lp->ReadUnlock();
+    lp->DecRef();
+    lp = next;
+  }
+
+  return lp;
+}
+
+void LeafCursor::SetPage(LeafPage *page) {
+  if (_page != nullptr)
+    _page->DecRef();
+  _page = page;
+  _pos = Locate();
+  _page->ReadVersion(_version);
+}
+
+int32_t LeafCursor::Locate() {
+  bool bFind;
+  if (_lastRecord != nullptr) {
+    int32_t pos = _page->SearchRecord(*_lastRecord, bFind);
+    return (_bForward && bFind) ? pos + 1 : pos;
+  }
+
+  if (_startKey == nullptr)
+    return _bForward ? 0 : (int32_t)_page->GetRecordNumber();
+
+  int32_t pos = _page->SearchKey(*_startKey, bFind);
+  if (_bForward == _bStartInclusive || !bFind)
+    return pos;
+  return UpperBound(pos);
+}
+
+int32_t LeafCursor::UpperBound(int32_t pos) {
+  if (_indexTree->GetHeadPage()->ReadIndexType() != IndexType::NON_UNIQUE)
+    return pos + 1;
+
+  while (pos < (int32_t)_page->GetRecordNumber() &&
+         _page->CompareKey(pos, *_startKey) == 0)
+    pos++;
+  return pos;
+}
+
+bool LeafCursor::IsBeyondEnd(const LeafRecord *lr) const {
+  if (_endKey == nullptr)
+    return false;
+
+  int hr = lr->CompareKey(*_endKey);
+  if (hr == 0)
+    return !_bEndInclusive;
+  return _bForward ? hr > 0 : hr < 0;
+}
+} // namespace storage
@@ -0,0 +1,76 @@
+﻿#pragma once
+#include "../cache/Mallocator.h"
+#include "../header.h"
+#include "LeafReadAhead.h"
+#include "RawKey.h"
+#include <cstdint>
+
+namespace storage {
+class IndexTree;
+class LeafPage;
+class LeafRecord;
+
+/**Cursor to scan the records of an index tree in key order, forward along the
+ * next pointers of leaf pages or backward along the previous pointers. The
+ * cursor holds a reference of the current leaf page but no lock between two
+ * calls of Next. Only the record to return is read from the page, and the
+ * position in page is calculated again from the last returned record if the
+ * page version has changed, so the records moved by page divide will not be
+ * skipped or returned twice. The records inserted or deleted during the scan
+ * maybe seen or not.*/
+class LeafCursor {
+public:
+  LeafCursor(IndexTree *indexTree, bool bForward = true);
+  ~LeafCursor();
+  /**Put the cursor before the first record to scan.
+   * @param key The start key, or nullptr to scan from the first record
+   * (forward) or the last record (backward).
+   * @param bInclusive Forward: start from the records >= key, or else > key;
+   * Backward: start from the records <= key, or else < key.*/
+  void Seek(const RawKey *key, bool bInclusive = true);
+  /**Set the key to stop the scan, nullptr means to scan to the end of tree.
+   * @param bInclusive If return the records that equal to key.*/
+  void SetEndKey(const RawKey *key, bool bInclusive = true);
+  /**Get the next record in the direction.
+   * @return The record copied from page, the caller need to DecRef it; or
+   * nullptr if there is no more record.*/
+  LeafRecord *Next();
+
+  bool IsForward() const { return _bForward; }
+  // How many times the position has been searched again for changed pages
+  uint64_t GetRelocateCount() const { return _relocateCount; }
+
+protected:
+  // Find the leaf page that contains the start position from root, the page
+  // has been locked by read lock.
+  LeafPage *SearchPage();
+  // Set the page as current page and calculate the position in it.
+  void SetPage(LeafPage *page);
+  // Calculate the position in current page by the last returned record or
+  // the start key. Forward: the position of the next record to return;
+  // Backward: the position after the next record to return.
+  int32_t Locate();
+  // The position of the first record with key > _startKey
+  int32_t UpperBound(int32_t pos);
+  bool IsBeyondEnd(const LeafRecord *lr) const;
+
+protected:
+  IndexTree *_indexTree;
+  LeafReadAhead _readAhead;
+  // The current leaf page, only hold its reference
+  LeafPage *_page = nullptr;
+  // The page version when _pos was calculated
+  uint64_t _version = 0;
+  int32_t _pos = 0;
+  // The last returned record, nullptr before the first record.
+  LeafRecord *_lastRecord = nullptr;
+  RawKey *_startKey = nullptr;
+  RawKey *_endKey = nullptr;
+  uint64_t _relocateCount = 0;
+  bool _bForward;
+  bool _bStartInclusive = true;
+  bool _bEndInclusive = true;
+  bool _bSeeked = false;
+  bool _bEnd = false;
+};
+} // namespace storage
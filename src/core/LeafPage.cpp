@@ -36,6 +36,7 @@ void LeafPage::Init() {
   IndexPage::Init();
   _prevPageId = ReadInt(PREV_PAGE_POINTER_OFFSET);
   _nextPageId = ReadInt(NEXT_PAGE_POINTER_OFFSET);
+  LoadKeyHeads();
 }
 
 void LeafPage::LoadRecords() {
@@ -50,6 +51,16 @@ void LeafPage::LoadRecords() {
   }
 }
 
+void LeafPage::LoadKeyHeads() {
+  _vctKeyHead.resize(_recordNum);
+  for (uint32_t i = 0; i < _recordNum; i++) {
+    uint16_t start = ReadShort(DATA_BEGIN_OFFSET + i * UI16_LEN);
+    _vctKeyHead[i] =
+        CalcKeyHead(_bysPage + start + _indexTree->GetKeyOffset(),
+                    ReadShort(start + UI16_LEN) - _indexTree->GetKeyVarLen());
+  }
+}
+
 void LeafPage::CleanRecord() {
   for (RawRecord *lr : _vctRecord) {
     ((LeafRecord *)lr)->DecRef();
@@ -96,6 +107,7 @@ bool LeafPage::SaveRecords() {
       _absoBuf->ReleaseCount(refCount);
 
     _absoBuf = nullptr;
+    LoadKeyHeads();
   }
 
   WriteInt(PARENT_PAGE_POINTER_OFFSET, _parentPageId);
@@ -121,6 +133,7 @@ void LeafPage::InsertRecord(LeafRecord *lr, int32_t pos, bool incRef) {
 
   _totalDataLength += lr->GetTotalLength() + UI16_LEN;
   lr->SetParentPage(this);
+  CountInsert(pos);
   _vctRecord.insert(_vctRecord.begin() + pos, lr);
   _recordNum++;
   if (lr->IsTransaction()) {
@@ -131,8 +144,8 @@ void LeafPage::InsertRecord(LeafRecord *lr, int32_t pos, bool incRef) {
   _indexTree->GetHeadPage()->GetAndIncTotalRecordCount();
 }
 
-bool LeafPage::AddRecord(LeafRecord *lr) {
-  if (_totalDataLength > MAX_DATA_LENGTH_LEAF * LOAD_FACTOR / 100U ||
+bool LeafPage::AddRecord(LeafRecord *lr, uint16_t loadFactor) {
+  if (_totalDataLength > MAX_DATA_LENGTH_LEAF * loadFactor / 100U ||
       _totalDataLength + lr->GetTotalLength() + UI16_LEN >
           (uint32_t)MAX_DATA_LENGTH_LEAF) {
     return false;
@@ -151,7 +164,7 @@ bool LeafPage::AddRecord(LeafRecord *lr) {
   }
   _bDirty = true;
   _bRecordUpdate = true;
-  _indexTree->GetHeadPage()->GetAndIncTotalPageCount();
+  _indexTree->GetHeadPage()->GetAndIncTotalRecordCount();
 
   return true;
 }
@@ -175,6 +188,12 @@ int32_t LeafPage::SearchRecord(const LeafRecord &rr, bool &bFind, int32_t start,
     end = _recordNum - 1;
   bFind = true;
   int hr;
+  // The key heads can not decide the order of records in non unique index.
+  bool bHead = bUnique && IsKeyHeadValid();
+  uint64_t head =
+      bHead ? CalcKeyHead(rr.GetBysValue() + _indexTree->GetKeyOffset(),
+                          rr.GetKeyLength() - _indexTree->GetKeyVarLen())
+            : 0;
 
   while (true) {
     if (start > end) {
@@ -187,7 +206,9 @@ int32_t LeafPage::SearchRecord(const LeafRecord &rr, bool &bFind, int32_t start,
       hr = bUnique ? GetVctRecord(middle)->CompareKey(rr)
                    : GetVctRecord(middle)->CompareTo(rr);
     } else {
-      hr = CompareTo(middle, rr, bUnique);
+      hr = bHead ? CompareKeyHead(middle, head) : 0;
+      if (hr == 0)
+        hr = CompareTo(middle, rr, bUnique);
     }
 
     if (hr < 0) {
@@ -200,6 +221,13 @@ int32_t LeafPage::SearchRecord(const LeafRecord &rr, bool &bFind, int32_t start,
   }
 }
 
+int LeafPage::CompareKey(int32_t pos, const RawKey &key) {
+  assert(pos >= 0 && pos < (int32_t)_recordNum);
+  if (_vctRecord.size() > 0)
+    return GetVctRecord(pos)->CompareKey(key);
+  return CompareTo(pos, key);
+}
+
 int32_t LeafPage::SearchKey(const RawKey &key, bool &bFind, int32_t start,
                             int32_t end) {
   if (end >= (int32_t)_recordNum)
@@ -207,6 +235,8 @@ int32_t LeafPage::SearchKey(const RawKey &key, bool &bFind, int32_t start,
   bFind = true;
   bool bUnique =
       (_indexTree->GetHeadPage()->ReadIndexType() != IndexType::NON_UNIQUE);
+  bool bHead = IsKeyHeadValid();
+  uint64_t head = bHead ? CalcKeyHead(key.GetBysVal(), key.GetLength()) : 0;
 
   while (true) {
     if (start > end) {
@@ -215,12 +245,9 @@ int32_t LeafPage::SearchKey(const RawKey &key, bool &bFind, int32_t start,
     }
 
     int32_t middle = (start + end) / 2;
-    int hr = 0;
-    if (_vctRecord.size() > 0) {
-      hr = GetVctRecord(middle)->CompareKey(key);
-    } else {
-      hr = CompareTo(middle, key);
-    }
+    int hr = bHead ? CompareKeyHead(middle, head) : 0;
+    if (hr == 0)
+      hr = CompareKey(middle, key);
 
     if (hr < 0) {
       start = middle + 1;
@@ -230,10 +257,7 @@ int32_t LeafPage::SearchKey(const RawKey &key, bool &bFind, int32_t start,
       if (bUnique) {
         return middle;
       } else {
-        if (middle > start &&
-            (_vctRecord.size() > 0
-                 ? GetVctRecord(middle - 1)->CompareKey(key) == 0
-                 : CompareTo(middle - 1, key) == 0)) {
+        if (middle > start && CompareKey(middle - 1, key) == 0) {
           end = middle - 1;
         } else {
           return middle;
@@ -250,6 +274,11 @@ int32_t LeafPage::SearchKey(const LeafRecord &rr, bool &bFind, int32_t start,
   bFind = true;
   bool bUnique =
       (_indexTree->GetHeadPage()->ReadIndexType() != IndexType::NON_UNIQUE);
+  bool bHead = IsKeyHeadValid();
+  uint64_t head =
+      bHead ? CalcKeyHead(rr.GetBysValue() + _indexTree->GetKeyOffset(),
+                          rr.GetKeyLength() - _indexTree->GetKeyVarLen())
+            : 0;
 
   while (true) {
     if (start > end) {
@@ -262,7 +291,9 @@ int32_t LeafPage::SearchKey(const LeafRecord &rr, bool &bFind, int32_t start,
     if (_vctRecord.size() > 0) {
       hr = GetVctRecord(middle)->CompareKey(rr);
     } else {
-      hr = CompareTo(middle, rr, true);
+      hr = bHead ? CompareKeyHead(middle, head) : 0;
+      if (hr == 0)
+        hr = CompareTo(middle, rr, true);
     }
 
     if (hr < 0) {
@@ -35,6 +35,8 @@ public:
 
   void LoadRecords();
   void CleanRecord();
+  // Load the key heads of records in _bysPage
+  void LoadKeyHeads();
   bool SaveRecords() override;
   /**
    * @brief Insert a leaf record into position pos in this page
@@ -66,16 +68,20 @@ public:
   /** @brief Add a new record to the last position of this page. Only used wehn
    * batch add for ordered records.
    * @param record The new record
+   * @param loadFactor The percent of page to fill, the last record can exceed it
    * @return True: passed to add the record; False: failed to add the record due
    * to reach length limit.
    */
-  bool AddRecord(LeafRecord *record);
+  bool AddRecord(LeafRecord *record, uint16_t loadFactor = LOAD_FACTOR);
   /**
    * @brief Get the Record in this LeafPage with position=pos   *
    * @param pos The position of records in this page
    * @return LeafRecord* The leaf record to get
    */
   LeafRecord *GetRecord(int32_t pos);
+  /**Compare the key of the record in pos with key. If the records have not
+   * been loaded, it compares _bysPage directly without creating LeafRecord.*/
+  int CompareKey(int32_t pos, const RawKey &key);
   int32_t SearchRecord(const LeafRecord &rr, bool &bFind, int32_t start = 0,
                        int32_t end = INT32_MAX);
   int32_t SearchKey(const RawKey &key, bool &bFind, int32_t start = 0,
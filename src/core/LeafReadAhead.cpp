@@ -0,0 +1,130 @@
+﻿#include "LeafReadAhead.h"
+#include "../pool/PageBufferPool.h"
+#include "BranchPage.h"
+#include "BranchRecord.h"
+#include "IndexTree.h"
+#include "LeafPage.h"
+
+namespace storage {
+const uint32_t LeafReadAhead::TRIGGER_PAGES = 4;
+const uint32_t LeafReadAhead::MIN_WINDOW = 4;
+const uint32_t LeafReadAhead::MAX_WINDOW = 64;
+
+LeafReadAhead::LeafReadAhead(IndexTree *indexTree) : _indexTree(indexTree) {
+  _window = indexTree->GetReadAheadWindow();
+  if (_window < MIN_WINDOW)
+    _window = MIN_WINDOW;
+  if (_window > MAX_WINDOW)
+    _window = MAX_WINDOW;
+}
+
+LeafReadAhead::~LeafReadAhead() { FinishRound(); }
+
+LeafPage *LeafReadAhead::MovePage(LeafPage *page, bool bForward) {
+  PageID pid = bForward ? page->GetNextPageId() : page->GetPrevPageId();
+  if (pid == PAGE_NULL_POINTER)
+    return nullptr;
+
+  if (bForward != _bForward) {
+    // The scan turned back, the pages in old direction are useless.
+    FinishRound();
+    _bForward = bForward;
+    _seqCount = 0;
+  }
+
+  if (_setAhead.erase(pid) > 0) {
+    _roundUsed++;
+    _hitCount++;
+  }
+
+  LeafPage *lp =
+      (LeafPage *)_indexTree->GetPage(pid, PageType::LEAF_PAGE, true);
+  _seqCount++;
+  if (_seqCount >= TRIGGER_PAGES && _setAhead.size() <= _window / 2) {
+    Prefetch(lp, bForward);
+  }
+
+  return lp;
+}
+
+void LeafReadAhead::Prefetch(LeafPage *page, bool bForward) {
+  // The scan has consumed at least half of the last round, it can run faster
+  // than the disk with a larger window.
+  if (_roundIssued > 0 && _roundUsed * 2 >= _roundIssued &&
+      _window < MAX_WINDOW) {
+    _window = min(_window * 2, MAX_WINDOW);
+    _indexTree->SetReadAheadWindow(_window);
+  }
+
+  MVector<PageID> vctId;
+  PageID parentId = page->GetParentPageId();
+  if (parentId != PAGE_NULL_POINTER) {
+    // The parent is loaded once for all its children, and it is normally in
+    // memory already.
+    BranchPage *parent = (BranchPage *)_indexTree->GetPage(
+        parentId, PageType::BRANCH_PAGE, true);
+    if (parent->GetPageType() == PageType::BRANCH_PAGE &&
+        parent->ReadTryLock()) {
+      int32_t num = (int32_t)parent->GetRecordNumber();
+      int32_t pos = -1;
+      for (int32_t i = 0; i < num; i++) {
+        if (parent->GetChildPageId(i, false) ==
+            page->GetPageId()) {
+          pos = i;
+          break;
+        }
+      }
+
+      // If not found, the parent pointer is out of date.
+      if (pos >= 0) {
+        int32_t step = bForward ? 1 : -1;
+        for (int32_t i = pos + step;
+             i >= 0 && i < num && vctId.size() < _window; i += step) {
+          vctId.push_back(parent->GetChildPageId(i, false));
+        }
+      }
+      parent->ReadUnlock();
+    }
+    parent->DecRef();
+  }
+
+  if (vctId.size() == 0) {
+    // Can not get the leaves from parent, only load the neighbor.
+    PageID pid = bForward ? page->GetNextPageId() : page->GetPrevPageId();
+    if (pid == PAGE_NULL_POINTER)
+      return;
+    vctId.push_back(pid);
+  }
+
+  _roundIssued = 0;
+  _roundUsed = 0;
+  for (PageID pid : vctId) {
+    if (_setAhead.find(pid) != _setAhead.end())
+      continue;
+
+    CachePage *cp = PageBufferPool::GetPage(_indexTree->GetFileId(), pid);
+    if (cp != nullptr) {
+      cp->DecRef();
+      continue;
+    }
+
+    // Do not wait, the page will be loaded by AsyncIo, thread pool or read
+    // scheduler, and stays in PageBufferPool after the reference released.
+    _indexTree->GetPage(pid, PageType::LEAF_PAGE, false)->DecRef();
+    _setAhead.insert(pid);
+    _roundIssued++;
+    _prefetchCount++;
+  }
+}
+
+void LeafReadAhead::FinishRound() {
+  if (_setAhead.size() > _roundUsed && _window > MIN_WINDOW) {
+    _window = max(_window / 2, MIN_WINDOW);
+    _indexTree->SetReadAheadWindow(_window);
+  }
+
+  _setAhead.clear();
+  _roundIssued = 0;
+  _roundUsed = 0;
+}
+} // namespace storage
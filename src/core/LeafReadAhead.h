@@ -0,0 +1,68 @@
+﻿#pragma once
+#include "../cache/Mallocator.h"
+#include "../header.h"
+#include <atomic>
+
+namespace storage {
+class IndexTree;
+class LeafPage;
+
+/**Adaptive read-ahead for the scans along the leaf chain. Every scan owns one
+ * instance and moves between leaf pages by it. After the scan has visited
+ * TRIGGER_PAGES continuous leaves in the same direction, it starts to load the
+ * following leaves asynchronously into PageBufferPool. The leaf ids are taken
+ * from the parent branch page, so they can be loaded at the same time instead
+ * of one by one through the next pointer. The window doubles when the scan
+ * keeps up with the prefetched pages and halves when the scan ends or turns
+ * back with many prefetched pages unused. The last window is saved in the
+ * index tree as the start window for the next scans.*/
+class LeafReadAhead {
+public:
+  // How many continuous leaves to be visited before start to read ahead
+  static const uint32_t TRIGGER_PAGES;
+  // The min and max number of leaves to read ahead
+  static const uint32_t MIN_WINDOW;
+  static const uint32_t MAX_WINDOW;
+
+public:
+  LeafReadAhead(IndexTree *indexTree);
+  ~LeafReadAhead();
+  /** @brief Move from a leaf page to its next or previous leaf page, and read
+   * ahead the following leaves if the scan is sequential.
+   * @param page The current leaf page, it is still owned by the caller.
+   * @param bForward True: move to next page; False: move to previous page.
+   * @return The leaf page that has been loaded, the caller need to DecRef it;
+   * or nullptr if there is no more leaf page in this direction.
+   */
+  LeafPage *MovePage(LeafPage *page, bool bForward);
+  LeafPage *NextPage(LeafPage *page) { return MovePage(page, true); }
+  LeafPage *PrevPage(LeafPage *page) { return MovePage(page, false); }
+
+  uint32_t GetWindow() { return _window; }
+  // How many pages have been submitted to load by this scan
+  uint64_t GetPrefetchCount() { return _prefetchCount; }
+  // How many prefetched pages have been visited by this scan
+  uint64_t GetHitCount() { return _hitCount; }
+
+protected:
+  // Load the leaves after page in the direction, until _window pages
+  void Prefetch(LeafPage *page, bool bForward);
+  // Called when the scan ends or turns back, shrink the window if the most
+  // prefetched pages have not been used.
+  void FinishRound();
+
+protected:
+  IndexTree *_indexTree;
+  // The prefetched pages that have not been visited
+  MHashSet<PageID> _setAhead;
+  uint32_t _window;
+  // The continuous leaves visited in current direction
+  uint32_t _seqCount = 0;
+  bool _bForward = true;
+  // The pages submitted in the last round and the hits after it
+  uint32_t _roundIssued = 0;
+  uint32_t _roundUsed = 0;
+  uint64_t _prefetchCount = 0;
+  uint64_t _hitCount = 0;
+};
+} // namespace storage
@@ -178,6 +178,20 @@ LeafRecord::LeafRecord(LeafRecord &src)
   src._overflowPage = nullptr;
 }
 
+LeafRecord *LeafRecord::Clone() const {
+  uint16_t len = GetTotalLength();
+  Byte *bys = CachePool::Apply(len);
+  BytesCopy(bys, _bysVal, len);
+
+  LeafRecord *lr = new LeafRecord(_indexTree, bys);
+  lr->_bSole = true;
+  if (_overflowPage != nullptr) {
+    _overflowPage->IncRef();
+    lr->_overflowPage = _overflowPage;
+  }
+  return lr;
+}
+
 /** @brief When update or delete this record, set new values into record and
  * save old value into _undoRec, only use for primary index
  * @param vctVal the vector of data value. If ActionType==Delete, it is empty
@@ -75,6 +75,9 @@ public:
   // No use now, only for test
   LeafRecord(IndexTree *indexTree, Byte *bys);
   LeafRecord(LeafRecord &src);
+  /**Copy the bytes of this record into a new sole record without parent page,
+   * so it is still valid after the page has been saved or evicted.*/
+  LeafRecord *Clone() const;
   // Constructor for secondary index LeafRecord
   LeafRecord(IndexTree *indexTree, const VectorDataValue &vctKey, Byte *bysPri,
              uint32_t lenPri, ActionType type, Statement *stmt);
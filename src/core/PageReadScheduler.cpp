@@ -0,0 +1,101 @@
+﻿#include "PageReadScheduler.h"
+#include "../utils/Log.h"
+#include "IndexTree.h"
+
+namespace storage {
+const uint32_t PageReadScheduler::MAX_MERGE_PAGES = 32;
+
+void PageReadScheduler::AddPage(CachePage *page, bool bInline) {
+  assert(page->GetPageStatus() == PageStatus::EMPTY);
+  page->IncRef();
+  bool bStart = false;
+  {
+    unique_lock<SpinMutex> lock(_spinMutex);
+    if (!_mapPage.insert({page->GetPageId(), page}).second) {
+      page->DecRef();
+    }
+
+    if (!_bRunning) {
+      _bRunning = true;
+      bStart = true;
+    }
+  }
+
+  if (!bStart)
+    return;
+
+  if (bInline) {
+    ReadPages();
+  } else {
+    ThreadPool::InstMain().AddTask(new PageReadTask(this));
+  }
+}
+
+void PageReadScheduler::ReadPages() {
+  // Hold the index tree until all pages have been loaded, the last DecRef of
+  // a page maybe free the index tree and this scheduler.
+  IndexTree *indexTree = _indexTree;
+  indexTree->IncPages();
+  MTreeMap<PageID, CachePage *> mapPage;
+  MVector<CachePage *> vctPage;
+
+  while (true) {
+    {
+      unique_lock<SpinMutex> lock(_spinMutex);
+      if (_mapPage.size() == 0) {
+        _bRunning = false;
+        break;
+      }
+      mapPage.swap(_mapPage);
+    }
+
+    // Sweep from the last position to the end, then from the begin.
+    auto mid = mapPage.lower_bound(_nextPageId);
+    vctPage.reserve(mapPage.size());
+    for (auto iter = mid; iter != mapPage.end(); iter++)
+      vctPage.push_back(iter->second);
+    for (auto iter = mapPage.begin(); iter != mid; iter++)
+      vctPage.push_back(iter->second);
+    _nextPageId = vctPage.back()->GetPageId() + 1;
+    mapPage.clear();
+
+    size_t start = 0;
+    for (size_t i = 1; i <= vctPage.size(); i++) {
+      if (i == vctPage.size() ||
+          vctPage[i]->GetPageId() != vctPage[i - 1]->GetPageId() + 1 ||
+          i - start >= MAX_MERGE_PAGES) {
+        ReadRun(vctPage.data() + start, i - start);
+        start = i;
+      }
+    }
+    vctPage.clear();
+  }
+
+  indexTree->DecPages();
+}
+
+void PageReadScheduler::ReadRun(CachePage **pages, size_t count) {
+  MVector<iovec> vctIov(count);
+  for (size_t i = 0; i < count; i++) {
+    vctIov[i].iov_base = pages[i]->GetBysPage();
+    vctIov[i].iov_len = pages[i]->GetPageLength();
+  }
+
+  _indexTree->GetPageFile()->ReadPages(pages[0]->GetFileOffset(),
+                                       vctIov.data(), (int)count);
+  _readPages.fetch_add(count, memory_order_relaxed);
+  _readCalls.fetch_add(1, memory_order_relaxed);
+  LOG_DEBUG << "Elevator read pages, first=" << pages[0]->GetPageId()
+            << "  count=" << count;
+
+  for (size_t i = 0; i < count; i++) {
+    CachePage *page = pages[i];
+    page->AfterAsyncRead();
+    if (page->GetPageStatus() != PageStatus::VALID) {
+      // In following time will add code to fix page;
+      abort();
+    }
+    page->DecRef();
+  }
+}
+} // namespace storage
@@ -0,0 +1,71 @@
+﻿#pragma once
+#include "../cache/Mallocator.h"
+#include "../header.h"
+#include "../utils/SpinMutex.h"
+#include "../utils/ThreadPool.h"
+#include "CachePage.h"
+#include <atomic>
+
+namespace storage {
+class IndexTree;
+
+/**For DiskType::HDD, random reads are very slow. All pages that need to be
+ * loaded from an index file are added into this scheduler, then a large read
+ * task loads them ordered by page id like an elevator (C-SCAN): it sweeps
+ * from the last position to the end of file, then returns to the begin. The
+ * continuous pages are merged into one read.*/
+class PageReadScheduler {
+public:
+  // The max continuous pages to be merged into one read
+  static const uint32_t MAX_MERGE_PAGES;
+
+public:
+  PageReadScheduler(IndexTree *indexTree) : _indexTree(indexTree) {}
+  ~PageReadScheduler() { assert(_mapPage.size() == 0); }
+  /** @brief Add a page to be loaded from disk.
+   * @param page The page to load, it must be in EMPTY status.
+   * @param bInline If true and no read task is running, the pages will be
+   * loaded in current thread. It is used when the caller will wait the page
+   * and avoid to block the thread pool.
+   */
+  void AddPage(CachePage *page, bool bInline);
+  // Load all queued pages until the queue is empty.
+  void ReadPages();
+  uint64_t GetReadPageCount() {
+    return _readPages.load(memory_order_relaxed);
+  }
+  uint64_t GetReadCallCount() {
+    return _readCalls.load(memory_order_relaxed);
+  }
+
+protected:
+  // Load continuous pages with one read, then wake up their waiting tasks.
+  void ReadRun(CachePage **pages, size_t count);
+
+protected:
+  IndexTree *_indexTree;
+  // The pages waiting to load, sorted by page id
+  MTreeMap<PageID, CachePage *> _mapPage;
+  SpinMutex _spinMutex;
+  // The next page id after the last sweep
+  PageID _nextPageId = 0;
+  // If there is a thread loading pages
+  bool _bRunning = false;
+  atomic<uint64_t> _readPages{0};
+  atomic<uint64_t> _readCalls{0};
+};
+
+class PageReadTask : public Task {
+public:
+  PageReadTask(PageReadScheduler *scheduler) : _scheduler(scheduler) {}
+  bool IsSmallTask() override { return false; }
+  void Run() override {
+    _status = TaskStatus::RUNNING;
+    _scheduler->ReadPages();
+    _status = TaskStatus::FINISHED;
+  }
+
+protected:
+  PageReadScheduler *_scheduler;
+};
+} // namespace storage
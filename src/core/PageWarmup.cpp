@@ -0,0 +1,115 @@
+﻿#include "PageWarmup.h"
+#include "../pool/PageBufferPool.h"
+#include "../utils/Log.h"
+#include "BranchPage.h"
+#include "IndexTree.h"
+#include "LeafPage.h"
+#include <algorithm>
+
+namespace storage {
+const uint32_t PageWarmup::MAX_MERGE_PAGES = 64;
+
+PageWarmup::PageWarmup(IndexTree *indexTree, MVector<PageID> &vctId)
+    : _indexTree(indexTree) {
+  _vctId.swap(vctId);
+  _indexTree->IncPages();
+}
+
+PageWarmup::~PageWarmup() { _indexTree->DecPages(); }
+
+// How many pages can be added before the pool reaches low watermark
+static inline int64_t PoolRoom() {
+  return (int64_t)(PageBufferPool::GetMaxCacheSize() *
+                   Configure::GetPoolLowWatermark() / 100) -
+         (int64_t)PageBufferPool::GetCacheSize();
+}
+
+uint64_t PageWarmup::Load() {
+  int64_t room = PoolRoom();
+  if (room <= 0)
+    return 0;
+  if (_vctId.size() > (uint64_t)room)
+    _vctId.resize(room);
+
+  // Sort the hottest pages by position in file.
+  uint32_t totalPages = _indexTree->GetHeadPage()->ReadTotalPageCount();
+  _vctId.erase(remove_if(_vctId.begin(), _vctId.end(),
+                         [totalPages](PageID pid) { return pid >= totalPages; }),
+               _vctId.end());
+  sort(_vctId.begin(), _vctId.end());
+  _vctId.erase(unique(_vctId.begin(), _vctId.end()), _vctId.end());
+
+  uint64_t loaded = 0;
+  MVector<PageID> vctRun;
+  for (size_t i = 0; i <= _vctId.size(); i++) {
+    if (i == _vctId.size() || vctRun.size() >= MAX_MERGE_PAGES ||
+        (vctRun.size() > 0 && _vctId[i] != vctRun.back() + 1)) {
+      if (vctRun.size() > 0) {
+        if (_indexTree->IsClosed() || PoolRoom() < (int64_t)vctRun.size())
+          break;
+        loaded += LoadRun(vctRun);
+        vctRun.clear();
+      }
+      if (i == _vctId.size())
+        break;
+    }
+
+    // The pages that have been loaded by queries are skipped.
+    CachePage *page = PageBufferPool::GetPage(_indexTree->GetFileId(),
+                                              _vctId[i]);
+    if (page != nullptr) {
+      page->DecRef();
+      continue;
+    }
+    vctRun.push_back(_vctId[i]);
+  }
+
+  LOG_INFO << "Warm up index tree " << _indexTree->GetFileId()
+           << ", pages=" << loaded << "  reads=" << _readCalls;
+  return loaded;
+}
+
+uint64_t PageWarmup::LoadRun(const MVector<PageID> &vctRun) {
+  // Taken before read, any page evicted after it maybe has been changed and
+  // the data to load is out of date.
+  uint64_t evictCount = PageBufferPool::GetEvictCount();
+  size_t count = vctRun.size();
+  MVector<Byte *> vctBys(count);
+  MVector<iovec> vctIov(count);
+  for (size_t i = 0; i < count; i++) {
+    vctBys[i] = CachePool::ApplyPage();
+    vctIov[i].iov_base = vctBys[i];
+    vctIov[i].iov_len = CachePage::CACHE_PAGE_SIZE;
+  }
+
+  uint64_t len = _indexTree->GetPageFile()->ReadPages(
+      CachePage::CalcFileOffset(vctRun[0]), vctIov.data(), (int)count);
+  _readCalls++;
+
+  uint64_t loaded = 0;
+  for (size_t i = 0; i < count; i++) {
+    if ((i + 1) * CachePage::CACHE_PAGE_SIZE <= len) {
+      IndexPage *page;
+      if (vctBys[i][IndexPage::PAGE_LEVEL_OFFSET] == 0)
+        page = new LeafPage(_indexTree, vctRun[i]);
+      else
+        page = new BranchPage(_indexTree, vctRun[i]);
+
+      _indexTree->IncPages();
+      BytesCopy(page->GetBysPage(), vctBys[i], CachePage::CACHE_PAGE_SIZE);
+      page->AfterAsyncRead();
+      if (page->GetPageStatus() == PageStatus::VALID &&
+          _indexTree->AddLoadedPage(page, evictCount)) {
+        page->DecRef();
+        loaded++;
+      } else {
+        page->DecRef(2);
+      }
+    }
+
+    CachePool::ReleasePage(vctBys[i]);
+  }
+
+  return loaded;
+}
+} // namespace storage
@@ -0,0 +1,55 @@
+﻿#pragma once
+#include "../cache/Mallocator.h"
+#include "../header.h"
+#include "../utils/ThreadPool.h"
+#include <atomic>
+
+namespace storage {
+class IndexTree;
+
+/**Load the hot pages of an index tree that were in PageBufferPool before
+ * restart, see PageBufferPool::SaveWarmupList. The page ids are sorted and the
+ * continuous pages are loaded with one large read. The page type is decided
+ * by the loaded data and the pages failed to verify are dropped, so an out of
+ * date list only wastes some reads. The hottest pages are selected to fill the
+ * pool to low watermark, it stops earlier if the tree is closed.*/
+class PageWarmup {
+public:
+  // The max continuous pages to be loaded by one read
+  static const uint32_t MAX_MERGE_PAGES;
+
+public:
+  // It holds the index tree until Load finished.
+  PageWarmup(IndexTree *indexTree, MVector<PageID> &vctId);
+  ~PageWarmup();
+  // Load the pages in list, return how many pages have been added into pool.
+  uint64_t Load();
+  uint64_t GetReadCallCount() { return _readCalls; }
+
+protected:
+  // Load continuous pages with one read and add the valid pages into pool.
+  uint64_t LoadRun(const MVector<PageID> &vctRun);
+
+protected:
+  IndexTree *_indexTree;
+  // The page ids to load, from the hottest to the coldest
+  MVector<PageID> _vctId;
+  uint64_t _readCalls = 0;
+};
+
+class PageWarmupTask : public Task {
+public:
+  PageWarmupTask(PageWarmup *warmup) : _warmup(warmup) {}
+  bool IsSmallTask() override { return false; }
+  void Run() override {
+    _status = TaskStatus::RUNNING;
+    _warmup->Load();
+    delete _warmup;
+    _warmup = nullptr;
+    _status = TaskStatus::FINISHED;
+  }
+
+protected:
+  PageWarmup *_warmup;
+};
+} // namespace storage
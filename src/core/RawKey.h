@@ -4,6 +4,7 @@
 #include "../header.h"
 #include <cstdint>
 #include <cstring>
+#include <iomanip>
 
 namespace storage {
 class RawKey {
@@ -0,0 +1,251 @@
+#include "AsyncIo.h"
+#include "../config/Configure.h"
+#include "../utils/Log.h"
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASYNC_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace storage {
+AsyncIo *AsyncIo::_asyncIo = nullptr;
+
+void AsyncIoTask::Run() {
+  _status = TaskStatus::RUNNING;
+  if (_ioResult != (int32_t)_iov.iov_len) {
+    // Not submitted by io_uring, failed or short read, load it synchronously.
+    if (_ioResult >= 0 || _ioResult == NOT_SUBMITTED) {
+      LOG_DEBUG << "Read page synchronously, offset=" << _fileOffset
+                << "  result=" << _ioResult;
+    } else {
+      LOG_WARN << "Async read failed, offset=" << _fileOffset
+               << "  errno=" << -_ioResult
+               << "  file=" << _pageFile->GetPath().string();
+    }
+    _pageFile->ReadPage(_fileOffset, (char *)_iov.iov_base,
+                        (uint32_t)_iov.iov_len);
+  }
+
+  IoComplete();
+  _status = TaskStatus::FINISHED;
+}
+
+bool AsyncIo::InitAsyncIo(ThreadPool *tp) {
+  assert(_asyncIo == nullptr);
+  _asyncIo = new AsyncIo(tp);
+  uint32_t depth = Configure::GetAsyncIoQueueDepth();
+  if (depth > 0 && _asyncIo->SetupRing(depth)) {
+    AsyncIo *aio = _asyncIo;
+    aio->_reaper = new thread([aio]() { aio->ReapCompletions(); });
+    LOG_INFO << "AsyncIo started with io_uring, entries="
+             << _asyncIo->_sqEntries;
+    return true;
+  }
+
+  LOG_INFO << "AsyncIo started without io_uring, pages will be read by pread.";
+  return false;
+}
+
+void AsyncIo::StopAsyncIo() {
+  if (_asyncIo == nullptr)
+    return;
+
+  AsyncIo *aio = _asyncIo;
+  _asyncIo = nullptr;
+  delete aio;
+}
+
+void AsyncIo::SubmitRead(AsyncIoTask *task) {
+  assert(_asyncIo != nullptr);
+#ifdef ASYNC_IO_URING
+  if (_asyncIo->_ringFd >= 0 && _asyncIo->PushSqe(IORING_OP_READV, task))
+    return;
+#endif
+
+  task->_ioResult = AsyncIoTask::NOT_SUBMITTED;
+  _asyncIo->_threadPool->AddTask(task);
+}
+
+AsyncIo::~AsyncIo() {
+#ifdef ASYNC_IO_URING
+  if (_ringFd < 0)
+    return;
+
+  // Send a nop with user_data=0 to wake up the reaper thread, it will exit
+  // after all inflight requests have been completed.
+  while (!PushSqe(IORING_OP_NOP, nullptr)) {
+    this_thread::yield();
+  }
+
+  _reaper->join();
+  delete _reaper;
+
+  munmap(_sqes, _sqesSize);
+  if (_cqPtr != _sqPtr)
+    munmap(_cqPtr, _cqSize);
+  munmap(_sqPtr, _sqSize);
+  ::close(_ringFd);
+  _ringFd = -1;
+#endif
+}
+
+#ifdef ASYNC_IO_URING
+bool AsyncIo::SetupRing(uint32_t entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if (fd < 0) {
+    LOG_WARN << "Failed to setup io_uring, errno=" << errno;
+    return false;
+  }
+
+  _sqSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  _cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool bSingle = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (bSingle) {
+    _sqSize = _cqSize = max(_sqSize, _cqSize);
+  }
+
+  _sqPtr = mmap(nullptr, _sqSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (_sqPtr == MAP_FAILED) {
+    ::close(fd);
+    return false;
+  }
+
+  if (bSingle) {
+    _cqPtr = _sqPtr;
+  } else {
+    _cqPtr = mmap(nullptr, _cqSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (_cqPtr == MAP_FAILED) {
+      munmap(_sqPtr, _sqSize);
+      ::close(fd);
+      return false;
+    }
+  }
+
+  _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  _sqes = mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (_sqes == MAP_FAILED) {
+    if (_cqPtr != _sqPtr)
+      munmap(_cqPtr, _cqSize);
+    munmap(_sqPtr, _sqSize);
+    ::close(fd);
+    return false;
+  }
+
+  Byte *sq = (Byte *)_sqPtr;
+  _sqHead = (uint32_t *)(sq + params.sq_off.head);
+  _sqTail = (uint32_t *)(sq + params.sq_off.tail);
+  _sqMask = (uint32_t *)(sq + params.sq_off.ring_mask);
+  _sqArray = (uint32_t *)(sq + params.sq_off.array);
+  _sqEntries = params.sq_entries;
+
+  Byte *cq = (Byte *)_cqPtr;
+  _cqHead = (uint32_t *)(cq + params.cq_off.head);
+  _cqTail = (uint32_t *)(cq + params.cq_off.tail);
+  _cqMask = (uint32_t *)(cq + params.cq_off.ring_mask);
+  _cqes = cq + params.cq_off.cqes;
+  _cqEntries = params.cq_entries;
+
+  _ringFd = fd;
+  return true;
+}
+
+bool AsyncIo::PushSqe(uint8_t opcode, AsyncIoTask *task) {
+  unique_lock<SpinMutex> lock(_sqMutex);
+  // Keep one completion slot for the stop nop, so the completion queue can
+  // never overflow.
+  if (task != nullptr &&
+      _inflight.load(memory_order_relaxed) + 1 >= _cqEntries) {
+    return false;
+  }
+
+  uint32_t tail = *_sqTail;
+  uint32_t head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+  if (tail - head >= _sqEntries) {
+    return false;
+  }
+
+  uint32_t idx = tail & *_sqMask;
+  io_uring_sqe *sqe = &((io_uring_sqe *)_sqes)[idx];
+  memset(sqe, 0, sizeof(io_uring_sqe));
+  sqe->opcode = opcode;
+  sqe->fd = -1;
+  if (task != nullptr) {
+    sqe->fd = task->_pageFile->GetFd();
+    sqe->addr = (uint64_t)&task->_iov;
+    sqe->len = 1;
+    sqe->off = task->_fileOffset;
+    _inflight.fetch_add(1, memory_order_relaxed);
+  }
+  sqe->user_data = (uint64_t)task;
+  _sqArray[idx] = idx;
+  __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+  // Submit all pending entries, include the entries left by failed enter.
+  uint32_t toSubmit = tail + 1 - head;
+  int rt;
+  do {
+    rt = (int)syscall(__NR_io_uring_enter, _ringFd, toSubmit, 0, 0, nullptr,
+                      0);
+  } while (rt < 0 && errno == EINTR);
+
+  if (rt < 0) {
+    // The entry is still in ring and will be submitted with next request.
+    LOG_WARN << "io_uring_enter failed, errno=" << errno;
+  }
+  return true;
+}
+
+void AsyncIo::ReapCompletions() {
+  // The reaper thread do not use FastQueue, so its id set to negitive.
+  ThreadPool::AddThread("AsyncIoReaper", -1);
+  MVector<Task *> vct;
+  bool bStop = false;
+
+  while (!bStop || _inflight.load(memory_order_relaxed) > 0) {
+    uint32_t head = *_cqHead;
+    uint32_t tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      int rt = (int)syscall(__NR_io_uring_enter, _ringFd, 0, 1,
+                            IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (rt < 0 && errno != EINTR) {
+        LOG_ERROR << "io_uring_enter wait failed, errno=" << errno;
+        this_thread::sleep_for(1ms);
+      }
+      continue;
+    }
+
+    for (; head != tail; head++) {
+      io_uring_cqe *cqe = &((io_uring_cqe *)_cqes)[head & *_cqMask];
+      AsyncIoTask *task = (AsyncIoTask *)cqe->user_data;
+      if (task == nullptr) {
+        bStop = true;
+        continue;
+      }
+
+      task->_ioResult = cqe->res;
+      vct.push_back(task);
+    }
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+
+    _inflight.fetch_sub((uint32_t)vct.size(), memory_order_relaxed);
+    _threadPool->AddTasks(vct);
+    vct.clear();
+  }
+
+  ThreadPool::RemoveThread(-1);
+}
+#else
+bool AsyncIo::SetupRing(uint32_t entries) { return false; }
+bool AsyncIo::PushSqe(uint8_t opcode, AsyncIoTask *task) { return false; }
+void AsyncIo::ReapCompletions() {}
+#endif
+} // namespace storage
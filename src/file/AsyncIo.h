@@ -0,0 +1,99 @@
+#pragma once
+#include "../cache/Mallocator.h"
+#include "../utils/SpinMutex.h"
+#include "../utils/ThreadPool.h"
+#include "PageFile.h"
+#include <atomic>
+#include <sys/uio.h>
+#include <thread>
+
+namespace storage {
+/**A task to read a block from page file. It will be submitted to AsyncIo and
+ * added into thread pool after the data has been loaded into buffer, then call
+ * IoComplete. If the io request failed or io_uring is unavailable, it will read
+ * the data by pread in thread pool.*/
+class AsyncIoTask : public Task {
+public:
+  // The value of _ioResult if the task has not been submitted to io_uring
+  static const int32_t NOT_SUBMITTED = INT32_MIN;
+
+public:
+  AsyncIoTask(PageFile *pageFile, uint64_t fileOffset, char *bys,
+              uint32_t length)
+      : _pageFile(pageFile), _fileOffset(fileOffset) {
+    _iov.iov_base = bys;
+    _iov.iov_len = length;
+  }
+
+  bool IsSmallTask() override { return false; }
+  void Run() override;
+  // Called in thread pool after the data has been read into buffer.
+  virtual void IoComplete() = 0;
+
+protected:
+  PageFile *_pageFile;
+  uint64_t _fileOffset;
+  iovec _iov;
+  // The result from io_uring, the bytes has been read or -errno
+  int32_t _ioResult = NOT_SUBMITTED;
+  friend class AsyncIo;
+};
+
+/**Submit page reads into kernel by io_uring, one reaper thread waits for the
+ * completions and add the related tasks into thread pool. So the threads in
+ * pool will not be blocked by disk. If io_uring is not supported by the kernel
+ * or the ring is full, the tasks will be added into thread pool directly and
+ * read data by pread.*/
+class AsyncIo {
+public:
+  static bool InitAsyncIo(ThreadPool *tp);
+  static void StopAsyncIo();
+  static void SubmitRead(AsyncIoTask *task);
+  static bool IsRunning() { return _asyncIo != nullptr; }
+  // If the io requests are submitted by io_uring.
+  static bool IsUring() {
+    return _asyncIo != nullptr && _asyncIo->_ringFd >= 0;
+  }
+  static uint32_t GetInflightCount() {
+    return _asyncIo == nullptr
+               ? 0
+               : _asyncIo->_inflight.load(memory_order_relaxed);
+  }
+
+protected:
+  AsyncIo(ThreadPool *tp) : _threadPool(tp) {}
+  ~AsyncIo();
+  bool SetupRing(uint32_t entries);
+  // Push a submission entry into ring and enter kernel, user_data=task
+  bool PushSqe(uint8_t opcode, AsyncIoTask *task);
+  void ReapCompletions();
+
+protected:
+  static AsyncIo *_asyncIo;
+
+protected:
+  ThreadPool *_threadPool;
+  int _ringFd = -1;
+  void *_sqPtr = nullptr;
+  void *_cqPtr = nullptr;
+  void *_sqes = nullptr;
+  size_t _sqSize = 0;
+  size_t _cqSize = 0;
+  size_t _sqesSize = 0;
+  uint32_t *_sqHead = nullptr;
+  uint32_t *_sqTail = nullptr;
+  uint32_t *_sqMask = nullptr;
+  uint32_t *_sqArray = nullptr;
+  uint32_t _sqEntries = 0;
+  uint32_t *_cqHead = nullptr;
+  uint32_t *_cqTail = nullptr;
+  uint32_t *_cqMask = nullptr;
+  void *_cqes = nullptr;
+  uint32_t _cqEntries = 0;
+  // Lock when fill submission queue
+  SpinMutex _sqMutex;
+  // The requests have been submitted but not completed.
+  atomic<uint32_t> _inflight{0};
+  thread *_reaper = nullptr;
+};
+} // namespace storage
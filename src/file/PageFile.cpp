@@ -1,23 +1,39 @@
 ﻿#include "PageFile.h"
 #include "../config/Configure.h"
 #include "../utils/Log.h"
+#include <cerrno>
+#include <climits>
 
 namespace storage {
-PageFile::PageFile(const string &path) : _path(path) {
-  _file.open(_path, ios::in | ios::out | ios::binary);
-  if (!_file.is_open()) {
-    _file.open(_path, ios::out | ios::binary);
-    if (!_file.is_open()) {
-      _threadErrorMsg.reset(
-          new ErrorMsg(FILE_OPEN_FAILED, {_path.string().c_str()}));
-      LOG_ERROR << "Failed to initialize PageFile, path= " << _path.string();
-      _bValid = false;
-      return;
+// In direct mode, the buffer address and length must be aligned to disk
+// cluster.
+static inline bool IsAligned(const void *bys, uint64_t length) {
+  uint64_t align = Configure::GetDiskClusterSize();
+  return ((uint64_t)bys % align) == 0 && (length % align) == 0;
+}
+
+PageFile::PageFile(const string &path, bool bDirect) : _path(path) {
+#ifdef O_DIRECT
+  if (bDirect) {
+    _fd = open(_path.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (_fd >= 0) {
+      _bDirect = true;
+    } else if (errno == EINVAL) {
+      // The file system does not support direct I/O, use page cache.
+      LOG_WARN << "Direct I/O is not supported, path= " << _path.string();
     }
+  }
+#endif // O_DIRECT
 
-    _file.close();
-    _file.open(_path, ios::in | ios::out | ios::binary);
-    assert(_file.is_open());
+  if (_fd < 0) {
+    _fd = open(_path.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (_fd < 0) {
+    _threadErrorMsg.reset(
+        new ErrorMsg(FILE_OPEN_FAILED, {_path.string().c_str()}));
+    LOG_ERROR << "Failed to initialize PageFile, path= " << _path.string();
+    _bValid = false;
+    return;
   }
 
   _bValid = true;
@@ -25,11 +41,18 @@ PageFile::PageFile(const string &path) : _path(path) {
 
 uint32_t PageFile::ReadPage(uint64_t fileOffset, char *bys, uint32_t length) {
   assert(fileOffset % Configure::GetDiskClusterSize() == 0);
+  assert(!_bDirect || IsAligned(bys, length));
   assert(Length() > fileOffset);
 
-  _file.seekp(fileOffset, ios::beg);
-  _file.read(bys, length);
-  uint32_t len = (uint32_t)_file.gcount();
+  uint32_t len = 0;
+  while (len < length) {
+    ssize_t rt = pread(_fd, bys + len, length - len, fileOffset + len);
+    if (rt < 0 && errno == EINTR)
+      continue;
+    if (rt <= 0)
+      break;
+    len += (uint32_t)rt;
+  }
 
   assert(len == length);
   LOG_DEBUG << "Read a page, offset=" << fileOffset << "  length=" << length
@@ -39,11 +62,106 @@ uint32_t PageFile::ReadPage(uint64_t fileOffset, char *bys, uint32_t length) {
 
 void PageFile::WritePage(uint64_t fileOffset, char *bys, uint32_t length) {
   assert(fileOffset % Configure::GetDiskClusterSize() == 0);
+  assert(!_bDirect || IsAligned(bys, length));
+
+  uint32_t len = 0;
+  while (len < length) {
+    ssize_t rt = pwrite(_fd, bys + len, length - len, fileOffset + len);
+    if (rt < 0 && errno == EINTR)
+      continue;
+    if (rt <= 0) {
+      LOG_ERROR << "Failed to write a page, offset=" << fileOffset
+                << "  errno=" << errno << "  name=" << _path.string();
+      break;
+    }
+    len += (uint32_t)rt;
+  }
 
-  _file.seekp(fileOffset, ios::beg);
-  _file.write(bys, length);
   LOG_DEBUG << "Write a page, offset=" << fileOffset << "  length=" << length
             << "  name=" << _path.string();
 }
 
+uint64_t PageFile::ReadPages(uint64_t fileOffset, const iovec *iov,
+                             int iovcnt) {
+  assert(fileOffset % Configure::GetDiskClusterSize() == 0);
+  assert(iovcnt > 0 && iovcnt <= IOV_MAX);
+
+  uint64_t total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    assert(!_bDirect || IsAligned(iov[i].iov_base, iov[i].iov_len));
+    total += iov[i].iov_len;
+  }
+
+  ssize_t rt;
+  do {
+    rt = preadv(_fd, iov, iovcnt, fileOffset);
+  } while (rt < 0 && errno == EINTR);
+
+  if (rt >= 0 && (uint64_t)rt < total) {
+    // Short read, read the unfinished blocks one by one.
+    uint64_t pos = 0;
+    for (int i = 0; i < iovcnt; i++) {
+      if (pos + iov[i].iov_len > (uint64_t)rt) {
+        ReadPage(fileOffset + pos, (char *)iov[i].iov_base,
+                 (uint32_t)iov[i].iov_len);
+      }
+      pos += iov[i].iov_len;
+    }
+    rt = total;
+  }
+
+  LOG_DEBUG << "Read pages, offset=" << fileOffset << "  length=" << total
+            << "  blocks=" << iovcnt << "  name=" << _path.string();
+  return rt < 0 ? 0 : (uint64_t)rt;
+}
+
+void PageFile::WritePages(uint64_t fileOffset, const iovec *iov, int iovcnt) {
+  assert(fileOffset % Configure::GetDiskClusterSize() == 0);
+  assert(iovcnt > 0 && iovcnt <= IOV_MAX);
+
+  uint64_t total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    assert(!_bDirect || IsAligned(iov[i].iov_base, iov[i].iov_len));
+    total += iov[i].iov_len;
+  }
+
+  ssize_t rt;
+  do {
+    rt = pwritev(_fd, iov, iovcnt, fileOffset);
+  } while (rt < 0 && errno == EINTR);
+
+  if (rt < 0 || (uint64_t)rt < total) {
+    // Failed or short write, write the blocks one by one.
+    uint64_t pos = 0;
+    for (int i = 0; i < iovcnt; i++) {
+      if (rt < 0 || pos + iov[i].iov_len > (uint64_t)rt) {
+        WritePage(fileOffset + pos, (char *)iov[i].iov_base,
+                  (uint32_t)iov[i].iov_len);
+      }
+      pos += iov[i].iov_len;
+    }
+  }
+
+  LOG_DEBUG << "Write pages, offset=" << fileOffset << "  length=" << total
+            << "  blocks=" << iovcnt << "  name=" << _path.string();
+}
+
+bool PageFile::Allocate(uint64_t fileOffset, uint64_t length) {
+#ifdef __linux__
+  int rt;
+  do {
+    rt = fallocate(_fd, 0, fileOffset, length);
+  } while (rt < 0 && errno == EINTR);
+
+  if (rt == 0) {
+    LOG_DEBUG << "Allocate extent, offset=" << fileOffset
+              << "  length=" << length << "  name=" << _path.string();
+    return true;
+  }
+
+  LOG_WARN << "Failed to allocate extent, offset=" << fileOffset
+           << "  errno=" << errno << "  name=" << _path.string();
+#endif // __linux__
+  return false;
+}
 } // namespace storage
@@ -1,40 +1,65 @@
 ﻿#pragma once
 #include "../cache/Mallocator.h"
+#include "../config/Configure.h"
 #include "../dataType/IDataValue.h"
 #include "../utils/ErrorID.h"
 #include "../utils/ErrorMsg.h"
 #include "../utils/SpinMutex.h"
 #include <atomic>
+#include <fcntl.h>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 namespace storage {
 using namespace std;
 
+/**Page file for an index tree. It only uses positional read and write and has
+ * no shared file cursor, so one instance can be used by multi threads at the
+ * same time without lock. In direct mode, the file is opened with O_DIRECT and
+ * all buffers, offsets and lengths must be aligned to disk cluster.*/
 class PageFile {
 public:
-  PageFile(const string &path);
+  PageFile(const string &path, bool bDirect = Configure::IsDirectIo());
 
-  ~PageFile() {
-    if (_file.is_open())
-      _file.close();
-  }
+  ~PageFile() { close(); }
 
   uint32_t ReadPage(uint64_t fileOffset, char *bys, uint32_t length);
   void WritePage(uint64_t fileOffset, char *bys, uint32_t length);
+  // Read continuous blocks from fileOffset into the buffers in iov, return the
+  // total bytes have been read.
+  uint64_t ReadPages(uint64_t fileOffset, const iovec *iov, int iovcnt);
+  // Write buffers in iov into continuous blocks from fileOffset.
+  void WritePages(uint64_t fileOffset, const iovec *iov, int iovcnt);
+  // Preallocate disk blocks for [fileOffset, fileOffset + length) and extend
+  // the file length. Return false if the file system does not support it.
+  bool Allocate(uint64_t fileOffset, uint64_t length);
 
   uint64_t Length() {
-    _file.seekp(0, ios::end);
-    return _file.tellp();
+    struct stat st;
+    if (_fd < 0 || fstat(_fd, &st) != 0)
+      return 0;
+    return st.st_size;
   }
 
-  void close() { _file.close(); }
+  void close() {
+    if (_fd >= 0) {
+      ::close(_fd);
+      _fd = -1;
+    }
+  }
   bool IsValid() { return _bValid; }
+  bool IsDirect() { return _bDirect; }
+  // The raw file descriptor, used by AsyncIo to submit reads to the kernel
+  int GetFd() { return _fd; }
+  const filesystem::path &GetPath() { return _path; }
 
 protected:
   filesystem::path _path;
-  fstream _file;
+  int _fd = -1;
   bool _bValid;
+  bool _bDirect = false;
 };
 } // namespace storage
@@ -3,114 +3,327 @@
 #include "../utils/Log.h"
 #include "PageDividePool.h"
 #include "StoragePool.h"
-#include <forward_list>
+#include <fstream>
 #include <shared_mutex>
 
 namespace storage {
 SpinMutex PageBufferPool::_spinMutex;
 uint64_t PageBufferPool::_maxCacheSize =
     Configure::GetTotalCacheSize() / Configure::GetCachePageSize();
+uint64_t PageBufferPool::_highWatermark =
+    PageBufferPool::_maxCacheSize * Configure::GetPoolHighWatermark() / 100;
+uint64_t PageBufferPool::_hardLimit =
+    PageBufferPool::_maxCacheSize * Configure::GetPoolHardLimit() / 100;
+atomic_uint64_t PageBufferPool::_inlineEvictCount{0};
+atomic_uint64_t PageBufferPool::_evictCount{0};
+MHashMap<uint64_t, MVector<PageID>> PageBufferPool::_mapWarmup;
+SpinMutex PageBufferPool::_warmupMutex;
+DT_MicroSec PageBufferPool::_dtWarmupSave = MicroSecTime();
 int64_t PageBufferPool::_prevDelNum = 100;
-// Initialize _mapCache and add lambad to increase page reference when call find
-// method
-ConcurrentHashMap<uint64_t, CachePage *, true> PageBufferPool::_mapCache(
-    100, PageBufferPool::_maxCacheSize, [](CachePage *page) { page->IncRef(); },
-    [](CachePage *page) { page->DecRef(); });
+PageTable<CachePage> PageBufferPool::_pageTable(PageBufferPool::_maxCacheSize);
+TwoQueue<CachePage *> PageBufferPool::_twoQueue(PageBufferPool::_maxCacheSize);
+SpinMutex PageBufferPool::_queueMutex;
+MVector<CachePage *> PageBufferPool::_vctRemoved;
+atomic_bool PageBufferPool::_bTreeClosed{false};
+atomic_bool PageBufferPool::_bOverQuota{false};
 ThreadPool *PageBufferPool::_threadPool;
 atomic_bool PageBufferPool::_bInThreadPool{false};
 
+// The first 4 bytes of warm-up file
+static const uint32_t WARMUP_FILE_MAGIC = 0x50574452;
+
+bool PageBufferPool::ErasePage(CachePage *page) {
+  if (!page->Releaseable())
+    return false;
+
+  CachePage *removed =
+      _pageTable.EraseIf(page->HashCode(), [](CachePage *p) {
+        if (!p->TryEvict())
+          return false;
+        // Count before the page disappears from table, see
+        // IndexTree::AddLoadedPage.
+        _evictCount.fetch_add(1);
+        return true;
+      });
+  if (removed == nullptr)
+    return false;
+
+  removed->GetIndexTree()->DecPoolPages();
+  _pageTable.Retire(removed);
+  return true;
+}
+
+bool PageBufferPool::EvictPage(CachePage *page) {
+  IndexTree *tree = page->GetIndexTree();
+  if (!tree->IsClosed()) {
+    if (tree->IsPinBranches() && page->GetPageType() == PageType::BRANCH_PAGE)
+      return false;
+    if (tree->GetPoolPages() <= tree->GetPoolMinPages())
+      return false;
+  }
+
+  return ErasePage(page);
+}
+
+uint64_t PageBufferPool::EraseRemovedPages() {
+  unique_lock<SpinMutex> lock(_queueMutex);
+  if (_vctRemoved.size() == 0)
+    return 0;
+
+  // The reference held by _vctRemoved keeps the pages from evicted by others,
+  // so all of them are still in queue.
+  MHashSet<CachePage *> setRemoved(_vctRemoved.begin(), _vctRemoved.end());
+  uint64_t count = _twoQueue.RemoveIf([&setRemoved](CachePage *page) {
+    if (setRemoved.find(page) == setRemoved.end())
+      return false;
+
+    page->DecRef();
+    if (!ErasePage(page)) {
+      page->IncRef();
+      return false;
+    }
+
+    // The page will not be freed before Reclaim, its tree is still alive.
+    page->GetIndexTree()->ReleasePageId(page->GetPageId(), 1);
+    setRemoved.erase(page);
+    return true;
+  });
+
+  // Some pages are still used by other threads, try again in next time.
+  size_t pos = 0;
+  for (CachePage *page : _vctRemoved) {
+    if (setRemoved.find(page) != setRemoved.end())
+      _vctRemoved[pos++] = page;
+  }
+  _vctRemoved.resize(pos);
+  return count;
+}
+
 void PageBufferPool::AddPage(CachePage *page) {
-  _mapCache.Insert(page->HashCode(), page);
+  uint64_t hash = page->HashCode();
+  if (!_pageTable.Insert(hash, page))
+    return;
+
+  IndexTree *tree = page->GetIndexTree();
+  tree->IncPoolPages();
+  bool bOverQuota = tree->IsOverPoolQuota();
+  if (bOverQuota)
+    _bOverQuota.store(true);
+
+  unique_lock<SpinMutex> lock(_queueMutex);
+  _twoQueue.Push(page, hash);
+  uint64_t sz = _twoQueue.Size();
+  if (sz <= _highWatermark && !bOverQuota)
+    return;
+
+  if (sz > _hardLimit) {
+    // Evict a few pages for every new page, so the pool can not grow far away
+    // from hard limit even if PoolManage can not catch up.
+    uint64_t n = _twoQueue.Evict(
+        INLINE_EVICT_PAGES,
+        [](CachePage *page) { return EvictPage(page); },
+        INLINE_VISIT_PAGES);
+    if (n > 0)
+      _inlineEvictCount.fetch_add(n, memory_order_relaxed);
+  }
+  lock.unlock();
+
+  if (_threadPool != nullptr && !_bInThreadPool.load(memory_order_relaxed))
+    PushTask();
 }
 
 CachePage *PageBufferPool::GetPage(uint64_t hashId) {
-  CachePage *page = nullptr;
-  _mapCache.Find(hashId, page);
+  CachePage *page = _pageTable.Find(hashId);
+  if (page != nullptr) {
+    page->SetReferenced();
+  }
   return page;
 }
 
 void PageBufferPool::StopPool() {
-  for (int i = 0; i < _mapCache.GetGroupCount(); i++) {
-    _mapCache.Clear(i);
+  unique_lock<SpinMutex> lock(_queueMutex);
+  for (CachePage *page : _vctRemoved)
+    page->DecRef();
+  MVector<CachePage *>().swap(_vctRemoved);
+  _pageTable.Clear();
+  _twoQueue.Clear();
+  {
+    unique_lock<SpinMutex> wlock(_warmupMutex);
+    MHashMap<uint64_t, MVector<PageID>>().swap(_mapWarmup);
   }
 
   _threadPool = nullptr;
 }
 
 void PageBufferPool::PoolManage() {
-  int64_t numDel = _mapCache.Size() - _maxCacheSize * 4 / 5;
-
-  if (numDel > _prevDelNum * 2) {
-    numDel = _prevDelNum * 2;
-    if (numDel > 100000)
-      numDel = 100000;
-  } else if (numDel < _prevDelNum / 2) {
-    numDel = _prevDelNum / 2;
-    if (numDel < 1000)
-      numDel = 1000;
-  }
-
-  _prevDelNum = numDel;
-  int64_t grDel = numDel / _mapCache.GetGroupCount();
-  int delCount = 0;
-
-  static auto cmp = [](CachePage *left, CachePage *right) {
-    return left->GetAccessTime() < right->GetAccessTime();
-  };
-
-  for (int i = 0; i < _mapCache.GetGroupCount(); i++) {
-    priority_queue<CachePage *, MDeque<CachePage *>, decltype(cmp)> queue(cmp);
-    forward_list<CachePage *> flist;
-
-    for (auto iter = _mapCache.Begin(i); iter != _mapCache.End(i); iter++) {
-      CachePage *page = iter->second;
-
-      if (!page->Releaseable()) {
-        continue;
-      }
-
-      if (page->GetIndexTree()->IsClosed()) {
-        flist.push_front(page);
-        continue;
-      }
-
-      if ((int64_t)queue.size() < grDel) {
-        queue.push(page);
-      } else if (page->GetAccessTime() < queue.top()->GetAccessTime()) {
-        queue.pop();
-        queue.push(page);
-      }
-    }
+  uint64_t delCount = EraseRemovedPages();
+  if (_bTreeClosed.exchange(false)) {
+    bool bRemain = false;
+    unique_lock<SpinMutex> lock(_queueMutex);
+    delCount += _twoQueue.RemoveIf([&bRemain](CachePage *page) {
+      if (!page->GetIndexTree()->IsClosed())
+        return false;
+      if (ErasePage(page))
+        return true;
 
-    if (flist.empty() && queue.empty())
-      continue;
+      bRemain = true;
+      return false;
+    });
 
-    _mapCache.Lock(i);
+    // Some pages are still used, try again in next time.
+    if (bRemain)
+      _bTreeClosed.store(true);
+  }
 
-    for (CachePage *page : flist) {
-      _mapCache.Erase(i, page->HashCode());
-      delCount++;
-    }
+  if (_bOverQuota.exchange(false)) {
+    // Evict the pages of the trees over quota from the coldest.
+    bool bRemain = false;
+    unique_lock<SpinMutex> lock(_queueMutex);
+    delCount += _twoQueue.RemoveIf([&bRemain](CachePage *page) {
+      IndexTree *tree = page->GetIndexTree();
+      if (!tree->IsOverPoolQuota())
+        return false;
+      if (EvictPage(page))
+        return true;
 
-    while (queue.size() > 0) {
-      CachePage *page = queue.top();
-      queue.pop();
+      bRemain = true;
+      return false;
+    });
 
-      if (!page->Releaseable()) {
-        continue;
-      }
+    if (bRemain)
+      _bOverQuota.store(true);
+  }
 
-      _mapCache.Erase(i, page->HashCode());
-      delCount++;
+  int64_t numDel = _pageTable.Size() -
+                   _maxCacheSize * Configure::GetPoolLowWatermark() / 100;
+  if (numDel > 0) {
+    if (numDel > _prevDelNum * 2) {
+      numDel = _prevDelNum * 2;
+      if (numDel > 100000)
+        numDel = 100000;
+    } else if (numDel < _prevDelNum / 2) {
+      numDel = _prevDelNum / 2;
+      if (numDel < 1000)
+        numDel = 1000;
     }
-    _mapCache.Unlock(i);
+    _prevDelNum = numDel;
+  }
+
+  // Evict in small batches to avoid blocking AddPage for a long time.
+  while (numDel > 0) {
+    uint64_t batch = numDel > 1000 ? 1000 : numDel;
+    unique_lock<SpinMutex> lock(_queueMutex);
+    uint64_t n = _twoQueue.Evict(
+        batch, [](CachePage *page) { return EvictPage(page); });
+    lock.unlock();
+
+    delCount += n;
+    numDel -= batch;
+    if (n < batch)
+      break;
+  }
+
+  // Free the evicted pages, include the pages evicted by AddPage.
+  _pageTable.Reclaim();
+
+  uint32_t interval = Configure::GetWarmupSaveInterval();
+  if (interval > 0 &&
+      MicroSecTime() - _dtWarmupSave >= interval * 1000000ULL) {
+    _dtWarmupSave = MicroSecTime();
+    SaveWarmupList();
   }
 
   _bInThreadPool.store(false);
-  LOG_INFO << "MaxPage=" << _maxCacheSize << "\tUsedPage=" << _mapCache.Size()
+  LOG_INFO << "MaxPage=" << _maxCacheSize << "\tUsedPage=" << _pageTable.Size()
            << "\tRemoved page:" << delCount;
 }
 
+uint64_t PageBufferPool::SaveWarmupList(const string &path) {
+  MVector<uint64_t> vctHash;
+  {
+    unique_lock<SpinMutex> lock(_queueMutex);
+    vctHash.reserve(_twoQueue.Size());
+    _twoQueue.ForEach([&vctHash](CachePage *page, uint64_t key) {
+      if (page->GetPageStatus() == PageStatus::VALID &&
+          !page->GetIndexTree()->IsClosed())
+        vctHash.push_back(key);
+    });
+  }
+
+  {
+    // Keep the pages of the trees that have not been opened since restart.
+    unique_lock<SpinMutex> lock(_warmupMutex);
+    for (auto &pr : _mapWarmup) {
+      for (PageID pid : pr.second)
+        vctHash.push_back(CachePage::CalcHashCode(pr.first, pid));
+    }
+  }
+
+  // Write into a temporary file and rename it, so a crash during writing will
+  // not destroy the last list.
+  string tmpPath = path + ".tmp";
+  uint64_t count = vctHash.size();
+  ofstream ofs(tmpPath, ios::binary | ios::trunc);
+  ofs.write((const char *)&WARMUP_FILE_MAGIC, sizeof(WARMUP_FILE_MAGIC));
+  ofs.write((const char *)&count, sizeof(count));
+  ofs.write((const char *)vctHash.data(), count * sizeof(uint64_t));
+  ofs.close();
+
+  error_code ec;
+  if (ofs.good())
+    filesystem::rename(tmpPath, path, ec);
+  if (!ofs.good() || ec) {
+    LOG_WARN << "Failed to save warm-up list, path=" << path;
+    return 0;
+  }
+
+  LOG_INFO << "Saved warm-up list, pages=" << count;
+  return count;
+}
+
+uint64_t PageBufferPool::LoadWarmupList(const string &path) {
+  ifstream ifs(path, ios::binary);
+  if (!ifs.is_open())
+    return 0;
+
+  uint32_t magic = 0;
+  uint64_t count = 0;
+  ifs.read((char *)&magic, sizeof(magic));
+  ifs.read((char *)&count, sizeof(count));
+  error_code ec;
+  uint64_t fileSize = filesystem::file_size(path, ec);
+  if (!ifs.good() || magic != WARMUP_FILE_MAGIC || ec ||
+      fileSize != sizeof(magic) + sizeof(count) + count * sizeof(uint64_t)) {
+    LOG_WARN << "Invalid warm-up list, path=" << path;
+    return 0;
+  }
+
+  MVector<uint64_t> vctHash(count);
+  ifs.read((char *)vctHash.data(), count * sizeof(uint64_t));
+  if (!ifs.good()) {
+    LOG_WARN << "Failed to load warm-up list, path=" << path;
+    return 0;
+  }
+
+  unique_lock<SpinMutex> lock(_warmupMutex);
+  for (uint64_t hash : vctHash) {
+    _mapWarmup[hash >> 32].push_back((PageID)hash);
+  }
+
+  LOG_INFO << "Loaded warm-up list, pages=" << count;
+  return count;
+}
+
+void PageBufferPool::TakeWarmupPages(uint64_t fileId, MVector<PageID> &vctId) {
+  unique_lock<SpinMutex> lock(_warmupMutex);
+  auto iter = _mapWarmup.find(fileId);
+  if (iter == _mapWarmup.end())
+    return;
+
+  vctId.swap(iter->second);
+  _mapWarmup.erase(iter);
+}
+
 void PageBufferPool::AddTimerTask() {
   TimerThread::AddCircleTask("PageBufferPool", 5000000, []() {
     assert(_threadPool != nullptr);
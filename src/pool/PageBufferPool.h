@@ -1,18 +1,44 @@
 ﻿#pragma once
 #include "../core/CachePage.h"
-#include "../utils/ConcurrentHashMap.h"
 #include "../utils/SpinMutex.h"
 #include "../utils/ThreadPool.h"
 #include "../utils/TimerThread.h"
+#include "../utils/TwoQueue.h"
+#include "PageTable.h"
 
 namespace storage {
 using namespace std;
 class PagePoolTask;
 
+/**The pool to cache pages in memory. The pages are evicted by 2Q policy, see
+ * TwoQueue, so a large scan can not flush the hot pages of point lookups.
+ * An index tree can reserve pages, limit its share and pin its branch pages in
+ * the pool, see IndexTree::SetPoolQuota, so a large table can not flush the
+ * pages of a small critical table.*/
 class PageBufferPool {
+public:
+  /**Hold it when read a page pointer without reference, such as a swizzled
+   * pointer. The pages passed to ReleaseLater are not freed before it exits.*/
+  class ReadGuard : public PageTable<CachePage>::EpochGuard {
+  public:
+    ReadGuard() : PageTable<CachePage>::EpochGuard(&_pageTable) {}
+  };
+
+public:
+  // The max pages to evict and visit by a thread when it adds a page above
+  // hard limit.
+  static const uint64_t INLINE_EVICT_PAGES = 4;
+  static const uint64_t INLINE_VISIT_PAGES = 64;
+
 public:
   static uint64_t GetMaxCacheSize() { return _maxCacheSize; }
-  static void SetMaxCacheSize(uint64_t sz) { _maxCacheSize = sz; }
+  static void SetMaxCacheSize(uint64_t sz) {
+    unique_lock<SpinMutex> lock(_queueMutex);
+    _maxCacheSize = sz;
+    _twoQueue.SetCapacity(sz);
+    _highWatermark = sz * Configure::GetPoolHighWatermark() / 100;
+    _hardLimit = sz * Configure::GetPoolHardLimit() / 100;
+  }
 
   static void AddPage(CachePage *page);
 
@@ -21,14 +47,56 @@ public:
   }
 
   static CachePage *GetPage(uint64_t hashId);
+  // Decrease the reference of page after all ReadGuard existing now exit.
+  static void ReleaseLater(CachePage *page) { _pageTable.Retire(page); }
+  /**Remove a page that is not used by its index tree any more, such as a page
+   * merged into its sibling. The caller's reference is passed to this pool.
+   * The next PoolManage erases it after other threads have released it, then
+   * returns its page id to the index tree to reuse.*/
+  static void RemovePage(CachePage *page) {
+    unique_lock<SpinMutex> lock(_queueMutex);
+    _vctRemoved.push_back(page);
+  }
+  static uint64_t GetRemovingCount() {
+    unique_lock<SpinMutex> lock(_queueMutex);
+    return _vctRemoved.size();
+  }
   /**For test purpose, manually add a PagePoolTask into thread pool*/
   static void PushTask();
 
   static void PoolManage();
+  // Called after an index tree closed, the next PoolManage will remove all
+  // its pages.
+  static void SetTreeClosed() { _bTreeClosed.store(true); }
   static void AddTimerTask();
   static void RemoveTimerTask();
 
-  static uint64_t GetCacheSize() { return _mapCache.Size(); }
+  static uint64_t GetCacheSize() { return _pageTable.Size(); }
+  // How many pages have been evicted by the threads adding pages
+  static uint64_t GetInlineEvictCount() {
+    return _inlineEvictCount.load(memory_order_relaxed);
+  }
+  // How many pages have been evicted from this pool
+  static uint64_t GetEvictCount() {
+    return _evictCount.load();
+  }
+  /** @brief Save the ids of the pages in pool into a file, from the hottest to
+   * the coldest. It is called by PoolManage every
+   * Configure::GetWarmupSaveInterval() seconds.
+   * @return How many page ids have been saved, 0 if failed to write.
+   */
+  static uint64_t
+  SaveWarmupList(const string &path = Configure::GetWarmupFile());
+  /** @brief Load the page ids saved by SaveWarmupList. Called once at startup
+   * before open the index trees, then every tree loads its pages in list by
+   * PageWarmup after opened.
+   * @return How many page ids have been loaded.
+   */
+  static uint64_t
+  LoadWarmupList(const string &path = Configure::GetWarmupFile());
+  // Take out the loaded page ids of an index file, from the hottest to the
+  // coldest.
+  static void TakeWarmupPages(uint64_t fileId, MVector<PageID> &vctId);
   static void InitPool(ThreadPool *tp) {
     assert(_threadPool == nullptr);
     _threadPool = tp;
@@ -36,10 +104,40 @@ public:
   static void StopPool();
 
 protected:
-  static ConcurrentHashMap<uint64_t, CachePage *, true> _mapCache;
+  // Remove the page from _pageTable if it is releaseable, the page will be
+  // freed after the lookups that maybe see it have finished.
+  static bool ErasePage(CachePage *page);
+  // Erase the page if it is not protected by the quota of its index tree, see
+  // IndexTree::SetPoolQuota and IndexTree::SetPinBranches.
+  static bool EvictPage(CachePage *page);
+  // Erase the pages passed to RemovePage and release their page ids.
+  static uint64_t EraseRemovedPages();
+
+protected:
+  static PageTable<CachePage> _pageTable;
   static SpinMutex _spinMutex;
+  // Replacement policy for the pages in _pageTable, locked by _queueMutex
+  static TwoQueue<CachePage *> _twoQueue;
+  static SpinMutex _queueMutex;
+  // The pages passed to RemovePage and not erased yet, locked by _queueMutex
+  static MVector<CachePage *> _vctRemoved;
+  // If there are pages of closed index trees to remove.
+  static atomic_bool _bTreeClosed;
+  // If there are index trees with more pages than their max quota.
+  static atomic_bool _bOverQuota;
   // The max cache pages in this pool
   static uint64_t _maxCacheSize;
+  // Schedule PoolManage at once when the pages in pool exceed it.
+  static uint64_t _highWatermark;
+  // The threads adding pages will evict pages when the pages exceed it.
+  static uint64_t _hardLimit;
+  static atomic_uint64_t _inlineEvictCount;
+  static atomic_uint64_t _evictCount;
+  // The page ids loaded by LoadWarmupList, file id to page ids.
+  static MHashMap<uint64_t, MVector<PageID>> _mapWarmup;
+  static SpinMutex _warmupMutex;
+  // The last time to save the warm-up list
+  static DT_MicroSec _dtWarmupSave;
   // To save how many pages have been removed from this pool in previous clean
   // task.
   static int64_t _prevDelNum;
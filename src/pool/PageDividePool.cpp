@@ -1,22 +1,41 @@
 ﻿#include "PageDividePool.h"
 #include "../config/Configure.h"
+#include "PageBufferPool.h"
 #include "StoragePool.h"
 
 namespace storage {
 const uint32_t PageDividePool::BUFFER_FLUSH_INTEVAL_MS = 10 * 1000;
 const uint64_t PageDividePool::QUEUE_LIMIT_SIZE = 1000;
-SpinMutex PageDividePool::_spinMutex;
 PageDividePool *PageDividePool::_divPool = nullptr;
+atomic<uint64_t> PageDividePool::_divideCount{0};
+atomic<uint64_t> PageDividePool::_divideTotalUs{0};
+atomic<uint64_t> PageDividePool::_divideMaxUs{0};
+
+PageDividePool::PageDividePool(ThreadPool *tp) : _threadPool(tp) {
+  uint32_t parts = Configure::GetDividePartitions();
+  if (parts == 0)
+    parts = 1;
+
+  _vctPart.reserve(parts);
+  for (uint32_t i = 0; i < parts; i++) {
+    _vctPart.push_back(new DividePartition(tp));
+  }
+}
+
+PageDividePool::~PageDividePool() {
+  for (DividePartition *part : _vctPart) {
+    delete part;
+  }
+}
 
 void PageDividePool::AddTimerTask() {
   TimerThread::AddCircleTask("PageDividePool", 1000000, []() {
     assert(_divPool != nullptr);
-    bool b = _divPool->_bInThreadPool.exchange(true, memory_order_relaxed);
-    if (b)
-      return;
-
-    PageDivideTask *task = new PageDivideTask();
-    _divPool->_threadPool->AddTask(task);
+    for (DividePartition *part : _divPool->_vctPart) {
+      if (part->_mapPage.size() == 0 && part->_fastQueue.Empty())
+        continue;
+      PushTask(part);
+    }
   });
 }
 void PageDividePool::RemoveTimerTask() {
@@ -24,7 +43,17 @@ void PageDividePool::RemoveTimerTask() {
 }
 
 void PageDividePool::StopPool() {
-  while (!_divPool->_fastQueue.Empty()) {
+  while (true) {
+    bool bEmpty = true;
+    for (DividePartition *part : _divPool->_vctPart) {
+      if (!part->_fastQueue.Empty()) {
+        bEmpty = false;
+        break;
+      }
+    }
+    if (bEmpty)
+      break;
+
     PoolManage();
   }
   delete _divPool;
@@ -33,31 +62,51 @@ void PageDividePool::StopPool() {
 
 void PageDividePool::PushTask() {
   assert(_divPool != nullptr);
-  bool b = _divPool->_bInThreadPool.exchange(true, memory_order_relaxed);
+  for (DividePartition *part : _divPool->_vctPart) {
+    PushTask(part);
+  }
+}
+
+void PageDividePool::PushTask(DividePartition *part) {
+  bool b = part->_bInThreadPool.exchange(true, memory_order_relaxed);
   if (b)
     return;
-  PageDivideTask *task = new PageDivideTask();
+  PageDivideTask *task = new PageDivideTask(part);
   _divPool->_threadPool->AddTask(task);
 }
 
+size_t PageDividePool::GetTaskCount() {
+  size_t count = 0;
+  for (DividePartition *part : _divPool->_vctPart) {
+    count += part->_mapPage.size();
+  }
+  return count;
+}
+
 void PageDividePool::PoolManage() {
+  for (DividePartition *part : _divPool->_vctPart) {
+    unique_lock<SpinMutex> lock(part->_spinMutex);
+    PartitionManage(part);
+  }
+}
+
+void PageDividePool::PartitionManage(DividePartition *part) {
   queue<IndexPage *> q;
-  _divPool->_fastQueue.Swap(q);
+  part->_fastQueue.Swap(q);
   while (q.size() > 0) {
     IndexPage *page = q.front();
     q.pop();
 
-    if (_divPool->_mapPage.find(page->HashCode()) != _divPool->_mapPage.end()) {
+    if (part->_mapPage.find(page->HashCode()) != part->_mapPage.end()) {
       page->DecRef();
     } else {
       page->UpdateDividTime();
-      _divPool->_mapPage.insert({page->HashCode(), page});
+      part->_mapPage.insert({page->HashCode(), page});
     }
   }
 
-  bool unfull = (_divPool->_mapPage.size() < QUEUE_LIMIT_SIZE);
-  for (auto iter = _divPool->_mapPage.begin();
-       iter != _divPool->_mapPage.end();) {
+  bool unfull = (part->_mapPage.size() < QUEUE_LIMIT_SIZE);
+  for (auto iter = part->_mapPage.begin(); iter != part->_mapPage.end();) {
     auto page = iter->second;
     if (page->GetTranCount() > 0UL || page->GetWaitTasks().size() > 0 ||
         (unfull && !page->IsDividOverTime(BUFFER_FLUSH_INTEVAL_MS) &&
@@ -76,14 +125,29 @@ void PageDividePool::PoolManage() {
 
     bool bPassed = false;
     if (page->GetTotalDataLength() > page->GetMaxDataLength()) {
+      DT_MicroSec dtStart = MicroSecTime();
       page->PageDivide();
+      uint64_t us = MicroSecTime() - dtStart;
+      _divideCount.fetch_add(1, memory_order_relaxed);
+      _divideTotalUs.fetch_add(us, memory_order_relaxed);
+      uint64_t maxUs = _divideMaxUs.load(memory_order_relaxed);
+      while (us > maxUs && !_divideMaxUs.compare_exchange_weak(
+                               maxUs, us, memory_order_relaxed)) {
+      }
       iter++;
+    } else if (page->IsUnderfull() && !page->GetIndexTree()->IsClosed() &&
+               page->PageMerge()) {
+      // Keep it in divid status, so it will not be added again.
+      page->WriteUnlock();
+      PageBufferPool::RemovePage(page);
+      iter = part->_mapPage.erase(iter);
+      continue;
     } else {
       page->SetInDivid(false);
       bPassed = page->SaveRecords();
       if (bPassed) {
         StoragePool::AddPage(page, false);
-        iter = _divPool->_mapPage.erase(iter);
+        iter = part->_mapPage.erase(iter);
       } else {
         page->SetInDivid(true);
         iter++;
@@ -93,6 +157,6 @@ void PageDividePool::PoolManage() {
     page->WriteUnlock();
   }
 
-  _divPool->_bInThreadPool.store(false);
+  part->_bInThreadPool.store(false);
 }
 } // namespace storage
@@ -27,39 +27,87 @@ public:
         page->IncRef();
       }
       page->SetInDivid(true);
-      _divPool->_fastQueue.Push(page);
+      _divPool->GetPartition(page)->_fastQueue.Push(page);
     }
   }
+  // Manage all partitions one by one in current thread.
   static void PoolManage();
   static void StopPool();
+  // Push a PageDivideTask for every partition
   static void PushTask();
 
-  static size_t GetTaskCount() { return _divPool->_mapPage.size(); }
+  // How many pages are waiting in all partitions
+  static size_t GetTaskCount();
+  static uint32_t GetPartitionCount() {
+    return (uint32_t)_divPool->_vctPart.size();
+  }
+  // How many pages are waiting in a partition, neglect the pages that have not
+  // been moved from the fast queue's inner queues.
+  static size_t GetQueueDepth(uint32_t part) {
+    DividePartition *dp = _divPool->_vctPart[part];
+    return dp->_mapPage.size() + dp->_fastQueue.RoughSize();
+  }
+  // How many times the pages have been divided and how long they spent.
+  static uint64_t GetDivideCount() {
+    return _divideCount.load(memory_order_relaxed);
+  }
+  static uint64_t GetDivideTotalUs() {
+    return _divideTotalUs.load(memory_order_relaxed);
+  }
+  static uint64_t GetDivideMaxUs() {
+    return _divideMaxUs.load(memory_order_relaxed);
+  }
   static void InitPool(ThreadPool *tp) {
     assert(_divPool == nullptr);
     _divPool = new PageDividePool(tp);
   }
 
 protected:
-  static SpinMutex _spinMutex;
+  // The pages of an index tree are always in the same partition, so the
+  // divides and merges of a tree are serial. Different partitions are managed
+  // by different PageDivideTasks in parallel.
+  struct DividePartition {
+    DividePartition(ThreadPool *tp) : _fastQueue(tp) {}
+    MTreeMap<uint64_t, IndexPage *> _mapPage;
+    FastQueue<IndexPage> _fastQueue;
+    // Only one thread can manage this partition at the same time
+    SpinMutex _spinMutex;
+    // If thread pool has PageDivideTask for this partition, include waitting
+    // and running
+    atomic_bool _bInThreadPool{false};
+  };
+
+protected:
   static PageDividePool *_divPool;
+  static atomic<uint64_t> _divideCount;
+  static atomic<uint64_t> _divideTotalUs;
+  static atomic<uint64_t> _divideMaxUs;
 
 protected:
-  PageDividePool(ThreadPool *tp) : _fastQueue(tp), _threadPool(tp) {}
-  MTreeMap<uint64_t, IndexPage *> _mapPage;
-  FastQueue<IndexPage> _fastQueue;
+  PageDividePool(ThreadPool *tp);
+  ~PageDividePool();
+  inline DividePartition *GetPartition(IndexPage *page) {
+    return _vctPart[page->GetFileId() % _vctPart.size()];
+  }
+  static void PushTask(DividePartition *part);
+  // Divide, merge or save the pages in a partition, the caller must hold
+  // part->_spinMutex.
+  static void PartitionManage(DividePartition *part);
+
+protected:
+  vector<DividePartition *> _vctPart;
   ThreadPool *_threadPool;
-  // If thread pool has PageDivideTask, include watting and running
-  atomic_bool _bInThreadPool{false};
   friend class PageDivideTask;
 };
 
 class PageDivideTask : public Task {
+public:
+  PageDivideTask(PageDividePool::DividePartition *part) : _part(part) {}
   void Run() override {
-    unique_lock<SpinMutex> lock(PageDividePool::_spinMutex, defer_lock);
+    unique_lock<SpinMutex> lock(_part->_spinMutex, defer_lock);
     if (lock.try_lock()) {
       _status = TaskStatus::RUNNING;
-      PageDividePool::PoolManage();
+      PageDividePool::PartitionManage(_part);
       _status = TaskStatus::FINISHED;
     } else {
       _status = TaskStatus::INTERVAL;
@@ -67,5 +115,8 @@ class PageDivideTask : public Task {
   }
 
   bool IsSmallTask() override { return false; }
+
+protected:
+  PageDividePool::DividePartition *_part;
 };
 } // namespace storage
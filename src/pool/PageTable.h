@@ -0,0 +1,430 @@
+﻿#pragma once
+#include "../cache/Mallocator.h"
+#include "../utils/SpinMutex.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+namespace storage {
+using namespace std;
+/**Concurrent hash table from page hash code to page, used by PageBufferPool.
+ * It uses open addressing with linear probing on buckets, every bucket fills
+ * one cache line and holds ENTRIES_PER_BUCKET entries. Lookups do not write
+ * any shared lock: they read a bucket optimistically by its sequence number
+ * and only retry if a writer changed it at the same time. Writers lock the
+ * buckets by setting the sequence number to odd.
+ * The removed values and replaced tables can not be freed at once because the
+ * lookups maybe still read them. They are retired and freed by Reclaim after
+ * all lookups started before have finished, see EpochGuard.
+ * T need to provide IncRef() and DecRef(). Find increases the reference count
+ * of the value found, and the count of a retired value is decreased after it
+ * is reclaimed.*/
+template <class T> class PageTable {
+public:
+  static const uint32_t ENTRIES_PER_BUCKET = 3;
+  // The extra buckets at the end of table, so probing never wraps around.
+  static const uint32_t TAIL_BUCKETS = 64;
+  // The lookups are counted into different cache lines by threads.
+  static const uint32_t READER_STRIPES = 64;
+
+protected:
+  struct alignas(64) Bucket {
+    // Odd when a writer is changing this bucket
+    atomic<uint32_t> _seq{0};
+    // How many entries with home before this bucket are saved after it
+    atomic<uint32_t> _overflow{0};
+    atomic<uint64_t> _keys[ENTRIES_PER_BUCKET];
+    atomic<T *> _vals[ENTRIES_PER_BUCKET];
+  };
+
+  struct Table {
+    Table(uint32_t bits)
+        : _bits(bits), _homeCount(1ULL << bits),
+          _bucketCount(_homeCount + TAIL_BUCKETS),
+          _maxCount(_homeCount * ENTRIES_PER_BUCKET * 3 / 4) {
+      _buckets = new Bucket[_bucketCount];
+      for (uint64_t i = 0; i < _bucketCount; i++) {
+        for (uint32_t j = 0; j < ENTRIES_PER_BUCKET; j++) {
+          _buckets[i]._keys[j].store(0, memory_order_relaxed);
+          _buckets[i]._vals[j].store(nullptr, memory_order_relaxed);
+        }
+      }
+    }
+    ~Table() { delete[] _buckets; }
+    inline uint64_t Home(uint64_t key) const {
+      return (key * 0x9E3779B97F4A7C15ULL) >> (64 - _bits);
+    }
+
+    uint32_t _bits;
+    uint64_t _homeCount;
+    uint64_t _bucketCount;
+    // Grow the table when the entries exceed it
+    uint64_t _maxCount;
+    Bucket *_buckets;
+  };
+
+  struct alignas(64) ReaderCount {
+    atomic<int64_t> _count{0};
+  };
+
+public:
+  /**Mark a thread is reading the table. Reclaim flips the epoch and waits
+   * the readers of old epoch to finish, so it knows no one can still see the
+   * values removed before.*/
+  class EpochGuard {
+  public:
+    EpochGuard(PageTable *pt) {
+      uint64_t epoch = pt->_epoch.load(memory_order_relaxed);
+      _count = &pt->_readers[epoch & 1][GetStripe()]._count;
+      _count->fetch_add(1, memory_order_relaxed);
+      atomic_thread_fence(memory_order_seq_cst);
+    }
+    ~EpochGuard() { _count->fetch_sub(1, memory_order_release); }
+
+  protected:
+    atomic<int64_t> *_count;
+  };
+
+  PageTable(uint64_t capacity) {
+    uint32_t bits = 4;
+    while ((1ULL << bits) * ENTRIES_PER_BUCKET * 3 / 4 < capacity)
+      bits++;
+    _table.store(new Table(bits), memory_order_relaxed);
+  }
+
+  ~PageTable() {
+    assert(_count.load() == 0 && _vctRetired.size() == 0);
+    for (Table *t : _vctRetiredTable) {
+      delete t;
+    }
+    delete _table.load();
+  }
+
+  uint64_t Size() const { return _count.load(memory_order_relaxed); }
+  uint64_t GetBucketCount() const {
+    return _table.load(memory_order_relaxed)->_bucketCount;
+  }
+
+  /**Find the value by key and increase its reference count.
+   * @return The value or nullptr if not found.*/
+  T *Find(uint64_t key) {
+    EpochGuard guard(this);
+    while (true) {
+      Table *t = _table.load(memory_order_acquire);
+      T *val = nullptr;
+      bool bRetry = false;
+
+      for (uint64_t b = t->Home(key); b < t->_bucketCount;) {
+        Bucket &bk = t->_buckets[b];
+        uint32_t seq = bk._seq.load(memory_order_acquire);
+        if (seq & 1) {
+          this_thread::yield();
+          continue;
+        }
+
+        val = nullptr;
+        for (uint32_t i = 0; i < ENTRIES_PER_BUCKET; i++) {
+          T *v = bk._vals[i].load(memory_order_acquire);
+          if (v != nullptr && bk._keys[i].load(memory_order_relaxed) == key) {
+            val = v;
+            break;
+          }
+        }
+        uint32_t overflow = bk._overflow.load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (bk._seq.load(memory_order_relaxed) != seq)
+          continue;
+
+        if (val != nullptr) {
+          // Pair with the fence in LockBucket: if the bucket is unchanged
+          // after increasing, the writer will find it is referenced.
+          val->IncRef();
+          atomic_thread_fence(memory_order_seq_cst);
+          if (bk._seq.load(memory_order_relaxed) == seq &&
+              _table.load(memory_order_relaxed) == t) {
+            return val;
+          }
+
+          val->DecRef();
+          bRetry = true;
+          break;
+        }
+
+        if (overflow == 0)
+          break;
+        b++;
+      }
+
+      // Not found, but the table maybe has been replaced by a new one.
+      if (!bRetry && _table.load(memory_order_acquire) == t)
+        return nullptr;
+    }
+  }
+
+  /**Insert a value, the table holds the reference passed by caller.
+   * @return false if the key has existed.*/
+  bool Insert(uint64_t key, T *val) {
+    assert(val != nullptr);
+    while (true) {
+      shared_lock<SharedSpinMutex> lock(_writeMutex);
+      Table *t = _table.load(memory_order_relaxed);
+      if (_count.load(memory_order_relaxed) >= t->_maxCount) {
+        lock.unlock();
+        Grow(t);
+        continue;
+      }
+
+      // All writers for the same key lock its home bucket first.
+      uint64_t home = t->Home(key);
+      LockBucket(t->_buckets[home]);
+      uint64_t fb;
+      uint32_t fi;
+      if (FindSlot(t, home, key, fb, fi)) {
+        UnlockBucket(t->_buckets[home]);
+        return false;
+      }
+
+      for (uint64_t b = home; b < t->_bucketCount; b++) {
+        Bucket &bk = t->_buckets[b];
+        if (b != home)
+          LockBucket(bk);
+
+        for (uint32_t i = 0; i < ENTRIES_PER_BUCKET; i++) {
+          if (bk._vals[i].load(memory_order_relaxed) != nullptr)
+            continue;
+
+          // Tell the readers to probe further before the entry is visible.
+          for (uint64_t p = home; p < b; p++) {
+            t->_buckets[p]._overflow.fetch_add(1, memory_order_relaxed);
+          }
+          bk._keys[i].store(key, memory_order_relaxed);
+          bk._vals[i].store(val, memory_order_release);
+          _count.fetch_add(1, memory_order_relaxed);
+
+          if (b != home)
+            UnlockBucket(bk);
+          UnlockBucket(t->_buckets[home]);
+          return true;
+        }
+
+        if (b != home)
+          UnlockBucket(bk);
+      }
+
+      // No free slot till the end of table
+      UnlockBucket(t->_buckets[home]);
+      lock.unlock();
+      Grow(t);
+    }
+  }
+
+  /**Remove the value of key if funcCheck(val) returns true. funcCheck is
+   * called with the bucket locked, so Find can not get the value at the same
+   * time. The removed value is still referenced by the table, call Retire
+   * after it is not used.
+   * @return The removed value or nullptr.*/
+  template <class Func> T *EraseIf(uint64_t key, Func funcCheck) {
+    shared_lock<SharedSpinMutex> lock(_writeMutex);
+    Table *t = _table.load(memory_order_relaxed);
+    uint64_t home = t->Home(key);
+    Bucket &hb = t->_buckets[home];
+    LockBucket(hb);
+
+    T *val = nullptr;
+    uint64_t b;
+    uint32_t i;
+    if (FindSlot(t, home, key, b, i)) {
+      Bucket &bk = t->_buckets[b];
+      if (b != home)
+        LockBucket(bk);
+
+      T *v = bk._vals[i].load(memory_order_relaxed);
+      if (funcCheck(v)) {
+        bk._vals[i].store(nullptr, memory_order_relaxed);
+        _count.fetch_sub(1, memory_order_relaxed);
+        for (uint64_t p = home; p < b; p++) {
+          t->_buckets[p]._overflow.fetch_sub(1, memory_order_relaxed);
+        }
+        val = v;
+      }
+
+      if (b != home)
+        UnlockBucket(bk);
+    }
+
+    UnlockBucket(hb);
+    return val;
+  }
+
+  // Save a removed value, its reference will be decreased in Reclaim.
+  void Retire(T *val) {
+    unique_lock<SpinMutex> lock(_retireMutex);
+    _vctRetired.push_back(val);
+  }
+
+  /**Wait all lookups that maybe see the retired values to finish, then
+   * decrease the references of them and free the old tables.
+   * @return How many values have been released.*/
+  uint64_t Reclaim() {
+    MVector<T *> vct;
+    MVector<Table *> vctTable;
+    {
+      unique_lock<SpinMutex> lock(_retireMutex);
+      vct.swap(_vctRetired);
+      vctTable.swap(_vctRetiredTable);
+    }
+    if (vct.size() == 0 && vctTable.size() == 0)
+      return 0;
+
+    Synchronize();
+    for (T *val : vct) {
+      val->DecRef();
+    }
+    for (Table *t : vctTable) {
+      delete t;
+    }
+    return vct.size();
+  }
+
+  /**Remove all values and decrease their references, include the retired.
+   * It can only be called when no other thread uses this table.*/
+  void Clear() {
+    Table *t = _table.load(memory_order_relaxed);
+    for (uint64_t b = 0; b < t->_bucketCount; b++) {
+      Bucket &bk = t->_buckets[b];
+      bk._overflow.store(0, memory_order_relaxed);
+      for (uint32_t i = 0; i < ENTRIES_PER_BUCKET; i++) {
+        T *v = bk._vals[i].load(memory_order_relaxed);
+        if (v != nullptr) {
+          bk._vals[i].store(nullptr, memory_order_relaxed);
+          v->DecRef();
+        }
+      }
+    }
+    _count.store(0, memory_order_relaxed);
+
+    for (T *val : _vctRetired) {
+      val->DecRef();
+    }
+    for (Table *old : _vctRetiredTable) {
+      delete old;
+    }
+    MVector<T *>().swap(_vctRetired);
+    MVector<Table *>().swap(_vctRetiredTable);
+  }
+
+protected:
+  static uint32_t GetStripe() {
+    static atomic<uint32_t> nextStripe{0};
+    thread_local uint32_t stripe =
+        nextStripe.fetch_add(1, memory_order_relaxed) % READER_STRIPES;
+    return stripe;
+  }
+
+  static void LockBucket(Bucket &bk) {
+    while (true) {
+      uint32_t seq = bk._seq.load(memory_order_relaxed);
+      if ((seq & 1) == 0 &&
+          bk._seq.compare_exchange_weak(seq, seq + 1, memory_order_acquire)) {
+        break;
+      }
+      this_thread::yield();
+    }
+    // Pair with the fence in Find after IncRef
+    atomic_thread_fence(memory_order_seq_cst);
+  }
+
+  static void UnlockBucket(Bucket &bk) {
+    bk._seq.fetch_add(1, memory_order_release);
+  }
+
+  // Find the bucket and slot of key along the probing chain. The home bucket
+  // of key must have been locked, so the entry of key can not be changed.
+  static bool FindSlot(Table *t, uint64_t home, uint64_t key, uint64_t &bucket,
+                       uint32_t &idx) {
+    for (uint64_t b = home; b < t->_bucketCount; b++) {
+      Bucket &bk = t->_buckets[b];
+      for (uint32_t i = 0; i < ENTRIES_PER_BUCKET; i++) {
+        if (bk._vals[i].load(memory_order_acquire) != nullptr &&
+            bk._keys[i].load(memory_order_relaxed) == key) {
+          bucket = b;
+          idx = i;
+          return true;
+        }
+      }
+      if (bk._overflow.load(memory_order_relaxed) == 0)
+        break;
+    }
+    return false;
+  }
+
+  void Grow(Table *old) {
+    unique_lock<SharedSpinMutex> lock(_writeMutex);
+    if (_table.load(memory_order_relaxed) != old)
+      return;
+
+    // No writer now, the old table is stable.
+    Table *t = new Table(old->_bits + 1);
+    for (uint64_t ob = 0; ob < old->_bucketCount; ob++) {
+      for (uint32_t i = 0; i < ENTRIES_PER_BUCKET; i++) {
+        T *v = old->_buckets[ob]._vals[i].load(memory_order_relaxed);
+        if (v == nullptr)
+          continue;
+
+        uint64_t key = old->_buckets[ob]._keys[i].load(memory_order_relaxed);
+        bool bSaved = false;
+        uint64_t home = t->Home(key);
+        for (uint64_t b = home; b < t->_bucketCount && !bSaved; b++) {
+          Bucket &bk = t->_buckets[b];
+          for (uint32_t j = 0; j < ENTRIES_PER_BUCKET; j++) {
+            if (bk._vals[j].load(memory_order_relaxed) == nullptr) {
+              bk._keys[j].store(key, memory_order_relaxed);
+              bk._vals[j].store(v, memory_order_relaxed);
+              for (uint64_t p = home; p < b; p++) {
+                t->_buckets[p]._overflow.fetch_add(1, memory_order_relaxed);
+              }
+              bSaved = true;
+              break;
+            }
+          }
+        }
+        // The new table is two times of the old one, it can not be full.
+        assert(bSaved);
+      }
+    }
+
+    _table.store(t, memory_order_seq_cst);
+    unique_lock<SpinMutex> rlock(_retireMutex);
+    _vctRetiredTable.push_back(old);
+  }
+
+  void Synchronize() {
+    unique_lock<SpinMutex> lock(_syncMutex);
+    // Two flips, so the readers that loaded the epoch before the first flip
+    // but counted after it are also waited.
+    for (int n = 0; n < 2; n++) {
+      uint64_t epoch = _epoch.fetch_add(1, memory_order_seq_cst);
+      atomic_thread_fence(memory_order_seq_cst);
+      for (uint32_t i = 0; i < READER_STRIPES; i++) {
+        while (_readers[epoch & 1][i]._count.load(memory_order_acquire) > 0) {
+          this_thread::yield();
+        }
+      }
+    }
+  }
+
+protected:
+  atomic<Table *> _table;
+  atomic<uint64_t> _count{0};
+  // Shared by Insert and EraseIf, exclusive by Grow
+  SharedSpinMutex _writeMutex;
+  atomic<uint64_t> _epoch{0};
+  ReaderCount _readers[2][READER_STRIPES];
+  SpinMutex _syncMutex;
+  SpinMutex _retireMutex;
+  MVector<T *> _vctRetired;
+  MVector<Table *> _vctRetiredTable;
+};
+} // namespace storage
@@ -6,8 +6,11 @@ namespace storage {
 const uint32_t StoragePool::WRITE_DELAY_MS = 1 * 1000;
 const uint64_t StoragePool::MAX_QUEUE_SIZE =
     Configure::GetTotalCacheSize() / Configure::GetCachePageSize();
+const uint32_t StoragePool::MAX_WRITE_BATCH_PAGES = 64;
 StoragePool *StoragePool::_storagePool = nullptr;
 SpinMutex StoragePool::_spinMutex;
+atomic<uint64_t> StoragePool::_writtenPages{0};
+atomic<uint64_t> StoragePool::_writeCalls{0};
 
 void StoragePool::AddTimerTask() {
   TimerThread::AddCircleTask("StoragePool", 1000000, []() {
@@ -58,8 +61,10 @@ void StoragePool::PoolManage() {
   }
 
   bool bmax = (_storagePool->_mapWrite.size() > MAX_QUEUE_SIZE / 2);
-  IndexTree *tree = nullptr;
-  PageFile *pf = nullptr;
+  // _mapWrite is sorted by file id and page id, so the adjacent dirty pages
+  // are collected here and written together.
+  MVector<CachePage *> vctBatch;
+  vctBatch.reserve(MAX_WRITE_BATCH_PAGES);
 
   for (auto iter = _storagePool->_mapWrite.begin();
        iter != _storagePool->_mapWrite.end();) {
@@ -71,27 +76,67 @@ void StoragePool::PoolManage() {
     }
 
     page->SetInStorage(false);
-    if (page->IsDirty()) {
-      if (tree == nullptr || tree != page->GetIndexTree()) {
-        if (pf != nullptr) {
-          tree->ReleasePageFile(pf);
+    iter = _storagePool->_mapWrite.erase(iter);
+    if (page->IsDirty() && page->IsBatchWritable()) {
+      assert(page->GetRefCount() > 0);
+      if (vctBatch.size() > 0) {
+        CachePage *last = vctBatch.back();
+        if (last->GetFileId() != page->GetFileId() ||
+            last->GetPageId() + 1 != page->GetPageId() ||
+            vctBatch.size() >= MAX_WRITE_BATCH_PAGES) {
+          WriteBatch(vctBatch);
         }
-
-        assert(page->GetRefCount() > 0);
-        tree = page->GetIndexTree();
-        pf = tree->ApplyPageFile();
       }
-      page->WritePage(pf);
+
+      // The page will be released after written
+      vctBatch.push_back(page);
+      continue;
+    }
+
+    if (page->IsDirty()) {
+      assert(page->GetRefCount() > 0);
+      page->WritePage();
+      _writtenPages.fetch_add(1, memory_order_relaxed);
+      _writeCalls.fetch_add(1, memory_order_relaxed);
     }
 
     page->DecRef();
-    iter = _storagePool->_mapWrite.erase(iter);
   }
 
-  if (tree != nullptr) {
-    tree->ReleasePageFile(pf);
-  }
+  WriteBatch(vctBatch);
 
   _storagePool->_bInThreadPool.store(false, memory_order_relaxed);
 }
+
+void StoragePool::WriteBatch(MVector<CachePage *> &vctPage) {
+  if (vctPage.size() == 0)
+    return;
+
+  if (vctPage.size() == 1) {
+    vctPage[0]->WritePage();
+  } else {
+    // Fill crc32 for all pages before the write is issued.
+    MVector<iovec> vctIov(vctPage.size());
+    for (size_t i = 0; i < vctPage.size(); i++) {
+      vctPage[i]->LockForWrite();
+      vctIov[i].iov_base = vctPage[i]->GetBysPage();
+      vctIov[i].iov_len = vctPage[i]->GetPageLength();
+    }
+
+    CachePage *first = vctPage[0];
+    first->GetIndexTree()->GetPageFile()->WritePages(
+        first->GetFileOffset(), vctIov.data(), (int)vctIov.size());
+
+    for (CachePage *page : vctPage) {
+      page->UnlockForWrite();
+    }
+  }
+
+  _writtenPages.fetch_add(vctPage.size(), memory_order_relaxed);
+  _writeCalls.fetch_add(1, memory_order_relaxed);
+  for (CachePage *page : vctPage) {
+    page->DecRef();
+  }
+  vctPage.clear();
+}
 } // namespace storage
@@ -13,6 +13,8 @@ class StoragePool {
 public:
   static const uint32_t WRITE_DELAY_MS;
   static const uint64_t MAX_QUEUE_SIZE;
+  // The max continuous pages to be merged into one write call
+  static const uint32_t MAX_WRITE_BATCH_PAGES;
 
 public:
   static void AddTimerTask();
@@ -42,13 +44,25 @@ public:
   static void StopPool();
   static void PushTask();
   static void PoolManage();
+  // How many pages have been written and how many write calls were used.
+  static uint64_t GetWrittenPageCount() {
+    return _writtenPages.load(memory_order_relaxed);
+  }
+  static uint64_t GetWriteCallCount() {
+    return _writeCalls.load(memory_order_relaxed);
+  }
 
 protected:
   static StoragePool *_storagePool;
   static SpinMutex _spinMutex;
+  static atomic<uint64_t> _writtenPages;
+  static atomic<uint64_t> _writeCalls;
 
 protected:
   StoragePool(ThreadPool *tp) : _fastQueue(tp), _threadPool(tp){};
+  // Write a series of continuous pages in the same file with one call, then
+  // release them.
+  static void WriteBatch(MVector<CachePage *> &vctPage);
   MTreeMap<uint64_t, CachePage *> _mapWrite;
   FastQueue<CachePage> _fastQueue;
   ThreadPool *_threadPool;
@@ -256,7 +256,7 @@ uint32_t PhysTable::LoadData(Byte *bys) {
   buf += UI32_LEN;
 
   FileVersion fv(*(int16_t *)buf, *(uint8_t *)(buf + 2), *(uint8_t *)(buf + 3));
-  if (!(fv == CURRENT_FILE_VERSION)) {
+  if (!IsSupportedFileVersion(fv)) {
     _threadErrorMsg.reset(new ErrorMsg(TB_ERROR_INDEX_VERSION));
     return UINT32_MAX;
   }
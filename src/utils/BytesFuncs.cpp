@@ -0,0 +1,172 @@
+﻿#include "BytesFuncs.h"
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BYTES_COMPARE_X86
+#include <immintrin.h>
+#ifdef _MSVC_LANG
+#include <intrin.h>
+#endif
+#endif
+
+namespace storage {
+using namespace std;
+
+int BytesCompareSoftware(const Byte *bys1, const Byte *bys2, size_t len) {
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t v1, v2;
+    memcpy(&v1, bys1 + i, sizeof(v1));
+    memcpy(&v2, bys2 + i, sizeof(v2));
+    if (v1 != v2) {
+      v1 = BytesSwap64(v1);
+      v2 = BytesSwap64(v2);
+      return v1 > v2 ? 1 : -1;
+    }
+  }
+
+  for (; i < len; i++) {
+    int hr = bys1[i] - bys2[i];
+    if (hr != 0)
+      return hr;
+  }
+
+  return 0;
+}
+
+#ifdef BYTES_COMPARE_X86
+// The index of the lowest set bit, mask can not be 0.
+static inline int LowestBitIndex(uint32_t mask) {
+#ifdef _MSVC_LANG
+  unsigned long idx;
+  _BitScanForward(&idx, mask);
+  return (int)idx;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+// Compare 16 bytes, return the index of the first different byte or -1.
+static inline int DiffIndex16(const Byte *bys1, const Byte *bys2) {
+  __m128i a = _mm_loadu_si128((const __m128i *)bys1);
+  __m128i b = _mm_loadu_si128((const __m128i *)bys2);
+  uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+  return mask == 0xFFFF ? -1 : LowestBitIndex(~mask);
+}
+
+int BytesCompareSse2(const Byte *bys1, const Byte *bys2, size_t len) {
+  if (len < 16)
+    return BytesCompareSoftware(bys1, bys2, len);
+
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    int idx = DiffIndex16(bys1 + i, bys2 + i);
+    if (idx >= 0)
+      return bys1[i + idx] - bys2[i + idx];
+  }
+
+  if (i < len) {
+    // The bytes before i are equal, so compare the last 16 bytes again with
+    // overlap instead of a byte loop.
+    i = len - 16;
+    int idx = DiffIndex16(bys1 + i, bys2 + i);
+    if (idx >= 0)
+      return bys1[i + idx] - bys2[i + idx];
+  }
+
+  return 0;
+}
+
+#ifndef _MSVC_LANG
+__attribute__((target("avx2")))
+#endif
+int BytesCompareAvx2(const Byte *bys1, const Byte *bys2, size_t len) {
+  if (len < 32)
+    return BytesCompareSse2(bys1, bys2, len);
+
+  size_t i = 0;
+  // Two vectors per loop, the movemask is only calculated when a difference
+  // was found.
+  for (; i + 64 <= len; i += 64) {
+    __m256i eq1 =
+        _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(bys1 + i)),
+                          _mm256_loadu_si256((const __m256i *)(bys2 + i)));
+    __m256i eq2 = _mm256_cmpeq_epi8(
+        _mm256_loadu_si256((const __m256i *)(bys1 + i + 32)),
+        _mm256_loadu_si256((const __m256i *)(bys2 + i + 32)));
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(eq1, eq2));
+    if (mask == 0xFFFFFFFF)
+      continue;
+
+    mask = (uint32_t)_mm256_movemask_epi8(eq1);
+    if (mask == 0xFFFFFFFF) {
+      i += 32;
+      mask = (uint32_t)_mm256_movemask_epi8(eq2);
+    }
+    int idx = LowestBitIndex(~mask);
+    return bys1[i + idx] - bys2[i + idx];
+  }
+
+  while (i < len) {
+    // The bytes before i are equal, the last step overlaps them instead of
+    // a byte loop.
+    if (i + 32 > len)
+      i = len - 32;
+    __m256i a = _mm256_loadu_si256((const __m256i *)(bys1 + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(bys2 + i));
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+    if (mask != 0xFFFFFFFF) {
+      int idx = LowestBitIndex(~mask);
+      return bys1[i + idx] - bys2[i + idx];
+    }
+    i += 32;
+  }
+
+  return 0;
+}
+
+bool IsBytesCompareAvx2() {
+#ifdef _MSVC_LANG
+  int info[4];
+  __cpuid(info, 1);
+  // OSXSAVE and AVX, then the os must save the YMM registers.
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+    return false;
+  if ((_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#else
+int BytesCompareSse2(const Byte *bys1, const Byte *bys2, size_t len) {
+  return BytesCompareSoftware(bys1, bys2, len);
+}
+
+int BytesCompareAvx2(const Byte *bys1, const Byte *bys2, size_t len) {
+  return BytesCompareSoftware(bys1, bys2, len);
+}
+
+bool IsBytesCompareAvx2() { return false; }
+#endif // BYTES_COMPARE_X86
+
+typedef int (*BytesCompareFunc)(const Byte *, const Byte *, size_t);
+static int BytesCompareSelect(const Byte *bys1, const Byte *bys2, size_t len);
+// It is constant initialized, so BytesCompareLong can be called by the
+// static initializers, and it has not the guard of a function static.
+static atomic<BytesCompareFunc> _funcCompare{BytesCompareSelect};
+
+// Select the function by cpu at the first call.
+static int BytesCompareSelect(const Byte *bys1, const Byte *bys2, size_t len) {
+  BytesCompareFunc func =
+      IsBytesCompareAvx2() ? BytesCompareAvx2 : BytesCompareSse2;
+  _funcCompare.store(func, memory_order_relaxed);
+  return func(bys1, bys2, len);
+}
+
+int BytesCompareLong(const Byte *bys1, const Byte *bys2, size_t len) {
+  return _funcCompare.load(memory_order_relaxed)(bys1, bys2, len);
+}
+} // namespace storage
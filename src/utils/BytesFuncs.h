@@ -321,6 +321,26 @@ inline void FloatToBytes(float dval, Byte *pArr, bool bkey = false) {
 #endif
 }
 
+// The keys shorter than this length are compared inline by 8 bytes words,
+// the longer keys call BytesCompareLong to compare by SIMD instructions.
+static const size_t BYTES_COMPARE_SIMD_LEN = 32;
+
+/**Compare two buffers with the same length as memcmp. It compares 32 bytes
+ * per step with AVX2 if the cpu supports it, or 16 bytes per step with SSE2,
+ * and finds the first different byte by movemask. The function is selected
+ * at the first call.*/
+int BytesCompareLong(const Byte *bys1, const Byte *bys2, size_t len);
+// Compare by 8 bytes words, it can run on any cpu.
+int BytesCompareSoftware(const Byte *bys1, const Byte *bys2, size_t len);
+// Compare by 16 bytes with SSE2, it is the base of x86-64. On other cpus it
+// is the same as BytesCompareSoftware.
+int BytesCompareSse2(const Byte *bys1, const Byte *bys2, size_t len);
+// Compare by 32 bytes with AVX2, only call it after IsBytesCompareAvx2()
+// returns true.
+int BytesCompareAvx2(const Byte *bys1, const Byte *bys2, size_t len);
+// If the cpu and os support AVX2 instructions.
+bool IsBytesCompareAvx2();
+
 inline int BytesCompare(const Byte *bys1, size_t len1, const Byte *bys2,
                         size_t len2) {
 #ifdef STD_MEM
@@ -330,13 +350,21 @@ inline int BytesCompare(const Byte *bys1, size_t len1, const Byte *bys2,
   return len1 - len2;
 #else
   size_t minLen = std::min(len1, len2);
+  if (minLen >= BYTES_COMPARE_SIMD_LEN) {
+    int hr = BytesCompareLong(bys1, bys2, minLen);
+    if (hr != 0)
+      return hr;
+    return (int)(len1 - len2);
+  }
+
   size_t min8 = minLen & 0xFFFFFFFFFFFFFFF8;
   size_t i = 0;
   for (; i < min8; i += 8) {
-    int64_t hr =
-        BytesSwap64(*(uint64_t *)bys1) - BytesSwap64(*(uint64_t *)bys2);
-    if (hr != 0)
-      return hr > 0 ? 1 : -1;
+    uint64_t v1 = BytesSwap64(*(uint64_t *)bys1);
+    uint64_t v2 = BytesSwap64(*(uint64_t *)bys2);
+    // Do not subtract the words, the difference can overflow int64_t.
+    if (v1 != v2)
+      return v1 > v2 ? 1 : -1;
     bys1 += 8;
     bys2 += 8;
   }
@@ -0,0 +1,125 @@
+﻿#include "Crc32c.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_X86
+#include <nmmintrin.h>
+#ifdef _MSVC_LANG
+#include <intrin.h>
+#endif
+#endif
+
+namespace storage {
+// Reversed Castagnoli polynomial
+static const uint32_t CRC32C_POLY = 0x82F63B78;
+
+struct Crc32cTable {
+  Crc32cTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; j++) {
+        crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+      }
+      _table[0][i] = crc;
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+      for (int k = 1; k < 8; k++) {
+        uint32_t prev = _table[k - 1][i];
+        _table[k][i] = (prev >> 8) ^ _table[0][prev & 0xff];
+      }
+    }
+  }
+
+  uint32_t _table[8][256];
+};
+
+static const Crc32cTable &GetCrc32cTable() {
+  static const Crc32cTable table;
+  return table;
+}
+
+uint32_t Crc32cSoftware(const Byte *bys, size_t len, uint32_t crc) {
+  const uint32_t(*tb)[256] = GetCrc32cTable()._table;
+  crc = ~crc;
+
+  while (len > 0 && ((uintptr_t)bys & 7) != 0) {
+    crc = tb[0][(crc ^ *bys++) & 0xff] ^ (crc >> 8);
+    len--;
+  }
+
+  while (len >= 8) {
+    uint64_t val;
+    memcpy(&val, bys, sizeof(val));
+#ifdef BIGENDIAN
+    val = __builtin_bswap64(val);
+#endif
+    val ^= crc;
+    crc = tb[7][val & 0xff] ^ tb[6][(val >> 8) & 0xff] ^
+          tb[5][(val >> 16) & 0xff] ^ tb[4][(val >> 24) & 0xff] ^
+          tb[3][(val >> 32) & 0xff] ^ tb[2][(val >> 40) & 0xff] ^
+          tb[1][(val >> 48) & 0xff] ^ tb[0][val >> 56];
+    bys += 8;
+    len -= 8;
+  }
+
+  while (len > 0) {
+    crc = tb[0][(crc ^ *bys++) & 0xff] ^ (crc >> 8);
+    len--;
+  }
+
+  return ~crc;
+}
+
+#ifdef CRC32C_X86
+#ifndef _MSVC_LANG
+__attribute__((target("sse4.2")))
+#endif
+uint32_t Crc32cHardware(const Byte *bys, size_t len, uint32_t crc) {
+  crc = ~crc;
+  while (len > 0 && ((uintptr_t)bys & 7) != 0) {
+    crc = _mm_crc32_u8(crc, *bys++);
+    len--;
+  }
+
+  uint64_t crc64 = crc;
+  while (len >= 8) {
+    uint64_t val;
+    memcpy(&val, bys, sizeof(val));
+    crc64 = _mm_crc32_u64(crc64, val);
+    bys += 8;
+    len -= 8;
+  }
+
+  crc = (uint32_t)crc64;
+  while (len > 0) {
+    crc = _mm_crc32_u8(crc, *bys++);
+    len--;
+  }
+
+  return ~crc;
+}
+
+bool IsCrc32cHardware() {
+#ifdef _MSVC_LANG
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 20)) != 0;
+#else
+  return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#else
+uint32_t Crc32cHardware(const Byte *bys, size_t len, uint32_t crc) {
+  return Crc32cSoftware(bys, len, crc);
+}
+
+bool IsCrc32cHardware() { return false; }
+#endif // CRC32C_X86
+
+uint32_t Crc32c(const Byte *bys, size_t len, uint32_t crc) {
+  static const bool bHardware = IsCrc32cHardware();
+  return bHardware ? Crc32cHardware(bys, len, crc)
+                   : Crc32cSoftware(bys, len, crc);
+}
+} // namespace storage
@@ -0,0 +1,19 @@
+﻿#pragma once
+#include "../header.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace storage {
+/**CRC32C (Castagnoli polynomial) used to checksum the pages. It uses the
+ * SSE4.2 crc32 instruction if the cpu supports it, or the slicing-by-8 table
+ * algorithm. The crc parameter is the result of the previous blocks, so a
+ * buffer can be calculated piece by piece.*/
+uint32_t Crc32c(const Byte *bys, size_t len, uint32_t crc = 0);
+// Calculate CRC32C by slicing-by-8 tables, it can run on any cpu.
+uint32_t Crc32cSoftware(const Byte *bys, size_t len, uint32_t crc = 0);
+// Calculate CRC32C by SSE4.2 instruction, only call it after
+// IsCrc32cHardware() returns true.
+uint32_t Crc32cHardware(const Byte *bys, size_t len, uint32_t crc = 0);
+// If the cpu supports to calculate CRC32C by instruction.
+bool IsCrc32cHardware();
+} // namespace storage
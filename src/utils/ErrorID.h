@@ -29,6 +29,8 @@ enum ErrorID {
 
   CORE_EXCEED_KEY_LENGTH = 5001,
   CORE_REPEATED_RECORD = 5002,
+  CORE_UNORDERED_RECORD = 5003,
+  CORE_INDEX_NOT_EMPTY = 5004,
 
   EXPR_INDEX_OUT_RANGE = 6001,
   EXPR_ERROR_DATATYPE = 6002,
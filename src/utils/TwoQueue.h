@@ -0,0 +1,172 @@
+﻿#pragma once
+#include "../cache/Mallocator.h"
+#include <cstdint>
+#include <utility>
+
+namespace storage {
+using namespace std;
+/**Scan resistant replacement policy based on 2Q. A new item is added into the
+ * probation FIFO queue, and the key of an item evicted from it is remembered
+ * in the ghost queue. Only when an item is added again while its key is still
+ * in ghost queue, it goes into the protected queue, which is managed by CLOCK:
+ * the referenced items get a second chance. So the items visited only once by
+ * a large scan are evicted from the probation queue and can not flush the hot
+ * items in the protected queue. All operations are O(1) except RemoveIf.
+ * It is not thread safe, the caller need to lock it.
+ * T need to provide the method: bool TestAndClearReferenced().*/
+template <class T> class TwoQueue {
+public:
+  // The default percentage of capacity for probation queue
+  static const uint32_t DEFAULT_PROBATION_PERCENT = 25;
+  // The percentage of capacity for ghost queue
+  static const uint32_t GHOST_PERCENT = 50;
+
+public:
+  TwoQueue(uint64_t capacity) { SetCapacity(capacity); }
+
+  void SetCapacity(uint64_t capacity) {
+    _capacity = capacity;
+    _maxProbation = capacity * DEFAULT_PROBATION_PERCENT / 100;
+    _maxGhost = capacity * GHOST_PERCENT / 100;
+  }
+
+  // Add a new item, its key is used to find it in ghost queue.
+  void Push(T item, uint64_t key) {
+    if (_setGhost.erase(key) > 0) {
+      _queueProtected.push_back({item, key});
+    } else {
+      _queueProbation.push_back({item, key});
+    }
+  }
+
+  /** @brief Select and evict items until count items have been evicted or all
+   * items have been visited.
+   * @param count How many items to evict
+   * @param funcEvict bool(T), try to evict the item, return false if it can
+   * not be evicted now and it will be kept in queue.
+   * @param maxVisit The max items to visit in this call.
+   * @return How many items have been evicted.
+   */
+  template <class Func>
+  uint64_t Evict(uint64_t count, Func funcEvict,
+                 uint64_t maxVisit = UINT64_MAX) {
+    uint64_t evicted = 0;
+    // The protected items may be visited twice due to second chance
+    uint64_t limit = _queueProbation.size() + _queueProtected.size() * 2;
+    if (limit > maxVisit)
+      limit = maxVisit;
+
+    for (uint64_t i = 0; i < limit && evicted < count; i++) {
+      bool bProbation =
+          _queueProbation.size() > 0 &&
+          (_queueProbation.size() > _maxProbation || _queueProtected.empty());
+
+      if (bProbation) {
+        pair<T, uint64_t> pr = _queueProbation.front();
+        _queueProbation.pop_front();
+        if (funcEvict(pr.first)) {
+          AddGhost(pr.second);
+          evicted++;
+        } else {
+          _queueProbation.push_back(pr);
+        }
+      } else if (_queueProtected.size() > 0) {
+        pair<T, uint64_t> pr = _queueProtected.front();
+        _queueProtected.pop_front();
+        if (pr.first->TestAndClearReferenced() || !funcEvict(pr.first)) {
+          _queueProtected.push_back(pr);
+        } else {
+          evicted++;
+        }
+      } else {
+        break;
+      }
+    }
+
+    return evicted;
+  }
+
+  /** @brief Visit all items and remove the items that funcRemove returns
+   * true, they will not be remembered in ghost queue. It is O(size).
+   * @return How many items have been removed.
+   */
+  template <class Func> uint64_t RemoveIf(Func funcRemove) {
+    return RemoveIf(_queueProbation, funcRemove) +
+           RemoveIf(_queueProtected, funcRemove);
+  }
+
+  /** @brief Visit all items from the hottest to the coldest: the protected
+   * queue first, then the probation queue, both from the latest added or
+   * given second chance to the earliest.
+   * @param func void(T, uint64_t key)
+   */
+  template <class Func> void ForEach(Func func) const {
+    for (auto iter = _queueProtected.rbegin(); iter != _queueProtected.rend();
+         iter++) {
+      func(iter->first, iter->second);
+    }
+    for (auto iter = _queueProbation.rbegin(); iter != _queueProbation.rend();
+         iter++) {
+      func(iter->first, iter->second);
+    }
+  }
+
+  // Remove all items and release the memory
+  void Clear() {
+    _queueProbation.clear();
+    _queueProbation.shrink_to_fit();
+    _queueProtected.clear();
+    _queueProtected.shrink_to_fit();
+    _queueGhost.clear();
+    _queueGhost.shrink_to_fit();
+    MHashSet<uint64_t>().swap(_setGhost);
+  }
+
+  uint64_t Size() const {
+    return _queueProbation.size() + _queueProtected.size();
+  }
+  uint64_t GetProbationSize() const { return _queueProbation.size(); }
+  uint64_t GetProtectedSize() const { return _queueProtected.size(); }
+  uint64_t GetGhostSize() const { return _setGhost.size(); }
+
+protected:
+  void AddGhost(uint64_t key) {
+    if (_maxGhost == 0)
+      return;
+
+    _setGhost.insert(key);
+    _queueGhost.push_back(key);
+    while (_queueGhost.size() > _maxGhost) {
+      _setGhost.erase(_queueGhost.front());
+      _queueGhost.pop_front();
+    }
+  }
+
+  template <class Func>
+  static uint64_t RemoveIf(MDeque<pair<T, uint64_t>> &queue, Func funcRemove) {
+    // Move the kept items forward in place and cut the tail
+    size_t pos = 0;
+    for (size_t i = 0; i < queue.size(); i++) {
+      if (!funcRemove(queue[i].first)) {
+        queue[pos++] = queue[i];
+      }
+    }
+
+    uint64_t count = queue.size() - pos;
+    queue.resize(pos);
+    return count;
+  }
+
+protected:
+  uint64_t _capacity;
+  uint64_t _maxProbation;
+  uint64_t _maxGhost;
+  // The items that have been added only once recently, FIFO
+  MDeque<pair<T, uint64_t>> _queueProbation;
+  // The items that have been added again after evicted, CLOCK
+  MDeque<pair<T, uint64_t>> _queueProtected;
+  // The keys evicted from probation queue, FIFO
+  MDeque<uint64_t> _queueGhost;
+  MHashSet<uint64_t> _setGhost;
+};
+} // namespace storage
@@ -259,5 +259,130 @@ BOOST_AUTO_TEST_CASE(BranchPageSearchKey_test) {
   PageDividePool::AddTimerTask();
   PageBufferPool::AddTimerTask();
 }
+BOOST_AUTO_TEST_CASE(BranchPageKeyPrefix_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testBranchPageKeyPrefix" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 20;
+
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+
+  DataValueVarChar *dvKey = new DataValueVarChar(1000);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         2004, IndexType::PRIMARY);
+  indexTree->GetHeadPage()->WriteKeyVariableFieldCount((short)1);
+  BOOST_TEST(indexTree->GetHeadPage()->IsKeyPrefixFile());
+  BranchPage *bp =
+      (BranchPage *)indexTree->AllocateNewPage(UINT32_MAX, (Byte)1);
+
+  vctKey.push_back(dvKey->Clone(true));
+  vctVal.push_back(dvVal->Clone(true));
+  auto funcKey = [](int i) {
+    return "tenant/00042/account/" + ToMString(i + 100) + "/record";
+  };
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueVarChar *)vctKey[0]) = funcKey(i * 2).c_str();
+    *((DataValueLong *)vctVal[0]) = i;
+    LeafRecord *lr = new LeafRecord(indexTree, vctKey, vctVal, 1, nullptr);
+    BranchRecord *rr = new BranchRecord(indexTree, lr, i + 100);
+    bp->InsertRecord(rr, i);
+    lr->DecRef();
+  }
+  BOOST_TEST(bp->SaveRecords());
+
+  // Search on the page bytes, the keys share the prefix with records.
+  for (int i = 0; i < ROW_COUNT * 2; i++) {
+    *((DataValueVarChar *)vctKey[0]) = funcKey(i).c_str();
+    RawKey key(vctKey);
+    bool bFind;
+    BOOST_TEST(bp->SearchKey(key, bFind) == (i + 1) / 2);
+    BOOST_TEST(bFind == (i % 2 == 0));
+    PageID childId;
+    BOOST_TEST(bp->SearchKeyOptimistic(key, childId));
+    BOOST_TEST(childId == bp->GetChildPageId((i + 1) / 2, true));
+  }
+
+  // The keys out of the prefix
+  const char *arStr[] = {"tenant", "tenant/00041/z", "a", "tenant/00043", "z"};
+  int arPos[] = {0, 0, 0, ROW_COUNT, ROW_COUNT};
+  for (int i = 0; i < 5; i++) {
+    *((DataValueVarChar *)vctKey[0]) = arStr[i];
+    RawKey key(vctKey);
+    bool bFind;
+    BOOST_TEST(bp->SearchKey(key, bFind) == arPos[i]);
+    BOOST_TEST(!bFind);
+  }
+
+  // The loaded records get their prefix back.
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueVarChar *)vctKey[0]) = funcKey(i * 2).c_str();
+    RawKey key(vctKey);
+    BranchRecord *br = bp->GetRecordByPos(i, false);
+    BOOST_TEST(br->CompareKey(key) == 0);
+    BOOST_TEST(br->GetChildPageId() == (PageID)(i + 100));
+  }
+
+  bp->DecRef();
+  indexTree->Close();
+  dvKey->DecRef();
+  dvVal->DecRef();
+
+  StoragePool::AddTimerTask();
+  PageDividePool::AddTimerTask();
+  PageBufferPool::AddTimerTask();
+}
+BOOST_AUTO_TEST_CASE(BranchPageSwizzle_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testBranchPageSwizzle" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         2003, IndexType::PRIMARY);
+  BranchPage *bp =
+      (BranchPage *)indexTree->AllocateNewPage(UINT32_MAX, (Byte)1);
+  IndexPage *lp = indexTree->AllocateNewPage(bp->GetPageId(), (Byte)0);
+  BOOST_TEST(bp->GetSwizzledChild(lp->GetPageId()) == nullptr);
+
+  // The swizzled pointer holds a reference, but does not block eviction.
+  bp->SwizzleChild(lp);
+  BOOST_TEST(lp->GetRefCount() == 3);
+  IndexPage *child = bp->GetSwizzledChild(lp->GetPageId());
+  BOOST_TEST(child == lp);
+  child->DecRef();
+  BOOST_TEST(bp->GetSwizzledChild(lp->GetPageId() + BranchPage::SWIZZLE_SLOTS) ==
+             nullptr);
+  BOOST_TEST(!lp->TryEvict());
+  BOOST_TEST(!lp->IsEvicted());
+
+  // After the child was evicted, the next lookup unswizzles it.
+  lp->DecRef();
+  BOOST_TEST(lp->Releaseable());
+  BOOST_TEST(lp->TryEvict());
+  BOOST_TEST(bp->GetSwizzledChild(lp->GetPageId()) == nullptr);
+
+  bp->DecRef();
+  indexTree->Close();
+  dvKey->DecRef();
+  dvVal->DecRef();
+
+  StoragePool::AddTimerTask();
+  PageDividePool::AddTimerTask();
+  PageBufferPool::AddTimerTask();
+}
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace storage
@@ -0,0 +1,126 @@
+﻿#include "../../src/core/BulkLoader.h"
+#include "../../src/core/IndexTree.h"
+#include "../../src/core/LeafPage.h"
+#include "../../src/dataType/DataValueDigit.h"
+#include "../../src/utils/ErrorID.h"
+#include "../../src/utils/Utilitys.h"
+#include "../TestHeader.h"
+#include "CoreSuit.h"
+#include <boost/test/unit_test.hpp>
+
+namespace storage {
+BOOST_FIXTURE_TEST_SUITE(CoreTest, SuiteFixture)
+
+BOOST_AUTO_TEST_CASE(BulkLoader_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testBulkLoader" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 30000;
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  bool rt = indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(),
+                                   vctKey, vctVal, 3400, IndexType::PRIMARY);
+  BOOST_TEST(rt);
+
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  BulkLoader *loader = new BulkLoader(indexTree, 90);
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueLong *)vctKey[0]) = i * 2;
+    *((DataValueLong *)vctVal[0]) = i + 100LL;
+    BOOST_TEST(loader->AddRecord(new LeafRecord(indexTree, vctKey, vctVal, 0,
+                                                nullptr)));
+  }
+
+  // A key not greater than the last one is refused.
+  *((DataValueLong *)vctKey[0]) = ROW_COUNT;
+  BOOST_TEST(!loader->AddRecord(
+      new LeafRecord(indexTree, vctKey, vctVal, 0, nullptr)));
+  BOOST_TEST(_threadErrorMsg->getErrId() == CORE_UNORDERED_RECORD);
+
+  BOOST_TEST(loader->Finish());
+  BOOST_TEST(loader->GetRecordCount() == ROW_COUNT);
+  BOOST_TEST(loader->GetLevelCount() > 1);
+  uint32_t totalPages = indexTree->GetHeadPage()->ReadTotalPageCount();
+  BOOST_TEST(loader->GetWriteCallCount() < totalPages);
+  delete loader;
+  BOOST_TEST(indexTree->GetRecordsCount() == ROW_COUNT);
+
+  // Only an empty tree can be bulk loaded.
+  loader = new BulkLoader(indexTree, 90);
+  BOOST_TEST(!loader->AddRecord(
+      new LeafRecord(indexTree, vctKey, vctVal, 0, nullptr)));
+  BOOST_TEST(_threadErrorMsg->getErrId() == CORE_INDEX_NOT_EMPTY);
+  delete loader;
+  _threadErrorMsg.reset();
+
+  auto funcCheck = [&]() {
+    int count = 0;
+    for (int i = 0; i < ROW_COUNT * 2; i++) {
+      *((DataValueLong *)vctKey[0]) = i;
+      RawKey key(vctKey);
+      IndexPage *idp = nullptr;
+      indexTree->SearchRecursively(key, false, idp, true);
+      BOOST_TEST(idp->GetPageType() == PageType::LEAF_PAGE);
+      bool bFind;
+      ((LeafPage *)idp)->SearchKey(key, bFind);
+      BOOST_TEST(bFind == (i % 2 == 0));
+      if (bFind)
+        count++;
+      idp->ReadUnlock();
+      idp->DecRef();
+    }
+    BOOST_TEST(count == ROW_COUNT);
+
+    LeafPage *lp = indexTree->GetBeginPage();
+    BOOST_TEST(lp->GetPrevPageId() == PAGE_NULL_POINTER);
+    int64_t idx = 0;
+    while (true) {
+      for (uint32_t i = 0; i < lp->GetRecordNumber(); i++) {
+        LeafRecord *lr = lp->GetRecord(i);
+        VectorDataValue vdv;
+        lr->GetListValue(vdv);
+        BOOST_TEST(vdv[0]->GetLong() == idx + 100);
+        lr->DecRef();
+        idx++;
+      }
+
+      PageID nid = lp->GetNextPageId();
+      if (nid == PAGE_NULL_POINTER)
+        break;
+
+      LeafPage *lp2 =
+          (LeafPage *)indexTree->GetPage(nid, PageType::LEAF_PAGE, true);
+      BOOST_TEST(lp2->GetPrevPageId() == lp->GetPageId());
+      lp->DecRef();
+      lp = lp2;
+    }
+    BOOST_TEST(lp->GetPageId() ==
+               indexTree->GetHeadPage()->ReadEndLeafPagePointer());
+    lp->DecRef();
+    BOOST_TEST(idx == ROW_COUNT);
+  };
+
+  funcCheck();
+  IndexTree::TestCloseWait(indexTree);
+
+  indexTree = new IndexTree();
+  rt = indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey,
+                            vctVal, 3400);
+  BOOST_TEST(rt);
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  BOOST_TEST(indexTree->GetRecordsCount() == ROW_COUNT);
+  funcCheck();
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
@@ -1,4 +1,5 @@
 
+#include "../../src/file/AsyncIo.h"
 #include "../../src/pool/PageBufferPool.h"
 #include "../../src/pool/PageDividePool.h"
 #include "../../src/pool/StoragePool.h"
@@ -14,6 +15,7 @@ struct SuiteFixture {
              << boost::unit_test::framework::current_test_case().p_name;
     _threadPool = ThreadPool::InitMain(100000, 1, 1);
     TimerThread::Start();
+    AsyncIo::InitAsyncIo(_threadPool);
     StoragePool::InitPool(_threadPool);
     StoragePool::AddTimerTask();
     PageDividePool::InitPool(_threadPool);
@@ -26,6 +28,7 @@ struct SuiteFixture {
     PageDividePool::RemoveTimerTask();
     StoragePool::RemoveTimerTask();
     TimerThread::Stop();
+    AsyncIo::StopAsyncIo();
 
     ThreadPool::StopMain();
     _threadPool = nullptr;
@@ -80,5 +80,46 @@ BOOST_AUTO_TEST_CASE(HeadPage_test) {
   // PageBufferPool::ClearPool();
   // fs::remove(fs::path(FILE_NAME));
 }
+BOOST_AUTO_TEST_CASE(HeadPageFileExtent_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testHeadPageExtent" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  VectorDataValue vctKey;
+  VectorDataValue vctVal;
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         1, IndexType::PRIMARY);
+  HeadPage *headPage = indexTree->GetHeadPage();
+  BOOST_TEST(headPage->ReadAllocatedPageCount() == 0);
+
+  for (int i = 0; i < 1000; i++) {
+    headPage->GetAndIncTotalPageCount();
+    while (headPage->IsExtending()) {
+      this_thread::yield();
+    }
+  }
+
+  uint32_t allocated = headPage->ReadAllocatedPageCount();
+  uint32_t total = headPage->ReadTotalPageCount();
+  if (headPage->GetExtentPages() > 0) {
+    // Used up the extents quickly, so the extent grows.
+    BOOST_TEST(headPage->GetExtentPages() > Configure::GetMinExtentPages());
+    BOOST_TEST(allocated >= total);
+    BOOST_TEST(indexTree->GetPageFile()->Length() >=
+               CachePage::HEAD_PAGE_SIZE +
+                   (uint64_t)allocated * CachePage::CACHE_PAGE_SIZE);
+  }
+
+  headPage->WritePage();
+  IndexTree::TestCloseWait(indexTree);
+
+  indexTree = new IndexTree();
+  indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                       1);
+  BOOST_TEST(indexTree->GetHeadPage()->ReadAllocatedPageCount() >= allocated);
+  BOOST_TEST(indexTree->GetHeadPage()->ReadTotalPageCount() == total);
+  IndexTree::TestCloseWait(indexTree);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace storage
@@ -1,6 +1,9 @@
-﻿#include "../../src/core/IndexTree.h"
+﻿#include "../../src/core/BranchPage.h"
+#include "../../src/core/BranchRecord.h"
+#include "../../src/core/IndexTree.h"
 #include "../../src/core/LeafPage.h"
 #include "../../src/dataType/DataValueDigit.h"
+#include "../../src/dataType/DataValueVarChar.h"
 #include "../../src/pool/PageBufferPool.h"
 #include "../../src/pool/PageDividePool.h"
 #include "../../src/pool/StoragePool.h"
@@ -10,6 +13,7 @@
 #include "CoreSuit.h"
 #include <boost/test/unit_test.hpp>
 #include <filesystem>
+#include <thread>
 
 namespace storage {
 BOOST_FIXTURE_TEST_SUITE(CoreTest, SuiteFixture)
@@ -561,5 +565,218 @@ BOOST_AUTO_TEST_CASE(IndexTreeReadPrimaryKeysUnique_test) {
   delete dvVal;
 }
 
+BOOST_AUTO_TEST_CASE(IndexTreeLegacyChecksum_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testIndexTreeLegacyChecksum" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 1000;
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  bool rt = indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(),
+                                   vctKey, vctVal, 3001, IndexType::PRIMARY);
+  BOOST_TEST(rt);
+  // Simulate a file created before CRC32C, its pages are checksumed by CRC32.
+  indexTree->GetHeadPage()->SetFileVersion(MIN_FILE_VERSION);
+  BOOST_TEST(!indexTree->GetHeadPage()->IsCrc32cFile());
+
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueLong *)vctKey[0]) = i;
+    *((DataValueLong *)vctVal[0]) = i + 100LL;
+    LeafRecord *rr =
+        new LeafRecord(indexTree, vctKey, vctVal,
+                       indexTree->GetHeadPage()->ReadRecordStamp(), nullptr);
+    IndexPage *idxPage = nullptr;
+    indexTree->SearchRecursively(*rr, true, idxPage, true);
+    ((LeafPage *)idxPage)->InsertRecord(rr, false);
+    PageDividePool::AddPage(idxPage, false);
+    idxPage->WriteUnlock();
+  }
+
+  IndexTree::TestCloseWait(indexTree);
+
+  indexTree = new IndexTree();
+  rt = indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey,
+                            vctVal, 3001);
+  BOOST_TEST(rt);
+  BOOST_TEST(indexTree->GetHeadPage()->GetFileVersion() == MIN_FILE_VERSION);
+  BOOST_TEST(!indexTree->GetHeadPage()->IsCrc32cFile());
+
+  LeafPage *lp = indexTree->GetBeginPage();
+  BOOST_TEST((lp->GetPageStatus() == PageStatus::VALID));
+  uint64_t idx = 0;
+  while (true) {
+    idx += lp->GetRecordNumber();
+    PageID nid = lp->GetNextPageId();
+    if (nid == PAGE_NULL_POINTER)
+      break;
+
+    LeafPage *lp2 =
+        (LeafPage *)indexTree->GetPage(nid, PageType::LEAF_PAGE, true);
+    BOOST_TEST((lp2->GetPageStatus() == PageStatus::VALID));
+    lp->DecRef();
+    lp = lp2;
+  }
+  BOOST_TEST(idx == ROW_COUNT);
+
+  lp->DecRef();
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+}
+
+BOOST_AUTO_TEST_CASE(IndexTreeKeyPrefix_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testIndexTreeKeyPrefix" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 5000;
+  const MString KEY_HEAD = "tenant/00042/account/";
+
+  DataValueVarChar *dvKey = new DataValueVarChar(1000);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         3008, IndexType::PRIMARY);
+  indexTree->GetHeadPage()->WriteKeyVariableFieldCount((short)1);
+
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  auto funcKey = [&KEY_HEAD](int i) {
+    return KEY_HEAD + ToMString(i + 100000) + "/record/detail";
+  };
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueVarChar *)vctKey[0]) = funcKey(i).c_str();
+    *((DataValueLong *)vctVal[0]) = i;
+    LeafRecord *rr =
+        new LeafRecord(indexTree, vctKey, vctVal,
+                       indexTree->GetHeadPage()->ReadRecordStamp(), nullptr);
+    IndexPage *idxPage = nullptr;
+    indexTree->SearchRecursively(*rr, true, idxPage, true);
+    ((LeafPage *)idxPage)->InsertRecord(rr, false);
+    PageDividePool::AddPage(idxPage, false);
+    idxPage->WriteUnlock();
+  }
+
+  IndexTree::TestCloseWait(indexTree);
+
+  indexTree = new IndexTree();
+  indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                       3008);
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  // The separators of leaf pages are truncated after the different digit.
+  BranchPage *root = (BranchPage *)indexTree->GetPage(
+      indexTree->GetHeadPage()->ReadRootPagePointer(), PageType::BRANCH_PAGE,
+      true);
+  BOOST_TEST(root->GetPageLevel() == 1);
+  root->ReadLock();
+  BranchRecord *br = root->GetRecordByPos(0, false);
+  BOOST_TEST(br->GetKeyLength() < KEY_HEAD.size() + 7);
+  root->ReadUnlock();
+  root->DecRef();
+
+  int count = 0;
+  for (int i = -1; i <= ROW_COUNT; i++) {
+      *((DataValueVarChar *)vctKey[0]) = funcKey(i).c_str();
+      RawKey key(vctKey);
+    IndexPage *idp = nullptr;
+      indexTree->SearchRecursively(key, false, idp, true);
+      bool bFind;
+    ((LeafPage *)idp)->SearchKey(key, bFind);
+    if (bFind)
+      count++;
+    idp->ReadUnlock();
+    idp->DecRef();
+  }
+  BOOST_TEST(count == ROW_COUNT);
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+}
+
+BOOST_AUTO_TEST_CASE(IndexTreeOptimisticSearch_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testIndexTreeOptimisticSearch" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 20000;
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         3007, IndexType::PRIMARY);
+  BOOST_TEST(indexTree->IsOptimisticSearch());
+
+  auto funcInsert = [indexTree](int start, int step) {
+    VectorDataValue vctKey = {new DataValueLong(0LL)};
+    VectorDataValue vctVal = {new DataValueLong(0LL)};
+    for (int i = start; i < ROW_COUNT * 2; i += step) {
+      *((DataValueLong *)vctKey[0]) = i;
+      *((DataValueLong *)vctVal[0]) = i + 100LL;
+      LeafRecord *rr =
+          new LeafRecord(indexTree, vctKey, vctVal,
+                         indexTree->GetHeadPage()->ReadRecordStamp(), nullptr);
+      IndexPage *idxPage = nullptr;
+      indexTree->SearchRecursively(*rr, true, idxPage, true);
+      ((LeafPage *)idxPage)->InsertRecord(rr, false);
+      PageDividePool::AddPage(idxPage, false);
+      idxPage->WriteUnlock();
+    }
+  };
+  auto funcLookup = [indexTree](int step) {
+    VectorDataValue vctKey = {new DataValueLong(0LL)};
+    int count = 0;
+    for (int i = 0; i < ROW_COUNT * 2; i += step) {
+      *((DataValueLong *)vctKey[0]) = i;
+      RawKey key(vctKey);
+      IndexPage *idp = nullptr;
+      bool b = indexTree->SearchRecursively(key, false, idp, true);
+      if (b && idp->GetPageType() == PageType::LEAF_PAGE) {
+        bool bFind;
+        ((LeafPage *)idp)->SearchKey(key, bFind);
+        if (bFind)
+          count++;
+      }
+      idp->ReadUnlock();
+      idp->DecRef();
+    }
+    return count;
+  };
+
+  // Insert the even keys, then search them while the odd keys are inserted
+  // and the pages are divided.
+  funcInsert(0, 2);
+  atomic_bool bInserted{false};
+  thread t([funcInsert, &bInserted]() {
+    funcInsert(1, 2);
+    bInserted.store(true);
+  });
+  int round = 0;
+  while (round < 3 || !bInserted.load()) {
+    BOOST_TEST(funcLookup(2) == ROW_COUNT);
+    round++;
+  }
+  t.join();
+
+  this_thread::sleep_for(100ms);
+  BOOST_TEST(funcLookup(1) == ROW_COUNT * 2);
+  indexTree->SetOptimisticSearch(false);
+  BOOST_TEST(funcLookup(1) == ROW_COUNT * 2);
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace storage
@@ -0,0 +1,275 @@
+﻿#include "../../src/core/IndexTree.h"
+#include "../../src/core/LeafCursor.h"
+#include "../../src/core/LeafPage.h"
+#include "../../src/dataType/DataValueDigit.h"
+#include "../../src/pool/PageDividePool.h"
+#include "../../src/utils/BytesFuncs.h"
+#include "../../src/utils/Utilitys.h"
+#include "../TestHeader.h"
+#include "CoreSuit.h"
+#include <boost/test/unit_test.hpp>
+#include <thread>
+
+namespace storage {
+BOOST_FIXTURE_TEST_SUITE(CoreTest, SuiteFixture)
+
+// Read the value of a record in primary index with one long value
+static int64_t GetLongValue(LeafRecord *lr) {
+  VectorDataValue vdv;
+  lr->GetListValue(vdv);
+  return vdv[0]->GetLong();
+}
+
+BOOST_AUTO_TEST_CASE(LeafCursor_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testLeafCursor" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 10000;
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         3500, IndexType::PRIMARY);
+
+  // The keys are 0, 2, 4 ... and the value is key + 100
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  int idx = 0;
+  bool rt = indexTree->BulkLoad(
+      [&]() -> LeafRecord * {
+        if (idx >= ROW_COUNT)
+          return nullptr;
+        *((DataValueLong *)vctKey[0]) = idx * 2;
+        *((DataValueLong *)vctVal[0]) = idx * 2 + 100LL;
+        idx++;
+        return new LeafRecord(indexTree, vctKey, vctVal, 0, nullptr);
+      },
+      80);
+  BOOST_TEST(rt);
+
+  // Scan from start to end, return the values and the first value
+  auto funcScan = [&](bool bForward, int64_t start, bool bStartInc, int64_t end,
+                      bool bEndInc, int64_t &first) {
+    LeafCursor cursor(indexTree, bForward);
+    if (start >= 0) {
+      *((DataValueLong *)vctKey[0]) = start;
+      RawKey key(vctKey);
+      cursor.Seek(&key, bStartInc);
+    }
+    if (end >= 0) {
+      *((DataValueLong *)vctKey[0]) = end;
+      RawKey key(vctKey);
+      cursor.SetEndKey(&key, bEndInc);
+    }
+
+    int count = 0;
+    int64_t last = -1;
+    first = -1;
+    while (true) {
+      LeafRecord *lr = cursor.Next();
+      if (lr == nullptr)
+        break;
+      int64_t val = GetLongValue(lr);
+      lr->DecRef();
+      if (first < 0)
+        first = val;
+      if (last >= 0) {
+        BOOST_TEST((bForward ? val == last + 2 : val == last - 2));
+      }
+      last = val;
+      count++;
+    }
+    BOOST_TEST(cursor.Next() == nullptr);
+    return count;
+  };
+
+  int64_t first;
+  BOOST_TEST(funcScan(true, -1, true, -1, true, first) == ROW_COUNT);
+  BOOST_TEST(first == 100);
+  BOOST_TEST(funcScan(false, -1, true, -1, true, first) == ROW_COUNT);
+  BOOST_TEST(first == (ROW_COUNT - 1) * 2 + 100);
+
+  BOOST_TEST(funcScan(true, 1000, true, 2000, true, first) == 501);
+  BOOST_TEST(first == 1100);
+  BOOST_TEST(funcScan(true, 1000, false, 2000, false, first) == 499);
+  BOOST_TEST(first == 1102);
+  BOOST_TEST(funcScan(true, 1001, true, 2001, true, first) == 500);
+  BOOST_TEST(first == 1102);
+  BOOST_TEST(funcScan(false, 2000, true, 1000, true, first) == 501);
+  BOOST_TEST(first == 2100);
+  BOOST_TEST(funcScan(false, 2000, false, 1000, false, first) == 499);
+  BOOST_TEST(first == 2098);
+  BOOST_TEST(funcScan(false, 2001, true, -1, true, first) == 1001);
+  BOOST_TEST(first == 2100);
+  BOOST_TEST(funcScan(true, ROW_COUNT * 2, true, -1, true, first) == 0);
+  BOOST_TEST(funcScan(false, 0, false, -1, true, first) == 0);
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+}
+
+BOOST_AUTO_TEST_CASE(LeafCursorNonUnique_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testLeafCursorNonUnique" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int KEY_COUNT = 10;
+  const int REPEAT = 1000;
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         3501, IndexType::NON_UNIQUE);
+
+  // Every key repeats REPEAT times with primary key key * REPEAT + n, so the
+  // same keys continue in several leaf pages.
+  vctKey.push_back(dvKey->Clone());
+  int idx = 0;
+  Byte bys[100];
+  bool rt = indexTree->BulkLoad(
+      [&]() -> LeafRecord * {
+        if (idx >= KEY_COUNT * REPEAT)
+          return nullptr;
+        *((DataValueLong *)vctKey[0]) = idx / REPEAT;
+        Int64ToBytes(idx, bys, true);
+        idx++;
+        return new LeafRecord(indexTree, vctKey, bys, sizeof(int64_t),
+                              ActionType::INSERT, nullptr);
+      },
+      100);
+  BOOST_TEST(rt);
+
+  auto funcFirst = [&](bool bForward, int64_t start, bool bStartInc,
+                       int64_t end, int &count) {
+    LeafCursor cursor(indexTree, bForward);
+    *((DataValueLong *)vctKey[0]) = start;
+    RawKey key(vctKey);
+    cursor.Seek(&key, bStartInc);
+    if (end >= 0) {
+      *((DataValueLong *)vctKey[0]) = end;
+      RawKey key(vctKey);
+      cursor.SetEndKey(&key, true);
+    }
+
+    int64_t first = -1;
+    count = 0;
+    while (true) {
+      LeafRecord *lr = cursor.Next();
+      if (lr == nullptr)
+        break;
+      if (first < 0) {
+        RawKey *pkey = lr->GetPrimayKey();
+        first = Int64FromBytes(pkey->GetBysVal(), true);
+        delete pkey;
+      }
+      lr->DecRef();
+      count++;
+    }
+    return first;
+  };
+
+  int count;
+  BOOST_TEST(funcFirst(true, 5, true, 6, count) == 5 * REPEAT);
+  BOOST_TEST(count == 2 * REPEAT);
+  BOOST_TEST(funcFirst(true, 5, false, -1, count) == 6 * REPEAT);
+  BOOST_TEST(count == 4 * REPEAT);
+  BOOST_TEST(funcFirst(false, 5, true, 4, count) == 6 * REPEAT - 1);
+  BOOST_TEST(count == 2 * REPEAT);
+  BOOST_TEST(funcFirst(false, 5, false, -1, count) == 5 * REPEAT - 1);
+  BOOST_TEST(count == 5 * REPEAT);
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+}
+
+BOOST_AUTO_TEST_CASE(LeafCursorPageDivide_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testLeafCursorPageDivide" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 20000;
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         3502, IndexType::PRIMARY);
+
+  auto funcInsert = [indexTree](int start, int step) {
+    VectorDataValue vctKey = {new DataValueLong(0LL)};
+    VectorDataValue vctVal = {new DataValueLong(0LL)};
+    for (int i = start; i < ROW_COUNT * 2; i += step) {
+      *((DataValueLong *)vctKey[0]) = i;
+      *((DataValueLong *)vctVal[0]) = i + 100LL;
+      LeafRecord *rr =
+          new LeafRecord(indexTree, vctKey, vctVal,
+                         indexTree->GetHeadPage()->ReadRecordStamp(), nullptr);
+      IndexPage *idxPage = nullptr;
+      indexTree->SearchRecursively(*rr, true, idxPage, true);
+      ((LeafPage *)idxPage)->InsertRecord(rr, false);
+      PageDividePool::AddPage(idxPage, false);
+      idxPage->WriteUnlock();
+    }
+  };
+  // Every even key must be returned once and in order, the odd keys maybe.
+  auto funcScan = [indexTree](bool bForward) {
+    LeafCursor cursor(indexTree, bForward);
+    int count = 0;
+    int64_t last = bForward ? -1 : INT64_MAX;
+    while (true) {
+      LeafRecord *lr = cursor.Next();
+      if (lr == nullptr)
+        break;
+      int64_t val = GetLongValue(lr) - 100;
+      lr->DecRef();
+      BOOST_TEST((bForward ? val > last : val < last));
+      last = val;
+      if (val % 2 == 0)
+        count++;
+    }
+    return count;
+  };
+
+  funcInsert(0, 2);
+  atomic_bool bInserted{false};
+  thread t([funcInsert, &bInserted]() {
+    funcInsert(1, 2);
+    bInserted.store(true);
+  });
+  int round = 0;
+  while (round < 4 || !bInserted.load()) {
+    BOOST_TEST(funcScan(round % 2 == 0) == ROW_COUNT);
+    round++;
+  }
+  t.join();
+
+  this_thread::sleep_for(100ms);
+  int count = 0;
+  {
+    LeafCursor cursor(indexTree, true);
+    while (true) {
+      LeafRecord *lr = cursor.Next();
+      if (lr == nullptr)
+        break;
+      BOOST_TEST(GetLongValue(lr) == count + 100);
+      lr->DecRef();
+      count++;
+    }
+  }
+  BOOST_TEST(count == ROW_COUNT * 2);
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
@@ -1,7 +1,9 @@
 ﻿#include "../../src/core/LeafPage.h"
+#include "../../src/core/BranchPage.h"
 #include "../../src/core/IndexTree.h"
 #include "../../src/core/LeafRecord.h"
 #include "../../src/dataType/DataValueFactory.h"
+#include "../../src/dataType/DataValueVarChar.h"
 #include "../../src/pool/PageBufferPool.h"
 #include "../../src/pool/PageDividePool.h"
 #include "../../src/pool/StoragePool.h"
@@ -149,8 +151,21 @@ BOOST_AUTO_TEST_CASE(LeafPageSaveLoad_test) {
   indexTree->IncPages();
   lp->DecRef();
   lp->ReadPage();
-  lp->LoadRecords();
   vctKey.push_back(dvKey->Clone(true));
+  // Search on the page bytes before the records are loaded.
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueLong *)vctKey[0]) = i;
+    RawKey key(vctKey);
+    bool bFind;
+    int pos = lp->SearchKey(key, bFind);
+    BOOST_TEST(bFind);
+    BOOST_TEST(pos == i);
+    BOOST_TEST(lp->CompareKey(pos, key) == 0);
+    if (pos > 0)
+      BOOST_TEST(lp->CompareKey(pos - 1, key) < 0);
+  }
+
+  lp->LoadRecords();
   for (int i = 0; i < ROW_COUNT; i++) {
     *((DataValueLong *)vctKey[0]) = i;
     RawKey key(vctKey);
@@ -297,5 +312,424 @@ BOOST_AUTO_TEST_CASE(LeafPageDivide_test) {
   PageBufferPool::AddTimerTask();
 }
 
+BOOST_AUTO_TEST_CASE(LeafPageAppendDivide_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testLeafPageAppendDivide" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = IndexPage::MAX_DATA_LENGTH_LEAF / 10;
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         1005, IndexType::PRIMARY);
+  HeadPage *hp = indexTree->GetHeadPage();
+  LeafPage *lp = (LeafPage *)indexTree->GetPage(0, PageType::LEAF_PAGE, true);
+
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+
+  // Append the increasing keys at the right edge.
+  uint32_t recLen = 0;
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueLong *)vctKey[0]) = i;
+    *((DataValueLong *)vctVal[0]) = i + 100LL;
+    LeafRecord *rr = new LeafRecord(indexTree, vctKey, vctVal,
+                                    hp->GetAndIncRecordStamp(), nullptr);
+    recLen = rr->GetTotalLength() + UI16_LEN;
+    lp->InsertRecord(rr);
+  }
+
+  BOOST_TEST(lp->IsAppendOnly());
+  BOOST_TEST(lp->PageDivide());
+  BOOST_TEST(!lp->IsAppendOnly());
+  BOOST_TEST(indexTree->GetDivideCount() == 1U);
+  BOOST_TEST(indexTree->GetAppendDivideCount() == 1U);
+  BOOST_TEST(indexTree->GetDivideFillPercent() > IndexPage::LOAD_FACTOR);
+
+  // All pages are full except the last one.
+  int count = 0;
+  LeafPage *lpCurr = lp;
+  lpCurr->IncRef();
+  while (true) {
+    count += lpCurr->GetRecordNumber();
+    PageID nid = lpCurr->GetNextPageId();
+    if (nid == PAGE_NULL_POINTER) {
+      BOOST_TEST(lpCurr->IsEndPage());
+      lpCurr->DecRef();
+      break;
+    }
+
+    BOOST_TEST(lpCurr->GetTotalDataLength() + recLen >
+               IndexPage::MAX_DATA_LENGTH_LEAF);
+    BOOST_TEST(!lpCurr->IsEndPage());
+    LeafPage *lpNext =
+        (LeafPage *)indexTree->GetPage(nid, PageType::LEAF_PAGE, true);
+    lpCurr->DecRef();
+    lpCurr = lpNext;
+  }
+  BOOST_TEST(count == ROW_COUNT);
+
+  // The records inserted before the first key are divided by LOAD_FACTOR.
+  for (int i = 1; i <= ROW_COUNT / 4; i++) {
+    *((DataValueLong *)vctKey[0]) = -i;
+    *((DataValueLong *)vctVal[0]) = i + 100LL;
+    LeafRecord *rr = new LeafRecord(indexTree, vctKey, vctVal,
+                                    hp->GetAndIncRecordStamp(), nullptr);
+    lp->InsertRecord(rr);
+  }
+
+  BOOST_TEST(!lp->IsAppendOnly());
+  BOOST_TEST(lp->PageDivide());
+  BOOST_TEST(lp->GetTotalDataLength() <=
+             IndexPage::MAX_DATA_LENGTH_LEAF * IndexPage::LOAD_FACTOR / 100U +
+                 recLen);
+  BOOST_TEST(indexTree->GetDivideCount() == 2U);
+  BOOST_TEST(indexTree->GetAppendDivideCount() == 1U);
+  lp->DecRef();
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+
+  StoragePool::AddTimerTask();
+  PageDividePool::AddTimerTask();
+  PageBufferPool::AddTimerTask();
+}
+
+BOOST_AUTO_TEST_CASE(LeafPageDividePartition_test) {
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = IndexPage::MAX_DATA_LENGTH_LEAF / 10;
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+
+  uint32_t parts = PageDividePool::GetPartitionCount();
+  BOOST_TEST(parts == Configure::GetDividePartitions());
+  uint64_t divCount = PageDividePool::GetDivideCount();
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  IndexTree *arTree[2];
+  LeafPage *arPage[2];
+  // Two trees with continuous index ids are in different partitions.
+  for (int t = 0; t < 2; t++) {
+    const string FILE_NAME = ROOT_PATH + "/testLeafPageDividePartition" +
+                             to_string(t) + StrMSTime() + ".dat";
+    VectorDataValue vctKey = {dvKey->Clone()};
+    VectorDataValue vctVal = {dvVal->Clone()};
+    IndexTree *indexTree = new IndexTree();
+    indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey,
+                           vctVal, 1006 + t, IndexType::PRIMARY);
+    HeadPage *hp = indexTree->GetHeadPage();
+    LeafPage *lp =
+        (LeafPage *)indexTree->GetPage(0, PageType::LEAF_PAGE, true);
+    BOOST_TEST(PageDividePool::GetQueueDepth((1006 + t) % parts) > 0U);
+
+    vctKey.push_back(dvKey->Clone());
+    vctVal.push_back(dvVal->Clone());
+    lp->WriteLock();
+    for (int i = 0; i < ROW_COUNT; i++) {
+      *((DataValueLong *)vctKey[0]) = i;
+      *((DataValueLong *)vctVal[0]) = i + 100LL;
+      LeafRecord *rr = new LeafRecord(indexTree, vctKey, vctVal,
+                                      hp->GetAndIncRecordStamp(), nullptr);
+      lp->InsertRecord(rr);
+    }
+    lp->WriteUnlock();
+
+    arTree[t] = indexTree;
+    arPage[t] = lp;
+  }
+
+  // The overlength pages are divided by the tasks of their partitions.
+  PageDividePool::PushTask();
+  for (int i = 0; i < 1000 && PageDividePool::GetDivideCount() < divCount + 2;
+       i++) {
+    this_thread::sleep_for(1ms);
+  }
+
+  BOOST_TEST(PageDividePool::GetDivideCount() >= divCount + 2);
+  BOOST_TEST(PageDividePool::GetDivideTotalUs() >=
+             PageDividePool::GetDivideMaxUs());
+  for (int t = 0; t < 2; t++) {
+    BOOST_TEST(arTree[t]->GetDivideCount() == 1U);
+    arPage[t]->ReadLock();
+    BOOST_TEST(arPage[t]->GetNextPageId() != PAGE_NULL_POINTER);
+    arPage[t]->ReadUnlock();
+    arPage[t]->DecRef();
+    IndexTree::TestCloseWait(arTree[t]);
+  }
+
+  delete dvKey;
+  delete dvVal;
+
+  StoragePool::AddTimerTask();
+  PageDividePool::AddTimerTask();
+  PageBufferPool::AddTimerTask();
+}
+
+BOOST_AUTO_TEST_CASE(LeafPageMerge_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testLeafPageMerge" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 40000;
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         1004, IndexType::PRIMARY);
+  HeadPage *hp = indexTree->GetHeadPage();
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+
+  // Fill all pages to 5%, they are all underfull.
+  MVector<int64_t> vctExpect;
+  int idx = 0;
+  bool b = indexTree->BulkLoad(
+      [&]() -> LeafRecord * {
+        if (idx >= ROW_COUNT)
+          return nullptr;
+        *((DataValueLong *)vctKey[0]) = idx * 100LL;
+        *((DataValueLong *)vctVal[0]) = idx * 100LL;
+        vctExpect.push_back(idx * 100LL);
+        idx++;
+        return new LeafRecord(indexTree, vctKey, vctVal, 0, nullptr);
+      },
+      5);
+  BOOST_TEST(b);
+
+  // Search all keys and check the leaf chain, return the number of leaves.
+  auto funcCheck = [&]() {
+    for (int64_t k : vctExpect) {
+      *((DataValueLong *)vctKey[0]) = k;
+      RawKey key(vctKey);
+      IndexPage *idp = nullptr;
+      indexTree->SearchRecursively(key, false, idp, true);
+      bool bFind;
+      ((LeafPage *)idp)->SearchKey(key, bFind);
+      BOOST_TEST(bFind);
+      idp->ReadUnlock();
+      idp->DecRef();
+    }
+
+    uint32_t pages = 0;
+    size_t pos = 0;
+    LeafPage *lp = indexTree->GetBeginPage();
+    BOOST_TEST(lp->GetPrevPageId() == PAGE_NULL_POINTER);
+    while (true) {
+      pages++;
+      BOOST_TEST(lp->GetRecordNumber() > 0U);
+      for (uint32_t i = 0; i < lp->GetRecordNumber(); i++) {
+        LeafRecord *lr = lp->GetRecord(i);
+        VectorDataValue vdv;
+        lr->GetListValue(vdv);
+        BOOST_TEST(vdv[0]->GetLong() == vctExpect[pos]);
+        lr->DecRef();
+        pos++;
+      }
+
+      PageID nid = lp->GetNextPageId();
+      if (nid == PAGE_NULL_POINTER)
+        break;
+
+      LeafPage *lp2 =
+          (LeafPage *)indexTree->GetPage(nid, PageType::LEAF_PAGE, true);
+      BOOST_TEST(lp2->GetPrevPageId() == lp->GetPageId());
+      lp->DecRef();
+      lp = lp2;
+    }
+    BOOST_TEST(lp->GetPageId() == hp->ReadEndLeafPagePointer());
+    lp->DecRef();
+    BOOST_TEST(pos == vctExpect.size());
+    BOOST_TEST(indexTree->GetRecordsCount() == vctExpect.size());
+    return pages;
+  };
+
+  // Insert records into the first leaf until it is nearly full, then the
+  // second leaf moves records from it instead of merging.
+  LeafPage *lp1 = indexTree->GetBeginPage();
+  LeafPage *lp2 = (LeafPage *)indexTree->GetPage(lp1->GetNextPageId(),
+                                                 PageType::LEAF_PAGE, true);
+  lp1->WriteLock();
+  uint32_t num = lp1->GetRecordNumber();
+  for (uint32_t i = 0; i + 1 < num; i++) {
+    for (int64_t j = 1; j < 100; j++) {
+      if (lp1->GetTotalDataLength() > IndexPage::MAX_DATA_LENGTH_LEAF * 88 / 100)
+        break;
+
+      *((DataValueLong *)vctKey[0]) = i * 100LL + j;
+      *((DataValueLong *)vctVal[0]) = i * 100LL + j;
+      vctExpect.push_back(i * 100LL + j);
+      BOOST_TEST(lp1->InsertRecord(
+          new LeafRecord(indexTree, vctKey, vctVal, 0, nullptr)));
+    }
+  }
+  std::sort(vctExpect.begin(), vctExpect.end());
+  BOOST_TEST(lp1->SaveRecords());
+  lp1->WriteUnlock();
+  uint32_t len1 = lp1->GetTotalDataLength();
+
+  lp2->WriteLock();
+  BOOST_TEST(lp2->IsUnderfull());
+  BOOST_TEST(!lp2->PageMerge());
+  BOOST_TEST(!lp2->IsUnderfull());
+  lp2->WriteUnlock();
+  BOOST_TEST(lp1->GetTotalDataLength() < len1);
+  BOOST_TEST(lp1->GetNextPageId() == lp2->GetPageId());
+  lp1->DecRef();
+  lp2->DecRef();
+  uint32_t leafCount = funcCheck();
+
+  // More pages than QUEUE_LIMIT_SIZE are processed at once.
+  BOOST_TEST(leafCount > PageDividePool::QUEUE_LIMIT_SIZE);
+  LeafPage *lp = indexTree->GetBeginPage();
+  while (true) {
+    PageDividePool::AddPage(lp, true);
+    PageID nid = lp->GetNextPageId();
+    lp->DecRef();
+    if (nid == PAGE_NULL_POINTER)
+      break;
+    lp = (LeafPage *)indexTree->GetPage(nid, PageType::LEAF_PAGE, true);
+  }
+
+  uint32_t totalPages = hp->ReadTotalPageCount();
+  PageDividePool::PoolManage();
+  StoragePool::PoolManage();
+  PageBufferPool::PoolManage();
+  BOOST_TEST(PageBufferPool::GetRemovingCount() == 0U);
+  uint32_t mergedCount = funcCheck();
+  BOOST_TEST(mergedCount < leafCount / 2);
+
+  // The ids of removed pages are reused.
+  PageID pid = indexTree->ApplyPageId(1);
+  BOOST_TEST(pid < totalPages);
+  indexTree->ReleasePageId(pid, 1);
+  BOOST_TEST(hp->ReadTotalPageCount() == totalPages);
+
+  // Merge all children of root into one page, then it becomes the new root.
+  BranchPage *root = (BranchPage *)indexTree->GetPage(
+      hp->ReadRootPagePointer(), PageType::BRANCH_PAGE, true);
+  Byte level = root->GetPageLevel();
+  BOOST_TEST(level > 1);
+  BOOST_TEST(root->GetRecordNumber() > 1U);
+  MVector<PageID> vctId;
+  for (uint32_t i = 0; i < root->GetRecordNumber(); i++) {
+    vctId.push_back(root->GetChildPageId(i, false));
+  }
+  root->DecRef();
+
+  for (PageID id : vctId) {
+    IndexPage *page = indexTree->GetPage(id, PageType::BRANCH_PAGE, true);
+    page->WriteLock();
+    BOOST_TEST(page->IsUnderfull());
+    if (page->PageMerge()) {
+      page->WriteUnlock();
+      PageBufferPool::RemovePage(page);
+    } else {
+      page->WriteUnlock();
+      page->DecRef();
+    }
+  }
+
+  BOOST_TEST(hp->ReadRootPagePointer() == vctId.back());
+  root = (BranchPage *)indexTree->GetPage(hp->ReadRootPagePointer(),
+                                          PageType::BRANCH_PAGE, true);
+  BOOST_TEST(root->GetPageLevel() == level - 1);
+  BOOST_TEST(root->GetParentPageId() == PAGE_NULL_POINTER);
+  BOOST_TEST(root->IsBeginPage());
+  BOOST_TEST(root->IsEndPage());
+  for (uint32_t i = 0; i < root->GetRecordNumber(); i++) {
+    IndexPage *child = indexTree->GetPage(root->GetChildPageId(i, false),
+                                          PageType::BRANCH_PAGE, true);
+    BOOST_TEST(child->GetParentPageId() == root->GetPageId());
+    child->DecRef();
+  }
+  root->DecRef();
+  BOOST_TEST(funcCheck() == mergedCount);
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+
+  StoragePool::AddTimerTask();
+  PageDividePool::AddTimerTask();
+  PageBufferPool::AddTimerTask();
+}
+
+BOOST_AUTO_TEST_CASE(LeafPageKeyHead_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testLeafPageKeyHead" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+
+  PageBufferPool::RemoveTimerTask();
+  PageDividePool::RemoveTimerTask();
+  StoragePool::RemoveTimerTask();
+
+  DataValueVarChar *dvKey = new DataValueVarChar(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         1003, IndexType::PRIMARY);
+  indexTree->GetHeadPage()->WriteKeyVariableFieldCount((short)1);
+  LeafPage *lp =
+      (LeafPage *)indexTree->AllocateNewPage(PAGE_NULL_POINTER, (Byte)0);
+
+  vctKey.push_back(dvKey->Clone(true));
+  vctVal.push_back(dvVal->Clone(true));
+  // Some keys have the same first 8 bytes, or are shorter than 8 bytes.
+  const char *arStr[] = {"abc",       "abcdefgh",  "abcdefgh1", "abcdefgh2",
+                         "abcdefghz", "abd",       "b"};
+  lp->WriteLock();
+  for (int i = 0; i < 7; i++) {
+    *((DataValueVarChar *)vctKey[0]) = arStr[i];
+    *((DataValueLong *)vctVal[0]) = i;
+    LeafRecord *lr = new LeafRecord(indexTree, vctKey, vctVal, 1, nullptr);
+    lp->InsertRecord(lr, i);
+  }
+  BOOST_TEST(lp->SaveRecords());
+  lp->WriteUnlock();
+
+  for (int i = 0; i < 7; i++) {
+    *((DataValueVarChar *)vctKey[0]) = arStr[i];
+    RawKey key(vctKey);
+    bool bFind;
+    BOOST_TEST(lp->SearchKey(key, bFind) == i);
+    BOOST_TEST(bFind);
+  }
+
+  const char *arMiss[] = {"ab", "abcdefgh0", "abcdefgh3", "abce", "c"};
+  int arPos[] = {0, 2, 4, 5, 7};
+  for (int i = 0; i < 5; i++) {
+    *((DataValueVarChar *)vctKey[0]) = arMiss[i];
+    RawKey key(vctKey);
+    bool bFind;
+    BOOST_TEST(lp->SearchKey(key, bFind) == arPos[i]);
+    BOOST_TEST(!bFind);
+  }
+
+  lp->DecRef();
+  indexTree->Close();
+  dvKey->DecRef();
+  dvVal->DecRef();
+
+  StoragePool::AddTimerTask();
+  PageDividePool::AddTimerTask();
+  PageBufferPool::AddTimerTask();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace storage
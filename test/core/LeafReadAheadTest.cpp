@@ -0,0 +1,126 @@
+﻿#include "../../src/core/LeafReadAhead.h"
+#include "../../src/core/IndexTree.h"
+#include "../../src/core/LeafPage.h"
+#include "../../src/dataType/DataValueDigit.h"
+#include "../../src/pool/PageDividePool.h"
+#include "../../src/utils/Utilitys.h"
+#include "../TestHeader.h"
+#include "CoreSuit.h"
+#include <boost/test/unit_test.hpp>
+
+namespace storage {
+BOOST_FIXTURE_TEST_SUITE(CoreTest, SuiteFixture)
+
+BOOST_AUTO_TEST_CASE(LeafReadAhead_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testLeafReadAhead" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int ROW_COUNT = 50000;
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  bool rt = indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(),
+                                   vctKey, vctVal, 3200, IndexType::PRIMARY);
+  BOOST_TEST(rt);
+
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueLong *)vctKey[0]) = i;
+    *((DataValueLong *)vctVal[0]) = i + 100LL;
+    LeafRecord *rr =
+        new LeafRecord(indexTree, vctKey, vctVal,
+                       indexTree->GetHeadPage()->ReadRecordStamp(), nullptr);
+    IndexPage *idxPage = nullptr;
+    indexTree->SearchRecursively(*rr, true, idxPage, true);
+    ((LeafPage *)idxPage)->InsertRecord(rr, false);
+    PageDividePool::AddPage(idxPage, false);
+    idxPage->WriteUnlock();
+  }
+
+  IndexTree::TestCloseWait(indexTree);
+
+  indexTree = new IndexTree();
+  rt = indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey,
+                            vctVal, 3200);
+  BOOST_TEST(rt);
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+
+  // Scan forward from the begin leaf, the records must be in order.
+  LeafReadAhead *ra = new LeafReadAhead(indexTree);
+  LeafPage *lp = indexTree->GetBeginPage();
+  int64_t idx = 0;
+  uint32_t leafCount = 0;
+  while (lp != nullptr) {
+    leafCount++;
+    for (uint32_t i = 0; i < lp->GetRecordNumber(); i++) {
+      LeafRecord *lr = lp->GetRecord(i);
+      *((DataValueLong *)vctKey[0]) = idx;
+      RawKey key(vctKey);
+      BOOST_TEST(lr->CompareKey(key) == 0);
+      lr->DecRef();
+      idx++;
+    }
+
+    LeafPage *next = ra->NextPage(lp);
+    lp->DecRef();
+    lp = next;
+  }
+
+  BOOST_TEST(idx == ROW_COUNT);
+  BOOST_TEST(leafCount > LeafReadAhead::TRIGGER_PAGES * 2);
+  BOOST_TEST(ra->GetPrefetchCount() > 0);
+  BOOST_TEST(ra->GetHitCount() > 0);
+  BOOST_TEST(ra->GetHitCount() <= ra->GetPrefetchCount());
+  BOOST_TEST(ra->GetWindow() > LeafReadAhead::MIN_WINDOW);
+  delete ra;
+  // The whole chain has been used, the window is kept for the next scan.
+  BOOST_TEST(indexTree->GetReadAheadWindow() > LeafReadAhead::MIN_WINDOW);
+
+  // Scan backward from the end leaf
+  ra = new LeafReadAhead(indexTree);
+  lp = (LeafPage *)indexTree->GetPage(
+      (PageID)indexTree->GetHeadPage()->ReadEndLeafPagePointer(),
+      PageType::LEAF_PAGE, true);
+  idx = 0;
+  while (lp != nullptr) {
+    idx += lp->GetRecordNumber();
+    LeafPage *prev = ra->PrevPage(lp);
+    lp->DecRef();
+    lp = prev;
+  }
+  BOOST_TEST(idx == ROW_COUNT);
+  delete ra;
+  IndexTree::TestCloseWait(indexTree);
+
+  // A short scan over cold pages leaves most prefetched pages unused, the
+  // window shrinks.
+  indexTree = new IndexTree();
+  rt = indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey,
+                            vctVal, 3200);
+  BOOST_TEST(rt);
+  indexTree->SetReadAheadWindow(LeafReadAhead::MAX_WINDOW);
+  ra = new LeafReadAhead(indexTree);
+  lp = indexTree->GetBeginPage();
+  for (uint32_t i = 0; i < LeafReadAhead::TRIGGER_PAGES && lp != nullptr;
+       i++) {
+    LeafPage *next = ra->NextPage(lp);
+    lp->DecRef();
+    lp = next;
+  }
+  if (lp != nullptr)
+    lp->DecRef();
+  delete ra;
+  BOOST_TEST(indexTree->GetReadAheadWindow() < LeafReadAhead::MAX_WINDOW);
+
+  IndexTree::TestCloseWait(indexTree);
+  delete dvKey;
+  delete dvVal;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
@@ -0,0 +1,95 @@
+﻿#include "../../src/core/PageReadScheduler.h"
+#include "../../src/core/IndexTree.h"
+#include "../../src/pool/PageBufferPool.h"
+#include "../../src/pool/StoragePool.h"
+#include "../../src/utils/Utilitys.h"
+#include "../TestHeader.h"
+#include "CoreSuit.h"
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+
+namespace storage {
+BOOST_FIXTURE_TEST_SUITE(CoreTest, SuiteFixture)
+
+BOOST_AUTO_TEST_CASE(PageReadScheduler_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testPageReadScheduler" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const int NUM = 200;
+
+  VectorDataValue vctKey;
+  VectorDataValue vctVal;
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         3100, IndexType::PRIMARY);
+  indexTree->GetHeadPage()->GetAndIncTotalPageCount(NUM);
+  for (int i = 1; i <= NUM; i++) {
+    CachePage *page = new CachePage(indexTree, i, PageType::UNKNOWN);
+    page->WriteInt(0, i);
+    page->WriteInt(CachePage::CRC32_PAGE_OFFSET - 4, i * 3);
+    page->SetDirty(true);
+    indexTree->IncPages();
+    StoragePool::AddPage(page, false);
+    page->DecRef();
+  }
+  IndexTree::TestCloseWait(indexTree);
+
+  class PageCheckTask : public Task {
+  public:
+    PageCheckTask(CachePage *page, int id, atomic_int32_t &count)
+        : _page(page), _id(id), _count(count) {}
+    bool IsSmallTask() override { return false; }
+    void Run() override {
+      BOOST_TEST(_id == _page->ReadInt(0));
+      BOOST_TEST(_id * 3 == _page->ReadInt(CachePage::CRC32_PAGE_OFFSET - 4));
+      _page->DecRef();
+      _count.fetch_add(1, memory_order_release);
+      _status = TaskStatus::FINISHED;
+    }
+
+    CachePage *_page;
+    int _id;
+    atomic_int32_t &_count;
+  };
+
+  indexTree = new IndexTree();
+  indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                       3100);
+  PageReadScheduler *scheduler = indexTree->GetReadScheduler();
+
+  // Add pages with random order, they should be loaded with few merged reads.
+  atomic_int32_t count{0};
+  vector<CachePage *> vctPage;
+  for (int i = 1; i <= NUM; i++) {
+    CachePage *page = new CachePage(indexTree, i, PageType::UNKNOWN);
+    indexTree->IncPages();
+    vctPage.push_back(page);
+  }
+  for (int i = 0; i < NUM; i++) {
+    int idx = (i * 37) % NUM;
+    CachePage *page = vctPage[idx];
+    page->PushWaitTask(new PageCheckTask(page, idx + 1, count));
+    scheduler->AddPage(page, false);
+  }
+
+  while (count.load(memory_order_acquire) < NUM) {
+    this_thread::sleep_for(1ms);
+  }
+  BOOST_TEST(scheduler->GetReadPageCount() == NUM);
+  BOOST_TEST(scheduler->GetReadCallCount() < NUM);
+
+  // Load inline and wait in current thread
+  CachePage *page = new CachePage(indexTree, NUM / 2, PageType::UNKNOWN);
+  indexTree->IncPages();
+  scheduler->AddPage(page, true);
+  page->WaitRead();
+  BOOST_TEST(page->ReadInt(0) == NUM / 2);
+  page->DecRef(2);
+
+  for (CachePage *page : vctPage)
+    page->DecRef();
+  IndexTree::TestCloseWait(indexTree);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
@@ -0,0 +1,112 @@
+﻿#include "../../src/core/PageWarmup.h"
+#include "../../src/core/IndexTree.h"
+#include "../../src/core/LeafPage.h"
+#include "../../src/dataType/DataValueDigit.h"
+#include "../../src/pool/PageBufferPool.h"
+#include "../../src/pool/PageDividePool.h"
+#include "../../src/utils/Utilitys.h"
+#include "../TestHeader.h"
+#include "CoreSuit.h"
+#include <boost/test/unit_test.hpp>
+
+namespace storage {
+BOOST_FIXTURE_TEST_SUITE(CoreTest, SuiteFixture)
+
+BOOST_AUTO_TEST_CASE(PageWarmup_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testPageWarmup" + StrMSTime() + ".dat";
+  const string LIST_NAME =
+      ROOT_PATH + "/testPageWarmup" + StrMSTime() + ".lst";
+  const string TABLE_NAME = "testTable";
+  const uint32_t FILE_ID = 3300;
+  const int ROW_COUNT = 20000;
+
+  DataValueLong *dvKey = new DataValueLong(100);
+  DataValueLong *dvVal = new DataValueLong(200);
+  VectorDataValue vctKey = {dvKey->Clone()};
+  VectorDataValue vctVal = {dvVal->Clone()};
+  IndexTree *indexTree = new IndexTree();
+  bool rt = indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(),
+                                   vctKey, vctVal, FILE_ID, IndexType::PRIMARY);
+  BOOST_TEST(rt);
+
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  for (int i = 0; i < ROW_COUNT; i++) {
+    *((DataValueLong *)vctKey[0]) = i;
+    *((DataValueLong *)vctVal[0]) = i + 100LL;
+    LeafRecord *rr =
+        new LeafRecord(indexTree, vctKey, vctVal,
+                       indexTree->GetHeadPage()->ReadRecordStamp(), nullptr);
+    IndexPage *idxPage = nullptr;
+    indexTree->SearchRecursively(*rr, true, idxPage, true);
+    ((LeafPage *)idxPage)->InsertRecord(rr, false);
+    PageDividePool::AddPage(idxPage, false);
+    idxPage->WriteUnlock();
+  }
+  IndexTree::TestCloseWait(indexTree);
+
+  // Visit all leaves, then save the pages in pool.
+  indexTree = new IndexTree();
+  rt = indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey,
+                            vctVal, FILE_ID);
+  BOOST_TEST(rt);
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  MVector<PageID> vctLeaf;
+  LeafPage *lp = indexTree->GetBeginPage();
+  while (true) {
+    vctLeaf.push_back(lp->GetPageId());
+    PageID nid = lp->GetNextPageId();
+    lp->DecRef();
+    if (nid == PAGE_NULL_POINTER)
+      break;
+    lp = (LeafPage *)indexTree->GetPage(nid, PageType::LEAF_PAGE, true);
+  }
+  BOOST_TEST(vctLeaf.size() > 10);
+
+  uint64_t saved = PageBufferPool::SaveWarmupList(LIST_NAME);
+  BOOST_TEST(saved > vctLeaf.size());
+  IndexTree::TestCloseWait(indexTree);
+
+  // The pages are loaded in background after the tree opened.
+  BOOST_TEST(PageBufferPool::LoadWarmupList(LIST_NAME) == saved);
+  indexTree = new IndexTree();
+  rt = indexTree->InitIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey,
+                            vctVal, FILE_ID);
+  BOOST_TEST(rt);
+  vctKey.push_back(dvKey->Clone());
+  vctVal.push_back(dvVal->Clone());
+  MVector<PageID> vctId;
+  PageBufferPool::TakeWarmupPages(FILE_ID, vctId);
+  BOOST_TEST(vctId.size() == 0);
+
+  for (int i = 0; i < 5000 && PageBufferPool::GetCacheSize() < saved; i++) {
+    this_thread::sleep_for(1ms);
+  }
+  BOOST_TEST(PageBufferPool::GetCacheSize() == saved);
+  for (PageID pid : vctLeaf) {
+    CachePage *page = PageBufferPool::GetPage(FILE_ID, pid);
+    BOOST_TEST(page != nullptr);
+    if (page != nullptr) {
+      BOOST_TEST((page->GetPageType() == PageType::LEAF_PAGE));
+      BOOST_TEST((page->GetPageStatus() == PageStatus::VALID));
+      page->DecRef();
+    }
+  }
+
+  // The pages in pool, out of file or failed to verify are skipped.
+  vctId = {vctLeaf[0], indexTree->GetHeadPage()->ReadTotalPageCount() + 10};
+  PageWarmup *warmup = new PageWarmup(indexTree, vctId);
+  BOOST_TEST(warmup->Load() == 0);
+  BOOST_TEST(warmup->GetReadCallCount() == 0);
+  delete warmup;
+
+  IndexTree::TestCloseWait(indexTree);
+  filesystem::remove(LIST_NAME);
+  delete dvKey;
+  delete dvVal;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
@@ -0,0 +1,75 @@
+﻿#include "../../src/file/AsyncIo.h"
+#include "../../src/config/Configure.h"
+#include "../../src/utils/Log.h"
+#include "../../src/utils/Utilitys.h"
+#include "../TestHeader.h"
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <filesystem>
+
+namespace storage {
+BOOST_AUTO_TEST_SUITE(PageFileTest)
+
+BOOST_AUTO_TEST_CASE(AsyncIo_test) {
+  namespace fs = std::filesystem;
+  const string pageName = ROOT_PATH + "/testAsyncIo" + StrMSTime() + ".dat";
+  const uint32_t PAGE_COUNT = 100;
+  uint32_t pageLen = (uint32_t)Configure::GetCachePageSize();
+
+  class TestReadTask : public AsyncIoTask {
+  public:
+    TestReadTask(PageFile *pf, uint32_t idx, uint32_t len, char *bys,
+                 atomic_int32_t &count)
+        : AsyncIoTask(pf, (uint64_t)idx * len, bys, len), _count(count) {}
+    void IoComplete() override { _count.fetch_add(1, memory_order_release); }
+
+    atomic_int32_t &_count;
+  };
+
+  fs::path path(ROOT_PATH);
+  if (!fs::exists(path))
+    fs::create_directories(path);
+  PageFile pf(pageName.c_str());
+
+  char *bys = new char[pageLen];
+  for (uint32_t i = 0; i < PAGE_COUNT; i++) {
+    memset(bys, (int)i, pageLen);
+    pf.WritePage((uint64_t)i * pageLen, bys, pageLen);
+  }
+  delete[] bys;
+
+  ThreadPool *tp = ThreadPool::InitMain(100000, 1, 2);
+  bool bUring = AsyncIo::InitAsyncIo(tp);
+  BOOST_TEST(AsyncIo::IsRunning());
+  BOOST_TEST(AsyncIo::IsUring() == bUring);
+  LOG_INFO << "AsyncIo test, io_uring=" << bUring;
+
+  char *buf = new char[pageLen * PAGE_COUNT];
+  memset(buf, 0xFF, pageLen * PAGE_COUNT);
+  atomic_int32_t count{0};
+  for (uint32_t i = 0; i < PAGE_COUNT; i++) {
+    AsyncIo::SubmitRead(
+        new TestReadTask(&pf, i, pageLen, buf + i * pageLen, count));
+  }
+
+  while (count.load(memory_order_acquire) < (int32_t)PAGE_COUNT) {
+    this_thread::sleep_for(1ms);
+  }
+
+  for (uint32_t i = 0; i < PAGE_COUNT; i++) {
+    BOOST_TEST(buf[i * pageLen] == (char)i);
+    BOOST_TEST(buf[(i + 1) * pageLen - 1] == (char)i);
+  }
+  BOOST_TEST(AsyncIo::GetInflightCount() == 0);
+
+  AsyncIo::StopAsyncIo();
+  BOOST_TEST(!AsyncIo::IsRunning());
+  ThreadPool::StopMain();
+
+  delete[] buf;
+  pf.close();
+  fs::remove(fs::path(pageName));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
@@ -1,4 +1,5 @@
 ﻿#include "../../src/file/PageFile.h"
+#include "../../src/cache/CachePool.h"
 #include "../../src/config/Configure.h"
 #include "../../src/dataType/DataValueFactory.h"
 #include "../../src/utils/Log.h"
@@ -6,6 +7,7 @@
 #include "../TestHeader.h"
 #include <boost/test/unit_test.hpp>
 #include <filesystem>
+#include <thread>
 
 namespace storage {
 BOOST_AUTO_TEST_SUITE(PageFileTest)
@@ -51,5 +53,103 @@ BOOST_AUTO_TEST_CASE(PageFile_test) {
   delete[] bys2;
 }
 
+BOOST_AUTO_TEST_CASE(PageFileShared_test) {
+  namespace fs = std::filesystem;
+  const string pageName = ROOT_PATH + "/testPageFile" + StrMSTime() + ".dat";
+  const uint32_t PAGE_COUNT = 64;
+  const int THREAD_COUNT = 4;
+  uint32_t pageLen = (uint32_t)Configure::GetCachePageSize();
+
+  fs::path path(ROOT_PATH);
+  if (!fs::exists(path))
+    fs::create_directories(path);
+  PageFile pf(pageName.c_str());
+
+  char *bys = new char[pageLen * PAGE_COUNT];
+  iovec iov[PAGE_COUNT];
+  for (uint32_t i = 0; i < PAGE_COUNT; i++) {
+    memset(bys + i * pageLen, (int)i, pageLen);
+    iov[i].iov_base = bys + i * pageLen;
+    iov[i].iov_len = pageLen;
+  }
+  pf.WritePages(0, iov, PAGE_COUNT);
+  BOOST_TEST(pf.Length() == (uint64_t)pageLen * PAGE_COUNT);
+
+  memset(bys, 0xFF, pageLen * PAGE_COUNT);
+  BOOST_TEST(pf.ReadPages(pageLen * 2, iov, 4) == pageLen * 4);
+  BOOST_TEST(bys[0] == (char)2);
+  BOOST_TEST(bys[pageLen * 4 - 1] == (char)5);
+
+  // All threads share the same PageFile and read at the same time.
+  atomic_int32_t errCount{0};
+  vector<thread> vctThread;
+  for (int t = 0; t < THREAD_COUNT; t++) {
+    vctThread.emplace_back([&pf, &errCount, pageLen, t]() {
+      char *buf = new char[pageLen];
+      for (uint32_t i = 0; i < PAGE_COUNT * 4; i++) {
+        uint32_t idx = (i * 7 + t) % PAGE_COUNT;
+        pf.ReadPage((uint64_t)idx * pageLen, buf, pageLen);
+        if (buf[0] != (char)idx || buf[pageLen - 1] != (char)idx)
+          errCount.fetch_add(1);
+      }
+      delete[] buf;
+    });
+  }
+  for (thread &t : vctThread)
+    t.join();
+  BOOST_TEST(errCount.load() == 0);
+
+  pf.close();
+  fs::remove(fs::path(pageName));
+  delete[] bys;
+}
+
+BOOST_AUTO_TEST_CASE(PageFileDirect_test) {
+  namespace fs = std::filesystem;
+  const string pageName = ROOT_PATH + "/testPageFile" + StrMSTime() + ".dat";
+  uint32_t pageLen = (uint32_t)Configure::GetCachePageSize();
+  uint32_t clusterLen = (uint32_t)Configure::GetDiskClusterSize();
+
+  fs::path path(ROOT_PATH);
+  if (!fs::exists(path))
+    fs::create_directories(path);
+  // If the file system does not support O_DIRECT, it will fall back to
+  // buffered mode and the test still need pass.
+  PageFile pf(pageName.c_str(), true);
+  BOOST_TEST(pf.IsValid());
+  LOG_INFO << "PageFile direct mode: " << pf.IsDirect();
+
+  Byte *head = CachePool::Apply(clusterLen);
+  Byte *bys1 = CachePool::ApplyPage();
+  Byte *bys2 = CachePool::ApplyPage();
+  Byte *ovf = CachePool::Apply(pageLen * 3);
+  BOOST_TEST((uint64_t)head % clusterLen == 0);
+  BOOST_TEST((uint64_t)bys1 % clusterLen == 0);
+  BOOST_TEST((uint64_t)bys2 % clusterLen == 0);
+  BOOST_TEST((uint64_t)ovf % clusterLen == 0);
+
+  memset(head, 1, clusterLen);
+  pf.WritePage(0, (char *)head, clusterLen);
+  for (uint32_t i = 0; i < pageLen; i++)
+    bys1[i] = (Byte)i;
+  pf.WritePage(clusterLen, (char *)bys1, pageLen);
+  memset(ovf, 3, pageLen * 3);
+  pf.WritePage(clusterLen + pageLen, (char *)ovf, pageLen * 3);
+
+  pf.ReadPage(clusterLen, (char *)bys2, pageLen);
+  BOOST_TEST(memcmp(bys1, bys2, pageLen) == 0);
+  memset(ovf, 0, pageLen * 3);
+  pf.ReadPage(clusterLen + pageLen, (char *)ovf, pageLen * 3);
+  BOOST_TEST(ovf[0] == 3);
+  BOOST_TEST(ovf[pageLen * 3 - 1] == 3);
+
+  CachePool::Release(head, clusterLen);
+  CachePool::ReleasePage(bys1);
+  CachePool::ReleasePage(bys2);
+  CachePool::Release(ovf, pageLen * 3);
+  pf.close();
+  fs::remove(fs::path(pageName));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace storage
@@ -0,0 +1,194 @@
+﻿#include "../../src/pool/PageBufferPool.h"
+#include "../../src/core/IndexTree.h"
+#include "../../src/pool/PageDividePool.h"
+#include "../../src/pool/StoragePool.h"
+#include "../../src/utils/Utilitys.h"
+#include "../TestHeader.h"
+
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+
+namespace storage {
+namespace fs = std::filesystem;
+
+BOOST_AUTO_TEST_SUITE(PoolTest)
+
+BOOST_AUTO_TEST_CASE(PageBufferPoolWatermark_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testPageBufferPool" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const uint64_t MAX_PAGES = 1000;
+  const int NUM = 5000;
+
+  ThreadPool *tp = ThreadPool::InitMain(100000, 1, 1);
+  TimerThread::Start();
+  StoragePool::InitPool(tp);
+  PageDividePool::InitPool(tp);
+  PageBufferPool::InitPool(tp);
+  uint64_t oldMax = PageBufferPool::GetMaxCacheSize();
+  PageBufferPool::SetMaxCacheSize(MAX_PAGES);
+
+  VectorDataValue vctKey;
+  VectorDataValue vctVal;
+  IndexTree *indexTree = new IndexTree();
+  indexTree->CreateIndex(TABLE_NAME.c_str(), FILE_NAME.c_str(), vctKey, vctVal,
+                         0, IndexType::PRIMARY);
+
+  // Add pages in the only thread of pool, so PagePoolTask can not run before
+  // it finished and the pages can only be evicted inline.
+  class AddPageTask : public Task {
+  public:
+    AddPageTask(IndexTree *indexTree, int num, uint64_t *maxSize,
+                atomic_bool *bFinish)
+        : _indexTree(indexTree), _num(num), _maxSize(maxSize),
+          _bFinish(bFinish) {}
+    bool IsSmallTask() override { return false; }
+    void Run() override {
+      for (int i = 1; i <= _num; i++) {
+        CachePage *page = new CachePage(_indexTree, i, PageType::UNKNOWN);
+        _indexTree->IncPages();
+        PageBufferPool::AddPage(page);
+        page->DecRef();
+        *_maxSize = max(*_maxSize, PageBufferPool::GetCacheSize());
+      }
+      _status = TaskStatus::FINISHED;
+      _bFinish->store(true);
+    }
+
+    IndexTree *_indexTree;
+    int _num;
+    uint64_t *_maxSize;
+    atomic_bool *_bFinish;
+  };
+
+  uint64_t maxSize = 0;
+  atomic_bool bAdded{false};
+  tp->AddTask(new AddPageTask(indexTree, NUM, &maxSize, &bAdded));
+  while (!bAdded.load()) {
+    this_thread::sleep_for(1ms);
+  }
+
+  // The pool can not grow over hard limit even without PoolManage
+  uint64_t hardLimit = MAX_PAGES * Configure::GetPoolHardLimit() / 100;
+  BOOST_TEST(maxSize <= hardLimit + 1);
+  BOOST_TEST(PageBufferPool::GetInlineEvictCount() > 0);
+
+  // PoolManage has been scheduled after exceed high watermark
+  uint64_t lowWatermark = MAX_PAGES * Configure::GetPoolLowWatermark() / 100;
+  for (int i = 0; i < 10000; i++) {
+    if (PageBufferPool::GetCacheSize() <= lowWatermark)
+      break;
+    this_thread::sleep_for(1ms);
+  }
+  BOOST_TEST(PageBufferPool::GetCacheSize() <= lowWatermark);
+
+  atomic_bool finish{false};
+  indexTree->Close([&finish]() { finish.store(true, memory_order_relaxed); });
+  while (PageBufferPool::GetCacheSize() > 0 ||
+         !finish.load(memory_order_relaxed)) {
+    this_thread::sleep_for(1ms);
+    StoragePool::PushTask();
+    PageDividePool::PushTask();
+    PageBufferPool::PoolManage();
+  }
+
+  PageBufferPool::SetMaxCacheSize(oldMax);
+  TimerThread::Stop();
+  ThreadPool::StopMain();
+  PageDividePool::StopPool();
+  StoragePool::StopPool();
+  PageBufferPool::StopPool();
+  fs::remove(fs::path(FILE_NAME));
+}
+
+BOOST_AUTO_TEST_CASE(PageBufferPoolQuota_test) {
+  const string FILE_NAME =
+      ROOT_PATH + "/testPageBufferPoolQuota" + StrMSTime() + ".dat";
+  const string TABLE_NAME = "testTable";
+  const uint64_t MAX_PAGES = 1000;
+
+  ThreadPool *tp = ThreadPool::InitMain(100000, 1, 1);
+  TimerThread::Start();
+  StoragePool::InitPool(tp);
+  PageDividePool::InitPool(tp);
+  PageBufferPool::InitPool(tp);
+  uint64_t oldMax = PageBufferPool::GetMaxCacheSize();
+  PageBufferPool::SetMaxCacheSize(MAX_PAGES);
+
+  VectorDataValue vctKey;
+  VectorDataValue vctVal;
+  IndexTree *critical = new IndexTree();
+  critical->CreateIndex(TABLE_NAME.c_str(), (FILE_NAME + "1").c_str(), vctKey,
+                        vctVal, 1, IndexType::PRIMARY);
+  IndexTree *noisy = new IndexTree();
+  noisy->CreateIndex(TABLE_NAME.c_str(), (FILE_NAME + "2").c_str(), vctKey,
+                     vctVal, 2, IndexType::PRIMARY);
+
+  auto funcAdd = [](IndexTree *indexTree, PageID start, PageID end,
+                    PageType type) {
+    for (PageID i = start; i < end; i++) {
+      CachePage *page = new CachePage(indexTree, i, type);
+      indexTree->IncPages();
+      PageBufferPool::AddPage(page);
+      page->DecRef();
+    }
+  };
+  auto funcWait = [](function<bool()> func) {
+    for (int i = 0; i < 10000 && !func(); i++) {
+      this_thread::sleep_for(1ms);
+      PageBufferPool::PoolManage();
+    }
+    return func();
+  };
+
+  critical->SetPoolQuota(100, 0);
+  critical->SetPinBranches(true);
+  funcAdd(critical, 1, 11, PageType::BRANCH_PAGE);
+  funcAdd(critical, 11, 201, PageType::UNKNOWN);
+  BOOST_TEST(critical->GetPoolPages() == 201);
+
+  // The noisy tree is limited to its max share.
+  noisy->SetPoolQuota(0, 200);
+  funcAdd(noisy, 1, 2001, PageType::UNKNOWN);
+  BOOST_TEST(funcWait([noisy]() { return noisy->GetPoolPages() <= 200; }));
+  BOOST_TEST(critical->GetPoolPages() == 201);
+
+  // Without limit, the noisy tree fills the pool, but the critical tree keeps
+  // its reserved pages and branch pages.
+  noisy->SetPoolQuota(0, 0);
+  funcAdd(noisy, 2001, 5001, PageType::UNKNOWN);
+  uint64_t lowWatermark = MAX_PAGES * Configure::GetPoolLowWatermark() / 100;
+  BOOST_TEST(funcWait([lowWatermark]() {
+    return PageBufferPool::GetCacheSize() <= lowWatermark;
+  }));
+  BOOST_TEST(critical->GetPoolPages() >= 100);
+  BOOST_TEST(critical->GetPoolPages() < 201);
+  for (PageID i = 1; i < 11; i++) {
+    CachePage *page = PageBufferPool::GetPage(1, i);
+    BOOST_TEST(page != nullptr);
+    if (page != nullptr)
+      page->DecRef();
+  }
+
+  atomic_int32_t finish{0};
+  critical->Close([&finish]() { finish.fetch_add(1); });
+  noisy->Close([&finish]() { finish.fetch_add(1); });
+  while (PageBufferPool::GetCacheSize() > 0 || finish.load() < 2) {
+    this_thread::sleep_for(1ms);
+    StoragePool::PushTask();
+    PageDividePool::PushTask();
+    PageBufferPool::PoolManage();
+  }
+
+  PageBufferPool::SetMaxCacheSize(oldMax);
+  TimerThread::Stop();
+  ThreadPool::StopMain();
+  PageDividePool::StopPool();
+  StoragePool::StopPool();
+  PageBufferPool::StopPool();
+  fs::remove(fs::path(FILE_NAME + "1"));
+  fs::remove(fs::path(FILE_NAME + "2"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
@@ -0,0 +1,140 @@
+﻿#include "../../src/pool/PageTable.h"
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include <vector>
+
+namespace storage {
+BOOST_AUTO_TEST_SUITE(PoolTest)
+
+struct TableItem {
+  TableItem(uint64_t id) : _id(id) {}
+  void IncRef() { _refCount.fetch_add(1); }
+  void DecRef() { _refCount.fetch_sub(1); }
+
+  uint64_t _id;
+  atomic<int32_t> _refCount{1};
+};
+
+BOOST_AUTO_TEST_CASE(PageTable_test) {
+  const uint64_t NUM = 10000;
+  // Small capacity to test the table grows
+  PageTable<TableItem> table(100);
+  uint64_t buckets = table.GetBucketCount();
+  std::vector<TableItem *> vct;
+  for (uint64_t i = 0; i < NUM; i++) {
+    vct.push_back(new TableItem(i << 32 | i));
+    BOOST_TEST(table.Insert(vct[i]->_id, vct[i]));
+  }
+  BOOST_TEST(table.Size() == NUM);
+  BOOST_TEST(table.GetBucketCount() > buckets);
+  BOOST_TEST(!table.Insert(vct[5]->_id, vct[5]));
+
+  for (uint64_t i = 0; i < NUM; i++) {
+    TableItem *item = table.Find(vct[i]->_id);
+    BOOST_TEST(item == vct[i]);
+    BOOST_TEST(item->_refCount.load() == 2);
+    item->DecRef();
+  }
+  BOOST_TEST(table.Find(NUM << 32) == nullptr);
+
+  // Only erase the items that funcCheck returns true
+  vct[1]->IncRef();
+  auto funcCheck = [](TableItem *item) { return item->_refCount == 1; };
+  BOOST_TEST(table.EraseIf(vct[1]->_id, funcCheck) == nullptr);
+  vct[1]->DecRef();
+
+  for (uint64_t i = 0; i < NUM; i += 2) {
+    TableItem *item = table.EraseIf(vct[i]->_id, funcCheck);
+    BOOST_TEST(item == vct[i]);
+    table.Retire(item);
+  }
+  BOOST_TEST(table.Size() == NUM / 2);
+  for (uint64_t i = 0; i < NUM; i++) {
+    TableItem *item = table.Find(vct[i]->_id);
+    if (i % 2 == 0) {
+      BOOST_TEST(item == nullptr);
+      BOOST_TEST(vct[i]->_refCount.load() == 1);
+    } else {
+      BOOST_TEST(item == vct[i]);
+      item->DecRef();
+    }
+  }
+
+  // The retired items are released after reclaim
+  BOOST_TEST(table.Reclaim() == NUM / 2);
+  BOOST_TEST(vct[0]->_refCount.load() == 0);
+
+  table.Clear();
+  BOOST_TEST(table.Size() == 0);
+  for (TableItem *item : vct) {
+    BOOST_TEST(item->_refCount.load() == 0);
+    delete item;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PageTableConcurrent_test) {
+  const uint64_t NUM = 2000;
+  const int READERS = 4;
+  PageTable<TableItem> table(NUM / 4);
+  std::vector<TableItem *> vct;
+  for (uint64_t i = 0; i < NUM; i++) {
+    vct.push_back(new TableItem(i));
+  }
+
+  atomic_bool bStop{false};
+  atomic<uint64_t> errors{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; r++) {
+    readers.emplace_back([&, r]() {
+      uint64_t k = r;
+      while (!bStop.load(memory_order_relaxed)) {
+        k = (k * 7 + 13) % NUM;
+        TableItem *item = table.Find(k);
+        if (item == nullptr)
+          continue;
+        if (item->_id != k || item->_refCount.load() < 2)
+          errors.fetch_add(1);
+        item->DecRef();
+      }
+    });
+  }
+
+  // Insert and erase repeatedly while reading, the table grows meanwhile.
+  auto funcCheck = [](TableItem *item) { return item->_refCount == 1; };
+  for (int round = 0; round < 20; round++) {
+    for (uint64_t i = 0; i < NUM; i++) {
+      table.Insert(i, vct[i]);
+    }
+    uint64_t erased = 0;
+    while (erased < NUM) {
+      for (uint64_t i = 0; i < NUM; i++) {
+        TableItem *item = table.EraseIf(i, funcCheck);
+        if (item != nullptr) {
+          table.Retire(item);
+          erased++;
+        }
+      }
+    }
+    // The retired items can be inserted again only after reclaim.
+    table.Reclaim();
+    for (uint64_t i = 0; i < NUM; i++) {
+      vct[i]->IncRef();
+    }
+  }
+
+  bStop.store(true);
+  for (std::thread &t : readers) {
+    t.join();
+  }
+
+  BOOST_TEST(errors.load() == 0);
+  BOOST_TEST(table.Size() == 0);
+  table.Clear();
+  for (TableItem *item : vct) {
+    BOOST_TEST(item->_refCount.load() == 1);
+    delete item;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
@@ -100,6 +100,11 @@ BOOST_AUTO_TEST_CASE(StoragePool_test) {
     PageBufferPool::PoolManage();
   }
 
+  // The pages are continuous, so they should be merged into fewer writes.
+  BOOST_TEST(StoragePool::GetWrittenPageCount() >= (uint64_t)NUM);
+  BOOST_TEST(StoragePool::GetWriteCallCount() <
+             StoragePool::GetWrittenPageCount());
+
   class PageCmpTask : public Task {
   public:
     PageCmpTask(CachePage *page, int id, const char *pStrTest, size_t sz)
@@ -135,5 +135,50 @@ BOOST_AUTO_TEST_CASE(BytesConvert_test) {
   gap = fval - frt;
   BOOST_TEST((gap < 0.00000001 && gap > -0.00000001));
 }
+BOOST_AUTO_TEST_CASE(BytesCompare_test) {
+  auto sign = [](int hr) { return hr > 0 ? 1 : (hr < 0 ? -1 : 0); };
+  Byte bys1[600];
+  Byte bys2[600];
+  for (int i = 0; i < 600; i++) {
+    bys1[i] = (Byte)(i * 7 + 3);
+  }
+
+  bool bAvx2 = IsBytesCompareAvx2();
+  for (size_t len : {0, 1, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 100, 512}) {
+    memcpy(bys2, bys1, len);
+    BOOST_TEST(BytesCompareSoftware(bys1, bys2, len) == 0);
+    BOOST_TEST(BytesCompareSse2(bys1, bys2, len) == 0);
+    if (bAvx2)
+      BOOST_TEST(BytesCompareAvx2(bys1, bys2, len) == 0);
+    BOOST_TEST(BytesCompare(bys1, len, bys2, len) == 0);
+
+    // Set a difference at every position, the highest bit tests that the
+    // bytes are compared as unsigned and the words do not overflow.
+    for (size_t pos = 0; pos < len; pos++) {
+      for (Byte diff : {(Byte)0x01, (Byte)0x80}) {
+        memcpy(bys2, bys1, len);
+        bys2[pos] ^= diff;
+        int expect = sign(memcmp(bys1, bys2, len));
+        BOOST_TEST(sign(BytesCompareSoftware(bys1, bys2, len)) == expect);
+        BOOST_TEST(sign(BytesCompareSse2(bys1, bys2, len)) == expect);
+        if (bAvx2)
+          BOOST_TEST(sign(BytesCompareAvx2(bys1, bys2, len)) == expect);
+        BOOST_TEST(sign(BytesCompare(bys1, len, bys2, len)) == expect);
+        BOOST_TEST(sign(BytesCompare(bys2, len, bys1, len)) == -expect);
+      }
+    }
+
+    // The same prefix, the shorter is less.
+    memcpy(bys2, bys1, len + 1);
+    BOOST_TEST(BytesCompare(bys1, len, bys2, len + 1) < 0);
+    BOOST_TEST(BytesCompare(bys1, len + 1, bys2, len) > 0);
+  }
+
+  // The difference of the two words is out of int64_t range.
+  Byte big[8] = {0xFF, 0, 0, 0, 0, 0, 0, 0};
+  Byte small[8] = {0x00, 0, 0, 0, 0, 0, 0, 1};
+  BOOST_TEST(BytesCompare(big, 8, small, 8) > 0);
+  BOOST_TEST(BytesCompare(small, 8, big, 8) < 0);
+}
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace storage
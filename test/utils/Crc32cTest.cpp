@@ -0,0 +1,40 @@
+﻿#include "../../src/utils/Crc32c.h"
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <random>
+
+namespace storage {
+BOOST_AUTO_TEST_SUITE(UtilsTest)
+
+BOOST_AUTO_TEST_CASE(Crc32c_test) {
+  const char *str = "123456789";
+  BOOST_TEST(Crc32cSoftware((const Byte *)str, strlen(str)) == 0xE3069283);
+  BOOST_TEST(Crc32c((const Byte *)str, strlen(str)) == 0xE3069283);
+  BOOST_TEST(Crc32c((const Byte *)str, 0) == 0);
+
+  Byte zeros[32] = {0};
+  BOOST_TEST(Crc32c(zeros, sizeof(zeros)) == 0x8A9136AA);
+
+  // Calculate piece by piece
+  uint32_t crc = Crc32c((const Byte *)str, 4);
+  BOOST_TEST(Crc32c((const Byte *)str + 4, 5, crc) == 0xE3069283);
+
+  std::mt19937 rnd(1234);
+  Byte bys[1024];
+  for (size_t i = 0; i < sizeof(bys); i++) {
+    bys[i] = (Byte)rnd();
+  }
+
+  for (uint32_t start = 0; start < 8; start++) {
+    for (uint32_t len = 0; len < 100; len += 7) {
+      uint32_t sw = Crc32cSoftware(bys + start, len);
+      BOOST_TEST(Crc32c(bys + start, len) == sw);
+      if (IsCrc32cHardware()) {
+        BOOST_TEST(Crc32cHardware(bys + start, len) == sw);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage
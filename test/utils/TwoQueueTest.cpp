@@ -0,0 +1,91 @@
+﻿#include "../../src/utils/TwoQueue.h"
+#include <boost/test/unit_test.hpp>
+
+namespace storage {
+BOOST_AUTO_TEST_SUITE(UtilsTest)
+
+struct TestItem {
+  uint64_t _id;
+  bool _bRef = false;
+  bool TestAndClearReferenced() {
+    bool b = _bRef;
+    _bRef = false;
+    return b;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(TwoQueue_test) {
+  const uint64_t CAPACITY = 100;
+  TwoQueue<TestItem *> tq(CAPACITY);
+  MVector<TestItem *> vct;
+  for (uint64_t i = 0; i < 1000; i++) {
+    vct.push_back(new TestItem{i});
+  }
+  MHashSet<TestItem *> setIn;
+  auto funcEvict = [&setIn](TestItem *item) {
+    setIn.erase(item);
+    return true;
+  };
+  auto funcPush = [&](uint64_t id) {
+    if (setIn.insert(vct[id]).second)
+      tq.Push(vct[id], id);
+  };
+
+  // New items only go into probation queue and evicted by FIFO.
+  for (uint64_t i = 0; i < CAPACITY; i++) {
+    funcPush(i);
+  }
+  BOOST_TEST(tq.GetProbationSize() == CAPACITY);
+  BOOST_TEST(tq.Evict(10, funcEvict) == 10);
+  BOOST_TEST(tq.GetGhostSize() == 10);
+  for (uint64_t i = 0; i < 10; i++) {
+    BOOST_TEST(setIn.count(vct[i]) == 0);
+  }
+
+  // Items added again while in ghost queue go into protected queue
+  for (uint64_t i = 0; i < 10; i++) {
+    funcPush(i);
+  }
+  BOOST_TEST(tq.GetProtectedSize() == 10);
+  BOOST_TEST(tq.GetGhostSize() == 0);
+
+  // A large scan can not flush the protected items
+  for (uint64_t i = 100; i < 1000; i++) {
+    funcPush(i);
+    vct[i % 10]->_bRef = true;
+    if (tq.Size() > CAPACITY)
+      tq.Evict(tq.Size() - CAPACITY, funcEvict);
+  }
+  BOOST_TEST(tq.Size() == CAPACITY);
+  for (uint64_t i = 0; i < 10; i++) {
+    BOOST_TEST(setIn.count(vct[i]) == 1);
+  }
+  BOOST_TEST(tq.GetGhostSize() ==
+             CAPACITY * TwoQueue<TestItem *>::GHOST_PERCENT / 100);
+
+  // The items can not be evicted are kept
+  BOOST_TEST(tq.Evict(CAPACITY, [](TestItem *item) { return false; }) == 0);
+  BOOST_TEST(tq.Size() == CAPACITY);
+
+  // The protected items without reference are evicted by CLOCK
+  BOOST_TEST(tq.Evict(CAPACITY, funcEvict) == CAPACITY);
+  BOOST_TEST(tq.Size() == 0);
+  BOOST_TEST(setIn.size() == 0);
+
+  for (uint64_t i = 0; i < 10; i++) {
+    funcPush(i);
+  }
+  BOOST_TEST(tq.RemoveIf([](TestItem *item) { return item->_id % 2 == 0; }) ==
+             5);
+  BOOST_TEST(tq.Size() == 5);
+  tq.Clear();
+  BOOST_TEST(tq.Size() == 0);
+  BOOST_TEST(tq.GetGhostSize() == 0);
+
+  for (TestItem *item : vct) {
+    delete item;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+} // namespace storage